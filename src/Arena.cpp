@@ -0,0 +1,40 @@
+#include "Arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+using namespace Game;
+using namespace std;
+
+ScratchArena::ScratchArena(size_t capacity) : buffer_(new char[capacity]), capacity_(capacity), offset_(){
+    // first touch: the pages end up on the memory node of the calling thread
+    memset(buffer_.get(), 0, capacity_);
+}
+
+void *ScratchArena::allocate(size_t size, size_t alignment){
+    uintptr_t base = reinterpret_cast<uintptr_t>(buffer_.get());
+    uintptr_t aligned = (base + offset_ + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    size_t begin = static_cast<size_t>(aligned - base);
+    if(begin > capacity_ || size > capacity_ - begin){
+        throw bad_alloc{};
+    }
+    offset_ = begin + size;
+    return buffer_.get() + begin;
+}
+
+size_t ScratchArena::used() const{
+    return offset_;
+}
+
+size_t ScratchArena::capacity() const{
+    return capacity_;
+}
+
+void ScratchArena::rewind(size_t offset){
+    offset_ = offset < offset_ ? offset : offset_;
+}
+
+void ScratchArena::reset(){
+    offset_ = 0;
+}
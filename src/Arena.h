@@ -0,0 +1,80 @@
+///
+/// \file contains a bump allocator for short lived scratch memory
+///
+
+#ifndef GAME_ARENA_H
+#define	GAME_ARENA_H
+
+#include <cstddef>
+#include <memory>
+
+namespace Game{
+
+    ///
+    /// \class A fixed size block of memory that hands out allocations by bumping an offset
+    /// Individual allocations are never freed, the arena is rewound to an earlier offset instead.
+    /// The whole block is written once on construction, so its pages are placed on the memory node of the constructing thread.
+    /// This class is not thread safe.
+    ///
+    class ScratchArena{
+    public:
+
+        ///
+        /// Creates a new arena
+        /// \param capacity the size of the block in bytes
+        ///
+        explicit ScratchArena(std::size_t capacity);
+
+        ///
+        /// Allocates uninitialized memory
+        /// \param size the size of the allocation in bytes
+        /// \param alignment the alignment of the allocation, should be a power of two
+        /// \return the allocated memory
+        /// \throw std::bad_alloc if the arena has not enough memory left
+        ///
+        void *allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+        ///
+        /// Allocates uninitialized memory for an array
+        /// \param count the amount of elements
+        /// \return the allocated memory
+        /// \throw std::bad_alloc if the arena has not enough memory left
+        ///
+        template<typename T> T *allocate_array(std::size_t count){
+            return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+        };
+
+        ///
+        /// \return the amount of bytes in use, can be passed to rewind() later
+        ///
+        std::size_t used() const;
+
+        ///
+        /// \return the size of the block in bytes
+        ///
+        std::size_t capacity() const;
+
+        ///
+        /// Releases all allocations made after used() returned the specified offset
+        /// \param offset the offset to return to
+        ///
+        void rewind(std::size_t offset);
+
+        ///
+        /// Releases all allocations
+        ///
+        void reset();
+
+    private:
+        std::unique_ptr<char[]> buffer_;
+        std::size_t capacity_;
+        std::size_t offset_;
+
+        ScratchArena(const ScratchArena &) = delete;
+        ScratchArena &operator=(const ScratchArena &) = delete;
+    };
+
+}
+
+#endif	/* GAME_ARENA_H */
+
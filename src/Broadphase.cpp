@@ -0,0 +1,136 @@
+#include "Broadphase.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace Game;
+using namespace std;
+
+static uint64_t pair_key(uint32_t first, uint32_t second){
+    return first < second ? static_cast<uint64_t>(first) << 32 | second : static_cast<uint64_t>(second) << 32 | first;
+}
+
+SweepAndPrune::SweepAndPrune(Coordinate distance, const AbsolutePosition *anchor) : distance_(distance), anchor_(anchor), slots_(), entries_(), free_slots_(), order_(), pairs_(), previous_pairs_(), events_(){
+    if(distance < Coordinate{}){
+        throw invalid_argument{"the distance of a broadphase should not be negative"};
+    }
+}
+
+void SweepAndPrune::add(MapObject *object){
+    if(slots_.count(object)){
+        throw invalid_argument{"the object was already added to the broadphase"};
+    }
+    Position position = relative_position(*object, anchor_);
+    Entry entry{static_cast<double>(position.x), static_cast<double>(position.y), object};
+    uint32_t slot;
+    if(free_slots_.empty()){
+        slot = static_cast<uint32_t>(entries_.size());
+        entries_.push_back(entry);
+    }else{
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        entries_[slot] = entry;
+    }
+    slots_.emplace(object, slot);
+    // appended at the end, the next sort moves it to its place
+    order_.push_back(slot);
+}
+
+bool SweepAndPrune::remove(MapObject *object){
+    unordered_map<MapObject *, uint32_t>::iterator found = slots_.find(object);
+    if(found == slots_.end()){
+        return false;
+    }
+    uint32_t slot = found->second;
+    slots_.erase(found);
+    order_.erase(find(order_.begin(), order_.end(), slot));
+    // the pairs are forgotten, so a new object in the slot does not inherit them
+    pairs_.erase(std::remove_if(pairs_.begin(), pairs_.end(), [slot](uint64_t key){
+        return static_cast<uint32_t>(key >> 32) == slot || static_cast<uint32_t>(key) == slot;
+    }), pairs_.end());
+    entries_[slot].object = nullptr;
+    free_slots_.push_back(slot);
+    return true;
+}
+
+size_t SweepAndPrune::size() const{
+    return order_.size();
+}
+
+Coordinate SweepAndPrune::distance() const{
+    return distance_;
+}
+
+void SweepAndPrune::sort(){
+    // insertion sort, linear when the order of the previous update is still nearly right
+    for(size_t i = 1; i < order_.size(); ++i){
+        uint32_t slot = order_[i];
+        double x = entries_[slot].x;
+        size_t j = i;
+        for(; j > 0 && entries_[order_[j - 1]].x > x; --j){
+            order_[j] = order_[j - 1];
+        }
+        order_[j] = slot;
+    }
+}
+
+const vector<ProximityEvent> &SweepAndPrune::update(){
+    for(uint32_t slot : order_){
+        Entry &entry = entries_[slot];
+        Position position = relative_position(*entry.object, anchor_);
+        entry.x = static_cast<double>(position.x);
+        entry.y = static_cast<double>(position.y);
+    }
+    sort();
+
+    swap(pairs_, previous_pairs_);
+    pairs_.clear();
+    double distance = static_cast<double>(distance_), limit = distance * distance;
+    for(size_t i = 0; i < order_.size(); ++i){
+        const Entry &entry = entries_[order_[i]];
+        for(size_t j = i + 1; j < order_.size(); ++j){
+            const Entry &other = entries_[order_[j]];
+            double dx = other.x - entry.x;
+            if(dx > distance){
+                break;
+            }
+            double dy = other.y - entry.y;
+            if(dx * dx + dy * dy <= limit){
+                pairs_.push_back(pair_key(order_[i], order_[j]));
+            }
+        }
+    }
+    std::sort(pairs_.begin(), pairs_.end());
+
+    // both lists are sorted, so one merge finds the pairs that started and ended
+    events_.clear();
+    vector<uint64_t>::const_iterator current = pairs_.begin(), previous = previous_pairs_.begin();
+    auto report = [this](ProximityEvent::Type type, uint64_t key){
+        events_.push_back(ProximityEvent{type, entries_[static_cast<uint32_t>(key >> 32)].object, entries_[static_cast<uint32_t>(key)].object});
+    };
+    while(current != pairs_.end() || previous != previous_pairs_.end()){
+        if(previous == previous_pairs_.end() || (current != pairs_.end() && *current < *previous)){
+            report(ProximityEvent::Type::ENTER, *current++);
+        }else if(current == pairs_.end() || *previous < *current){
+            report(ProximityEvent::Type::EXIT, *previous++);
+        }else{
+            ++current;
+            ++previous;
+        }
+    }
+    return events_;
+}
+
+const vector<ProximityEvent> &SweepAndPrune::events() const{
+    return events_;
+}
+
+size_t SweepAndPrune::pair_count() const{
+    return pairs_.size();
+}
+
+void Game::update(FixedThreadPool &pool, const vector<SweepAndPrune *> &broadphases, TaskPriority priority){
+    pool.parallel_for(0, broadphases.size(), [&broadphases](size_t index){
+        broadphases[index]->update();
+    }, 1, priority);
+}
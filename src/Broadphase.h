@@ -0,0 +1,149 @@
+///
+/// \file contains a sort and sweep broadphase that reports map objects coming within a distance of each other
+///
+
+#ifndef GAME_BROADPHASE_H
+#define	GAME_BROADPHASE_H
+
+#include "Object.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+namespace Game{
+
+    ///
+    /// \class A change in the proximity of two map objects
+    ///
+    struct ProximityEvent{
+
+        ///
+        /// the kinds of changes
+        ///
+        enum class Type{
+            ///
+            /// the objects came within the distance of the broadphase
+            ///
+            ENTER,
+
+            ///
+            /// the objects are no longer within the distance of the broadphase
+            ///
+            EXIT
+        };
+
+        ///
+        /// the kind of change
+        ///
+        Type type;
+
+        ///
+        /// one of the objects
+        ///
+        MapObject *first;
+
+        ///
+        /// the other object
+        ///
+        MapObject *second;
+    };
+
+    ///
+    /// \class Finds the pairs of map objects within a distance of each other, e.g. the objects of one star system
+    /// Every update reads the positions, which the orbit update maintains, sorts the objects along the x axis and sweeps over them,
+    /// testing only the objects whose x coordinates are within the distance. The order of the previous update is kept and sorted with
+    /// insertion sort, which takes linear time when the objects moved little. The pairs are compared with those of the previous update
+    /// to report enter and exit events. Separate broadphases can be updated in parallel, see update(FixedThreadPool &, ...).
+    /// A broadphase is not thread safe.
+    ///
+    class SweepAndPrune{
+    public:
+
+        ///
+        /// Creates an empty broadphase
+        /// \param distance the distance at which objects enter and exit, including the distance itself
+        /// \param anchor the anchor of the positions the objects are compared at, nullptr for the origin of the map
+        /// \throw std::invalid_argument if the distance is negative
+        ///
+        SweepAndPrune(Coordinate distance, const AbsolutePosition *anchor = nullptr);
+
+        ///
+        /// Adds an object, its pairs are reported by the next update
+        /// \param object the object, should outlive this broadphase or be removed first
+        /// \throw std::invalid_argument if the object was already added
+        ///
+        void add(MapObject *object);
+
+        ///
+        /// Removes an object, its pairs end without exit events
+        /// \param object the object
+        /// \return true if the object was removed, false if it was not part of this broadphase
+        ///
+        bool remove(MapObject *object);
+
+        ///
+        /// \return the amount of objects
+        ///
+        std::size_t size() const;
+
+        ///
+        /// \return the distance at which objects enter and exit
+        ///
+        Coordinate distance() const;
+
+        ///
+        /// Reads the positions of the objects and finds the pairs within the distance
+        /// \return the events since the previous update, valid until the next update
+        ///
+        const std::vector<ProximityEvent> &update();
+
+        ///
+        /// \return the events of the last update
+        ///
+        const std::vector<ProximityEvent> &events() const;
+
+        ///
+        /// \return the amount of pairs within the distance as of the last update
+        ///
+        std::size_t pair_count() const;
+
+    private:
+
+        struct Entry{
+            double x;
+            double y;
+            MapObject *object;
+        };
+
+        void sort();
+
+        Coordinate distance_;
+        const AbsolutePosition *anchor_;
+        std::unordered_map<MapObject *, std::uint32_t> slots_;
+        // indexed by slot, removed objects leave a null object until the slot is reused
+        std::vector<Entry> entries_;
+        std::vector<std::uint32_t> free_slots_;
+        // the occupied slots ordered by their x coordinates as of the last update
+        std::vector<std::uint32_t> order_;
+        // the pairs of slots within the distance, as sorted keys of the lower and the higher slot
+        std::vector<std::uint64_t> pairs_;
+        std::vector<std::uint64_t> previous_pairs_;
+        std::vector<ProximityEvent> events_;
+    };
+
+    ///
+    /// Updates several broadphases in parallel, one task per broadphase, e.g. one per star system
+    /// Reads the events of each broadphase afterwards with SweepAndPrune::events()
+    /// \param pool the thread pool
+    /// \param broadphases the broadphases, every broadphase should occur once
+    /// \param priority the priority lane of the tasks
+    ///
+    void update(FixedThreadPool &pool, const std::vector<SweepAndPrune *> &broadphases, TaskPriority priority = TaskPriority::FRAME_CRITICAL);
+
+}
+
+#endif	/* GAME_BROADPHASE_H */
+
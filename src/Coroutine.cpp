@@ -0,0 +1,120 @@
+#include "Coroutine.h"
+
+#include <array>
+
+using namespace Game;
+using namespace std;
+
+namespace{
+
+    // frames are handed out in multiples of the granularity, larger frames bypass the free lists
+    const size_t granularity = 64;
+    const size_t size_class_count = 16;
+    const size_t max_free_frames = 64;
+
+    struct FreeFrame{
+        FreeFrame *next;
+    };
+
+    struct FreeLists{
+        FreeLists() : first(), counts(){
+        }
+
+        ~FreeLists(){
+            for(FreeFrame *frame : first){
+                while(frame){
+                    FreeFrame *next = frame->next;
+                    ::operator delete(frame);
+                    frame = next;
+                }
+            }
+        }
+
+        array<FreeFrame *, size_class_count> first;
+        array<size_t, size_class_count> counts;
+    };
+
+    thread_local FreeLists free_lists;
+
+    size_t size_class(size_t size){
+        return (size + granularity - 1) / granularity - 1;
+    }
+
+}
+
+void *CoroutineFrameAllocator::allocate(size_t size){
+    size_t index = size_class(size);
+    if(index >= size_class_count){
+        return ::operator new(size);
+    }
+    FreeFrame *frame = free_lists.first[index];
+    if(frame){
+        free_lists.first[index] = frame->next;
+        --free_lists.counts[index];
+        return frame;
+    }
+    return ::operator new((index + 1) * granularity);
+}
+
+void CoroutineFrameAllocator::deallocate(void *frame, size_t size){
+    size_t index = size_class(size);
+    if(index >= size_class_count || free_lists.counts[index] >= max_free_frames){
+        ::operator delete(frame);
+        return;
+    }
+    FreeFrame *free_frame = static_cast<FreeFrame *>(frame);
+    free_frame->next = free_lists.first[index];
+    free_lists.first[index] = free_frame;
+    ++free_lists.counts[index];
+}
+
+CoroutineDetail::Latch::Latch(size_t count) : count_(count + 1), awaiting_(){
+}
+
+bool CoroutineDetail::Latch::suspend(coroutine_handle<> awaiting){
+    awaiting_ = awaiting;
+    return count_.fetch_sub(1, memory_order_acq_rel) > 1;
+}
+
+coroutine_handle<> CoroutineDetail::Latch::arrive(){
+    if(count_.fetch_sub(1, memory_order_acq_rel) == 1){
+        return awaiting_;
+    }
+    return noop_coroutine();
+}
+
+CoroutineDetail::Arrival::Arrival(coroutine_handle<promise_type> coroutine) : coroutine_(coroutine){
+}
+
+CoroutineDetail::Arrival::Arrival(Arrival &&arrival) : coroutine_(arrival.coroutine_){
+    arrival.coroutine_ = nullptr;
+}
+
+CoroutineDetail::Arrival::~Arrival(){
+    if(coroutine_){
+        coroutine_.destroy();
+    }
+}
+
+void CoroutineDetail::Arrival::start(Latch &latch){
+    coroutine_.promise().latch = &latch;
+    coroutine_.resume();
+}
+
+CoroutineDetail::AllReady::AllReady(vector<Arrival> &&arrivals) : arrivals_(move(arrivals)), latch_(arrivals_.size()){
+}
+
+bool CoroutineDetail::AllReady::await_ready() const noexcept{
+    return arrivals_.empty();
+}
+
+bool CoroutineDetail::AllReady::await_suspend(coroutine_handle<> awaiting){
+    for(Arrival &arrival : arrivals_){
+        arrival.start(latch_);
+    }
+    // if all arrivals finished on this thread, the awaiting coroutine simply continues
+    return latch_.suspend(awaiting);
+}
+
+void CoroutineDetail::AllReady::await_resume() const noexcept{
+}
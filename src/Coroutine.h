@@ -0,0 +1,636 @@
+///
+/// \file contains C++20 coroutines that run on a thread pool and can await futures and each other
+/// Only available when the project is configured with GAME_COROUTINES enabled
+///
+
+#ifndef GAME_COROUTINE_H
+#define	GAME_COROUTINE_H
+
+#ifndef GAME_COROUTINES
+#error "Coroutine.h requires the GAME_COROUTINES build option"
+#endif
+
+#include "Future.h"
+#include "ThreadPool.h"
+
+#include <coroutine>
+#include <cstddef>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <memory>
+#include <new>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace Game{
+
+    template<typename T> class Coroutine;
+
+    ///
+    /// \class Allocates coroutine frames
+    /// By default frames come from free lists per size class that are local to each thread, so starting a coroutine performs no heap allocation in steady state.
+    /// A coroutine can use its own allocator instead by taking std::allocator_arg and the allocator as its first parameters (after the object for member functions).
+    ///
+    class CoroutineFrameAllocator{
+    public:
+
+        ///
+        /// Allocates a frame from the free lists of the calling thread
+        /// \param size the size of the frame in bytes
+        /// \return the frame
+        ///
+        static void *allocate(std::size_t size);
+
+        ///
+        /// Returns a frame to the free lists of the calling thread, which does not need to be the thread that allocated it
+        /// \param frame the frame
+        /// \param size the size of the frame in bytes
+        ///
+        static void deallocate(void *frame, std::size_t size);
+
+        ///
+        /// Allocates a frame that is followed by a record of how to release it
+        /// \param size the size of the frame in bytes
+        /// \return the frame
+        ///
+        static void *allocate_frame(std::size_t size){
+            void *frame = allocate(trailer_offset(size) + sizeof(Release));
+            *trailer(frame, size) = &release_pooled;
+            return frame;
+        };
+
+        ///
+        /// Allocates a frame with an allocator, a copy of the allocator is kept with the frame to release it
+        /// \param size the size of the frame in bytes
+        /// \param allocator the allocator
+        /// \return the frame
+        ///
+        template<typename Allocator> static void *allocate_frame(std::size_t size, const Allocator &allocator){
+            using Bytes = typename std::allocator_traits<Allocator>::template rebind_alloc<std::max_align_t>;
+            Bytes bytes{allocator};
+            std::size_t blocks = block_count<Bytes>(size);
+            void *frame = std::allocator_traits<Bytes>::allocate(bytes, blocks);
+            *trailer(frame, size) = &release_with<Bytes>;
+            new (stored_allocator(frame, size)) Bytes{std::move(bytes)};
+            return frame;
+        };
+
+        ///
+        /// Releases a frame allocated by one of the allocate_frame() functions
+        /// \param frame the frame
+        /// \param size the size of the frame in bytes
+        ///
+        static void deallocate_frame(void *frame, std::size_t size){
+            (*trailer(frame, size))(frame, size);
+        };
+
+    private:
+        using Release = void (*)(void *frame, std::size_t size);
+
+        static std::size_t trailer_offset(std::size_t size){
+            return (size + alignof(Release) - 1) & ~(alignof(Release) - 1);
+        };
+
+        static Release *trailer(void *frame, std::size_t size){
+            return reinterpret_cast<Release *>(static_cast<char *>(frame) + trailer_offset(size));
+        };
+
+        static std::size_t allocator_offset(std::size_t size){
+            return (trailer_offset(size) + sizeof(Release) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+        };
+
+        static void *stored_allocator(void *frame, std::size_t size){
+            return static_cast<char *>(frame) + allocator_offset(size);
+        };
+
+        template<typename Bytes> static std::size_t block_count(std::size_t size){
+            return (allocator_offset(size) + sizeof(Bytes) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        };
+
+        static void release_pooled(void *frame, std::size_t size){
+            deallocate(frame, trailer_offset(size) + sizeof(Release));
+        };
+
+        template<typename Bytes> static void release_with(void *frame, std::size_t size){
+            Bytes *stored = static_cast<Bytes *>(stored_allocator(frame, size));
+            Bytes bytes{std::move(*stored)};
+            stored->~Bytes();
+            std::allocator_traits<Bytes>::deallocate(bytes, static_cast<std::max_align_t *>(frame), block_count<Bytes>(size));
+        };
+    };
+
+    ///
+    /// \class The part of the promise of a coroutine that does not depend on the type of the result
+    ///
+    class CoroutinePromiseBase{
+    public:
+
+        ///
+        /// \class Resumes the awaiting coroutine, if any, once the coroutine has finished
+        ///
+        struct FinalAwaiter{
+            bool await_ready() const noexcept{
+                return false;
+            };
+
+            template<typename Promise> std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coroutine) noexcept{
+                // symmetric transfer: the awaiting coroutine continues without growing the stack
+                std::coroutine_handle<> continuation = coroutine.promise().continuation_;
+                return continuation ? continuation : std::noop_coroutine();
+            };
+
+            void await_resume() const noexcept{
+            };
+        };
+
+        CoroutinePromiseBase() : continuation_(), error_(){
+        };
+
+        ///
+        /// Coroutines are lazy: they only start when they are awaited
+        ///
+        std::suspend_always initial_suspend() const noexcept{
+            return {};
+        };
+
+        FinalAwaiter final_suspend() const noexcept{
+            return {};
+        };
+
+        void unhandled_exception(){
+            error_ = std::current_exception();
+        };
+
+        ///
+        /// \param continuation the coroutine to resume once this coroutine has finished
+        ///
+        void set_continuation(std::coroutine_handle<> continuation){
+            continuation_ = continuation;
+        };
+
+        static void *operator new(std::size_t size){
+            return CoroutineFrameAllocator::allocate_frame(size);
+        };
+
+        template<typename Allocator, typename... Args> static void *operator new(std::size_t size, std::allocator_arg_t, const Allocator &allocator, Args &...){
+            return CoroutineFrameAllocator::allocate_frame(size, allocator);
+        };
+
+        template<typename Self, typename Allocator, typename... Args> static void *operator new(std::size_t size, Self &, std::allocator_arg_t, const Allocator &allocator, Args &...){
+            return CoroutineFrameAllocator::allocate_frame(size, allocator);
+        };
+
+        static void operator delete(void *frame, std::size_t size){
+            CoroutineFrameAllocator::deallocate_frame(frame, size);
+        };
+
+    protected:
+
+        ///
+        /// Rethrows the error that escaped the coroutine, if any
+        ///
+        void rethrow_error() const{
+            if(error_){
+                std::rethrow_exception(error_);
+            }
+        };
+
+    private:
+        std::coroutine_handle<> continuation_;
+        std::exception_ptr error_;
+    };
+
+    ///
+    /// \class The promise of a coroutine with a result
+    ///
+    template<typename T> class CoroutinePromise : public CoroutinePromiseBase{
+    public:
+        CoroutinePromise() : CoroutinePromiseBase(), value_(){
+        };
+
+        Coroutine<T> get_return_object();
+
+        template<typename Value> void return_value(Value &&value){
+            value_.emplace(std::forward<Value>(value));
+        };
+
+        ///
+        /// \return the result of the finished coroutine, moved out of the promise
+        /// \throw the error that escaped the coroutine
+        ///
+        T result(){
+            rethrow_error();
+            return std::move(*value_);
+        };
+
+    private:
+        std::optional<T> value_;
+    };
+
+    ///
+    /// \class The promise of a coroutine without a result
+    ///
+    template<> class CoroutinePromise<void> : public CoroutinePromiseBase{
+    public:
+        Coroutine<void> get_return_object();
+
+        void return_void(){
+        };
+
+        void result(){
+            rethrow_error();
+        };
+    };
+
+    ///
+    /// \class A lazily started coroutine that produces a result of type T
+    /// The coroutine starts when it is awaited and resumes the awaiting coroutine directly when it finishes.
+    /// It runs on the thread that awaits it until it awaits something else, e.g. co_await pool.schedule() moves it to a worker of a pool.
+    /// A coroutine can only be moved and destroys its frame when it goes out of scope.
+    ///
+    template<typename T> class Coroutine{
+    public:
+        using promise_type = CoroutinePromise<T>;
+
+        ///
+        /// \class Starts a coroutine if needed and waits until it has finished
+        ///
+        class ReadyAwaiter{
+        public:
+            explicit ReadyAwaiter(std::coroutine_handle<promise_type> coroutine) : coroutine_(coroutine){
+            };
+
+            bool await_ready() const noexcept{
+                return !coroutine_ || coroutine_.done();
+            };
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept{
+                coroutine_.promise().set_continuation(awaiting);
+                return coroutine_;
+            };
+
+            void await_resume() const noexcept{
+            };
+
+        protected:
+            std::coroutine_handle<promise_type> coroutine_;
+        };
+
+        ///
+        /// \class Starts a coroutine if needed, waits until it has finished and retrieves its result
+        ///
+        class ResultAwaiter : public ReadyAwaiter{
+        public:
+            explicit ResultAwaiter(std::coroutine_handle<promise_type> coroutine) : ReadyAwaiter(coroutine){
+            };
+
+            T await_resume(){
+                if(!this->coroutine_){
+                    throw std::future_error{std::future_errc::no_state};
+                }
+                return this->coroutine_.promise().result();
+            };
+        };
+
+        ///
+        /// Creates a coroutine without a frame
+        ///
+        Coroutine() : coroutine_(){
+        };
+
+        Coroutine(Coroutine &&coroutine) : coroutine_(coroutine.coroutine_){
+            coroutine.coroutine_ = nullptr;
+        };
+
+        Coroutine &operator=(Coroutine &&coroutine){
+            std::swap(coroutine_, coroutine.coroutine_);
+            return *this;
+        };
+
+        ~Coroutine(){
+            if(coroutine_){
+                coroutine_.destroy();
+            }
+        };
+
+        ///
+        /// \return true if this object refers to a coroutine frame
+        ///
+        bool valid() const{
+            return static_cast<bool>(coroutine_);
+        };
+
+        ///
+        /// \return true if the coroutine has finished
+        ///
+        bool done() const{
+            return coroutine_ && coroutine_.done();
+        };
+
+        ///
+        /// \return the result of the finished coroutine, can only be retrieved once
+        /// \throw the error that escaped the coroutine, or std::future_error if there is no coroutine
+        ///
+        T result(){
+            if(!coroutine_){
+                throw std::future_error{std::future_errc::no_state};
+            }
+            return coroutine_.promise().result();
+        };
+
+        ///
+        /// Starts the coroutine if needed and waits until it has finished
+        /// \return the result of the coroutine
+        ///
+        ResultAwaiter operator co_await() noexcept{
+            return ResultAwaiter{coroutine_};
+        };
+
+        ///
+        /// \return an awaitable that waits until the coroutine has finished without retrieving its result or error
+        ///
+        ReadyAwaiter when_ready() noexcept{
+            return ReadyAwaiter{coroutine_};
+        };
+
+    private:
+        explicit Coroutine(std::coroutine_handle<promise_type> coroutine) : coroutine_(coroutine){
+        };
+
+        std::coroutine_handle<promise_type> coroutine_;
+
+        friend class CoroutinePromise<T>;
+
+        Coroutine(const Coroutine &) = delete;
+        Coroutine &operator=(const Coroutine &) = delete;
+    };
+
+    template<typename T> Coroutine<T> CoroutinePromise<T>::get_return_object(){
+        return Coroutine<T>{std::coroutine_handle<CoroutinePromise<T>>::from_promise(*this)};
+    }
+
+    inline Coroutine<void> CoroutinePromise<void>::get_return_object(){
+        return Coroutine<void>{std::coroutine_handle<CoroutinePromise<void>>::from_promise(*this)};
+    }
+
+    ///
+    /// \class Awaits a future, the awaiting coroutine resumes on the thread that stores the value of the future
+    ///
+    template<typename T> class FutureAwaiter{
+    public:
+        explicit FutureAwaiter(Future<T> &&future) : future_(std::move(future)), arrived_(false){
+        };
+
+        bool await_ready() const{
+            return future_.ready();
+        };
+
+        bool await_suspend(std::coroutine_handle<> awaiting){
+            // whoever comes second, the awaiting coroutine or the value, resumes the coroutine
+            future_.on_ready([this, awaiting](){
+                if(arrived_.exchange(true, std::memory_order_acq_rel)){
+                    awaiting.resume();
+                }
+            });
+            return !arrived_.exchange(true, std::memory_order_acq_rel);
+        };
+
+        T await_resume(){
+            return future_.get();
+        };
+
+    private:
+        Future<T> future_;
+        std::atomic<bool> arrived_;
+    };
+
+    ///
+    /// Awaits the value of a future
+    /// \param future the future, it has no state afterwards
+    /// \return an awaitable that produces the value or throws the error of the future
+    ///
+    template<typename T> FutureAwaiter<T> operator co_await(Future<T> &&future){
+        return FutureAwaiter<T>{std::move(future)};
+    }
+
+    namespace CoroutineDetail{
+
+        ///
+        /// \class An eagerly started coroutine that destroys its own frame when it finishes
+        ///
+        struct Detached{
+            struct promise_type : CoroutinePromiseBase{
+                Detached get_return_object(){
+                    return {};
+                };
+
+                std::suspend_never initial_suspend() const noexcept{
+                    return {};
+                };
+
+                std::suspend_never final_suspend() const noexcept{
+                    return {};
+                };
+
+                void return_void(){
+                };
+            };
+        };
+
+        template<typename T> Detached fulfil(Coroutine<T> coroutine, Promise<T> promise){
+            co_await coroutine.when_ready();
+            promise.set_result([&coroutine](){
+                return coroutine.result();
+            });
+        }
+
+        ///
+        /// \class Counts the coroutines that have yet to finish, plus one for the awaiting coroutine
+        ///
+        class Latch{
+        public:
+            explicit Latch(std::size_t count);
+
+            ///
+            /// \param awaiting the coroutine to resume once all coroutines have finished
+            /// \return true if the awaiting coroutine has to suspend since not all coroutines have finished
+            ///
+            bool suspend(std::coroutine_handle<> awaiting);
+
+            ///
+            /// \return the awaiting coroutine if this was the last arrival, otherwise a coroutine that does nothing
+            ///
+            std::coroutine_handle<> arrive();
+
+        private:
+            std::atomic<std::size_t> count_;
+            std::coroutine_handle<> awaiting_;
+        };
+
+        ///
+        /// \class A coroutine that awaits another one and then arrives at a latch
+        ///
+        class Arrival{
+        public:
+            struct promise_type : CoroutinePromiseBase{
+                struct FinalAwaiter{
+                    bool await_ready() const noexcept{
+                        return false;
+                    };
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> coroutine) noexcept{
+                        return coroutine.promise().latch->arrive();
+                    };
+
+                    void await_resume() const noexcept{
+                    };
+                };
+
+                promise_type() : CoroutinePromiseBase(), latch(){
+                };
+
+                Arrival get_return_object(){
+                    return Arrival{std::coroutine_handle<promise_type>::from_promise(*this)};
+                };
+
+                FinalAwaiter final_suspend() const noexcept{
+                    return {};
+                };
+
+                void return_void(){
+                };
+
+                Latch *latch;
+            };
+
+            Arrival(Arrival &&arrival);
+
+            ~Arrival();
+
+            ///
+            /// Starts awaiting on the calling thread
+            /// \param latch the latch to arrive at
+            ///
+            void start(Latch &latch);
+
+        private:
+            explicit Arrival(std::coroutine_handle<promise_type> coroutine);
+
+            std::coroutine_handle<promise_type> coroutine_;
+
+            Arrival(const Arrival &) = delete;
+            Arrival &operator=(const Arrival &) = delete;
+        };
+
+        template<typename T> Arrival arrive_after(Coroutine<T> &coroutine){
+            co_await coroutine.when_ready();
+        }
+
+        ///
+        /// \class Starts all arrivals and resumes the awaiting coroutine once all of them have arrived
+        ///
+        class AllReady{
+        public:
+            explicit AllReady(std::vector<Arrival> &&arrivals);
+
+            bool await_ready() const noexcept;
+
+            bool await_suspend(std::coroutine_handle<> awaiting);
+
+            void await_resume() const noexcept;
+
+        private:
+            std::vector<Arrival> arrivals_;
+            Latch latch_;
+        };
+
+        template<typename T> struct Results{
+            using type = std::vector<T>;
+        };
+
+        template<> struct Results<void>{
+            using type = void;
+        };
+
+        template<typename T> struct Element{
+            using type = T;
+
+            static T result(Coroutine<T> &coroutine){
+                return coroutine.result();
+            };
+        };
+
+        template<> struct Element<void>{
+            using type = std::monostate;
+
+            static std::monostate result(Coroutine<void> &coroutine){
+                coroutine.result();
+                return {};
+            };
+        };
+
+    }
+
+    ///
+    /// Starts a coroutine on the calling thread without awaiting it, e.g. from code that is not a coroutine
+    /// \param coroutine the coroutine
+    /// \return a future for the result of the coroutine
+    ///
+    template<typename T> Future<T> launch(Coroutine<T> coroutine){
+        Promise<T> promise;
+        Future<T> future = promise.future();
+        CoroutineDetail::fulfil(std::move(coroutine), std::move(promise));
+        return future;
+    }
+
+    ///
+    /// Awaits all coroutines
+    /// The coroutines are started one after another on the awaiting thread: coroutines that should run concurrently begin with co_await pool.schedule().
+    /// \param coroutines the coroutines
+    /// \return a coroutine that produces the results in the order of the coroutines, or nothing for coroutines without a result
+    /// \throw the first error of the coroutines in their order, after all of them have finished
+    ///
+    template<typename T> Coroutine<typename CoroutineDetail::Results<T>::type> when_all(std::vector<Coroutine<T>> coroutines){
+        std::vector<CoroutineDetail::Arrival> arrivals;
+        arrivals.reserve(coroutines.size());
+        for(Coroutine<T> &coroutine : coroutines){
+            arrivals.push_back(CoroutineDetail::arrive_after(coroutine));
+        }
+        co_await CoroutineDetail::AllReady{std::move(arrivals)};
+        if constexpr(std::is_void<T>::value){
+            for(Coroutine<T> &coroutine : coroutines){
+                coroutine.result();
+            }
+        }else{
+            std::vector<T> results;
+            results.reserve(coroutines.size());
+            for(Coroutine<T> &coroutine : coroutines){
+                results.push_back(coroutine.result());
+            }
+            co_return results;
+        }
+    }
+
+    ///
+    /// Awaits all coroutines, which can have different result types
+    /// \param coroutines the coroutines
+    /// \return a coroutine that produces a tuple of the results, std::monostate stands in for coroutines without a result
+    /// \throw the first error of the coroutines in their order, after all of them have finished
+    ///
+    template<typename... T> Coroutine<std::tuple<typename CoroutineDetail::Element<T>::type...>> when_all(Coroutine<T>... coroutines){
+        std::vector<CoroutineDetail::Arrival> arrivals;
+        arrivals.reserve(sizeof...(T));
+        (arrivals.push_back(CoroutineDetail::arrive_after(coroutines)), ...);
+        co_await CoroutineDetail::AllReady{std::move(arrivals)};
+        co_return std::tuple<typename CoroutineDetail::Element<T>::type...>{CoroutineDetail::Element<T>::result(coroutines)...};
+    }
+
+}
+
+#endif	/* GAME_COROUTINE_H */
+
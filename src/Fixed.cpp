@@ -0,0 +1,109 @@
+#include "Fixed.h"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace Game;
+using namespace std;
+
+// the polynomials work on Q2.62 numbers, which keeps 30 guard bits below the resolution of Q32.32
+static const int64_t one_q62 = int64_t{1} << 62;
+
+// pi/2 as Q2.62, rounded to nearest
+static const int64_t pi_over_2_q62 = 7244019458077122842;
+
+// the scale factors of Q32.32 and of the angle reduction, a left shift of a negative number is undefined so they multiply instead
+static const __int128 raw_one = static_cast<__int128>(1) << 32;
+static const __int128 q32_to_q62 = static_cast<__int128>(1) << 30;
+
+static int64_t multiply_q62(int64_t first, int64_t second){
+    return static_cast<int64_t>((static_cast<__int128>(first) * second) >> 62);
+}
+
+Fixed::Fixed(double value) : raw_(static_cast<int64_t>(floor(value * 4294967296.0 + 0.5))){
+}
+
+Fixed Fixed::ratio(int64_t numerator, int64_t denominator){
+    if(denominator == 0){
+        throw domain_error{"fixed point division by zero"};
+    }
+    return from_raw(static_cast<int64_t>(static_cast<__int128>(numerator) * raw_one / denominator));
+}
+
+Fixed Fixed::divide(Fixed dividend, Fixed divisor){
+    if(divisor.raw_ == 0){
+        throw domain_error{"fixed point division by zero"};
+    }
+    return from_raw(static_cast<int64_t>(static_cast<__int128>(dividend.raw_) * raw_one / divisor.raw_));
+}
+
+Fixed Game::sqrt(Fixed value){
+    if(value < 0){
+        throw domain_error{"square root of a negative fixed point number"};
+    }
+    // the root of raw * 2^32 is the raw root, calculated bit by bit so it is exact
+    unsigned __int128 remainder = static_cast<unsigned __int128>(value.raw()) << 32;
+    unsigned __int128 root = 0;
+    unsigned __int128 bit = static_cast<unsigned __int128>(1) << 126;
+    while(bit > remainder){
+        bit >>= 2;
+    }
+    while(bit != 0){
+        if(remainder >= root + bit){
+            remainder -= root + bit;
+            root = (root >> 1) + bit;
+        }else{
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return Fixed::from_raw(static_cast<int64_t>(root));
+}
+
+void Game::sincos(Fixed angle, Fixed &sine, Fixed &cosine){
+    // subtract the nearest multiple of pi/2 in 128 bit precision, leaving a remainder in [-pi/4, pi/4]
+    __int128 scaled = angle.raw() * q32_to_q62;
+    __int128 shifted = scaled + pi_over_2_q62 / 2;
+    __int128 quotient = shifted / pi_over_2_q62;
+    if(shifted % pi_over_2_q62 < 0){
+        --quotient;
+    }
+    int64_t r = static_cast<int64_t>(scaled - quotient * pi_over_2_q62);
+    unsigned quadrant = static_cast<unsigned>(quotient & 3);
+
+    // Taylor series in nested form, the first omitted terms are below 2^-45
+    int64_t z = multiply_q62(r, r);
+    int64_t s = one_q62;
+    for(int64_t k = 6; k >= 1; --k){
+        s = one_q62 - multiply_q62(z, s) / (2 * k * (2 * k + 1));
+    }
+    s = multiply_q62(r, s);
+    int64_t c = one_q62;
+    for(int64_t k = 7; k >= 1; --k){
+        c = one_q62 - multiply_q62(z, c) / ((2 * k - 1) * 2 * k);
+    }
+
+    // round from 62 to 32 fraction bits
+    Fixed s32 = Fixed::from_raw((s + (int64_t{1} << 29)) >> 30);
+    Fixed c32 = Fixed::from_raw((c + (int64_t{1} << 29)) >> 30);
+    sine = quadrant & 1 ? c32 : s32;
+    cosine = quadrant & 1 ? s32 : c32;
+    if(quadrant & 2){
+        sine = -sine;
+    }
+    if((quadrant + 1) & 2){
+        cosine = -cosine;
+    }
+}
+
+Fixed Game::sin(Fixed angle){
+    Fixed sine, cosine;
+    sincos(angle, sine, cosine);
+    return sine;
+}
+
+Fixed Game::cos(Fixed angle){
+    Fixed sine, cosine;
+    sincos(angle, sine, cosine);
+    return cosine;
+}
@@ -0,0 +1,190 @@
+///
+/// \file contains a fixed point scalar type for simulations that should give bit identical results on every machine
+///
+
+#ifndef GAME_FIXED_H
+#define	GAME_FIXED_H
+
+#include <cstdint>
+#include <type_traits>
+
+namespace Game{
+
+    ///
+    /// \class A signed Q32.32 fixed point number: 32 integer bits and 32 fraction bits in a 64 bit integer
+    /// Every operation is integer arithmetic with a defined rounding, so results do not depend on the processor, compiler or math library.
+    /// The range is about +-2.1e9 with a resolution of 2.3e-10. Results outside the range wrap around like unsigned integers,
+    /// e.g. the squared norm of a vector longer than 46340 overflows.
+    /// Multiplication rounds to nearest, division truncates toward zero. Requires a compiler with 128 bit integers (GCC or clang).
+    /// Integers convert implicitly, floating point values only explicitly, so a fraction is never truncated silently.
+    ///
+    class Fixed{
+    public:
+
+        ///
+        /// Creates zero
+        ///
+        constexpr Fixed() : raw_(){
+        }
+
+        ///
+        /// Creates an integer value
+        /// \param value the integer, should be within the range
+        ///
+        template<typename Integer, typename std::enable_if<std::is_integral<Integer>::value, int>::type = 0>
+        constexpr Fixed(Integer value) : raw_(static_cast<std::int64_t>(static_cast<std::uint64_t>(value) << 32)){
+        }
+
+        ///
+        /// Converts a floating point value, rounding to the nearest fixed point value
+        /// \param value the value, should be within the range
+        ///
+        explicit Fixed(double value);
+
+        ///
+        /// \param raw the 64 bit representation, i.e. the value multiplied by 2^32
+        /// \return the fixed point number with the representation
+        ///
+        static constexpr Fixed from_raw(std::int64_t raw){
+            return Fixed{Raw{}, raw};
+        }
+
+        ///
+        /// Calculates an exact quotient of integers, e.g. the fraction of an orbit period
+        /// \param numerator the numerator
+        /// \param denominator the denominator
+        /// \return the quotient, truncated toward zero
+        /// \throw std::domain_error if the denominator is zero
+        ///
+        static Fixed ratio(std::int64_t numerator, std::int64_t denominator);
+
+        ///
+        /// \return pi rounded to the nearest fixed point value
+        ///
+        static constexpr Fixed pi(){
+            return from_raw(13493037705);
+        }
+
+        ///
+        /// \return the 64 bit representation, i.e. the value multiplied by 2^32
+        ///
+        constexpr std::int64_t raw() const{
+            return raw_;
+        }
+
+        ///
+        /// \return the value as a double, exact unless the value needs more than 53 significant bits
+        ///
+        explicit operator double() const{
+            return static_cast<double>(raw_) / 4294967296.0;
+        }
+
+        friend Fixed operator+(Fixed first, Fixed second){
+            return from_raw(static_cast<std::int64_t>(static_cast<std::uint64_t>(first.raw_) + static_cast<std::uint64_t>(second.raw_)));
+        }
+
+        friend Fixed operator-(Fixed first, Fixed second){
+            return from_raw(static_cast<std::int64_t>(static_cast<std::uint64_t>(first.raw_) - static_cast<std::uint64_t>(second.raw_)));
+        }
+
+        friend Fixed operator-(Fixed value){
+            return from_raw(static_cast<std::int64_t>(0 - static_cast<std::uint64_t>(value.raw_)));
+        }
+
+        friend Fixed operator*(Fixed first, Fixed second){
+            __int128 product = static_cast<__int128>(first.raw_) * second.raw_;
+            return from_raw(static_cast<std::int64_t>((product + (static_cast<__int128>(1) << 31)) >> 32));
+        }
+
+        ///
+        /// \throw std::domain_error if the divisor is zero
+        ///
+        friend Fixed operator/(Fixed dividend, Fixed divisor){
+            return divide(dividend, divisor);
+        }
+
+        Fixed &operator+=(Fixed value){
+            return *this = *this + value;
+        }
+
+        Fixed &operator-=(Fixed value){
+            return *this = *this - value;
+        }
+
+        Fixed &operator*=(Fixed value){
+            return *this = *this * value;
+        }
+
+        Fixed &operator/=(Fixed value){
+            return *this = *this / value;
+        }
+
+        friend bool operator==(Fixed first, Fixed second){
+            return first.raw_ == second.raw_;
+        }
+
+        friend bool operator!=(Fixed first, Fixed second){
+            return first.raw_ != second.raw_;
+        }
+
+        friend bool operator<(Fixed first, Fixed second){
+            return first.raw_ < second.raw_;
+        }
+
+        friend bool operator<=(Fixed first, Fixed second){
+            return first.raw_ <= second.raw_;
+        }
+
+        friend bool operator>(Fixed first, Fixed second){
+            return first.raw_ > second.raw_;
+        }
+
+        friend bool operator>=(Fixed first, Fixed second){
+            return first.raw_ >= second.raw_;
+        }
+
+    private:
+        struct Raw{};
+
+        constexpr Fixed(Raw, std::int64_t raw) : raw_(raw){
+        }
+
+        static Fixed divide(Fixed dividend, Fixed divisor);
+
+        std::int64_t raw_;
+    };
+
+    static_assert(sizeof(Fixed) == sizeof(std::int64_t) && std::is_standard_layout<Fixed>::value, "the batch kernels treat fixed point arrays as integer arrays");
+
+    ///
+    /// Calculates a square root, rounded down to a multiple of the resolution
+    /// \param value the value
+    /// \return the square root
+    /// \throw std::domain_error if the value is negative
+    ///
+    Fixed sqrt(Fixed value);
+
+    ///
+    /// Calculates the sine and cosine of an angle with integer polynomials, the error is below the resolution for angles up to 1e6
+    /// \param angle the angle in radians
+    /// \param sine receives the sine
+    /// \param cosine receives the cosine
+    ///
+    void sincos(Fixed angle, Fixed &sine, Fixed &cosine);
+
+    ///
+    /// \param angle the angle in radians
+    /// \return the sine, see sincos
+    ///
+    Fixed sin(Fixed angle);
+
+    ///
+    /// \param angle the angle in radians
+    /// \return the cosine, see sincos
+    ///
+    Fixed cos(Fixed angle);
+
+}
+
+#endif	/* GAME_FIXED_H */
+
@@ -0,0 +1,54 @@
+#include "Future.h"
+
+using namespace Game;
+using namespace std;
+
+FutureStateBase::FutureStateBase() : references_(), mutex_(), condition_(), ready_(false), error_(), continuation_(){
+}
+
+FutureStateBase::~FutureStateBase(){
+}
+
+bool FutureStateBase::ready() const{
+    return ready_;
+}
+
+void FutureStateBase::wait(){
+    unique_lock<mutex> lock{mutex_};
+    while(!ready_){
+        condition_.wait(lock);
+    }
+}
+
+exception_ptr FutureStateBase::error() const{
+    lock_guard<mutex> guard{mutex_};
+    return error_;
+}
+
+void FutureStateBase::complete(exception_ptr error){
+    bool has_continuation;
+    {
+        lock_guard<mutex> guard{mutex_};
+        error_ = error;
+        ready_ = true;
+        has_continuation = !continuation_.empty();
+        condition_.notify_all();
+    }
+    if(has_continuation){
+        // no other thread touches the continuation once the state is ready
+        try{
+            continuation_.execute();
+            continuation_.reset();
+        }catch(...){
+            continuation_.reset();
+            throw;
+        }
+    }
+}
+
+void FutureStateBase::reset(){
+    lock_guard<mutex> guard{mutex_};
+    ready_ = false;
+    error_ = nullptr;
+    continuation_.reset();
+}
@@ -0,0 +1,570 @@
+///
+/// \file contains a lightweight future and promise with recycled shared state and continuations
+///
+
+#ifndef GAME_FUTURE_H
+#define	GAME_FUTURE_H
+
+#include "Task.h"
+
+#include <cstddef>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <chrono>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Game{
+
+    template<typename T> class Future;
+
+    template<typename T> class Promise;
+
+    ///
+    /// \class The part of the shared state of a future that does not depend on the type of the value
+    ///
+    class FutureStateBase{
+    public:
+
+        ///
+        /// \return true if a value or an error has been stored
+        ///
+        bool ready() const;
+
+        ///
+        /// Blocks until a value or an error has been stored
+        ///
+        void wait();
+
+        ///
+        /// Blocks until a value or an error has been stored or the timeout expires
+        /// \param timeout the maximum amount of time to wait
+        /// \return true if the state is ready, false otherwise
+        ///
+        template<typename Rep, typename Period> bool wait_for(const std::chrono::duration<Rep, Period> &timeout){
+            std::unique_lock<std::mutex> lock{mutex_};
+            return condition_.wait_for(lock, timeout, [this](){
+                return static_cast<bool>(ready_);
+            });
+        };
+
+        ///
+        /// \return the stored error, or nullptr if a value was stored or the state is not ready
+        ///
+        std::exception_ptr error() const;
+
+        ///
+        /// Registers the callable to run once the state is ready, on the thread that makes it ready
+        /// If the state is already ready, the callable runs immediately on the calling thread
+        /// Only a single continuation can be registered
+        /// \param continuation a callable object with no parameters or return type
+        ///
+        template<typename Continuation> void continue_with(Continuation &&continuation){
+            std::unique_lock<std::mutex> lock{mutex_};
+            if(ready_){
+                lock.unlock();
+                continuation();
+            }else{
+                continuation_.assign(std::forward<Continuation>(continuation));
+            }
+        };
+
+    protected:
+
+        FutureStateBase();
+
+        ~FutureStateBase();
+
+        ///
+        /// Marks the state as ready, releases all waiting threads and runs the continuation
+        /// \param error the error to store, or nullptr if a value was stored
+        ///
+        void complete(std::exception_ptr error);
+
+        ///
+        /// Prepares the state to be reused
+        ///
+        void reset();
+
+        ///
+        /// the amount of futures, promises and continuations referring to this state
+        ///
+        std::atomic<std::size_t> references_;
+
+    private:
+        mutable std::mutex mutex_;
+        std::condition_variable condition_;
+        std::atomic<bool> ready_;
+        std::exception_ptr error_;
+        Task continuation_;
+
+        FutureStateBase(const FutureStateBase &) = delete;
+        FutureStateBase &operator=(const FutureStateBase &) = delete;
+    };
+
+    namespace FuturePolicies{
+
+        ///
+        /// \class Storage for the value of a future
+        ///
+        template<typename T> class Value{
+        public:
+            Value() : storage_(), stored_(false){
+            };
+
+            ~Value(){
+                clear();
+            };
+
+            template<typename... Args> void emplace(Args &&... args){
+                new (&storage_) T(std::forward<Args>(args)...);
+                stored_ = true;
+            };
+
+            T take(){
+                return std::move(*reinterpret_cast<T *>(&storage_));
+            };
+
+            void clear(){
+                if(stored_){
+                    reinterpret_cast<T *>(&storage_)->~T();
+                    stored_ = false;
+                }
+            };
+
+        private:
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+            bool stored_;
+        };
+
+        ///
+        /// \class Storage for the value of a future without a value
+        ///
+        template<> class Value<void>{
+        public:
+            void emplace(){
+            };
+
+            void take(){
+            };
+
+            void clear(){
+            };
+        };
+
+        ///
+        /// \class Passes the value of a future to a function
+        ///
+        template<typename T> struct Invoke{
+            template<typename Antecedent, typename Function> static auto call(Antecedent &future, Function &function) -> decltype(function(std::declval<T>())){
+                return function(future.get());
+            };
+        };
+
+        ///
+        /// \class Calls a function after a future without a value has finished
+        ///
+        template<> struct Invoke<void>{
+            template<typename Antecedent, typename Function> static auto call(Antecedent &future, Function &function) -> decltype(function()){
+                future.get();
+                return function();
+            };
+        };
+
+    }
+
+    ///
+    /// \class The shared state of a future and its promise
+    /// States are recycled through a free list per value type, so creating a future performs no allocation in steady state.
+    ///
+    template<typename T> class FutureState : public FutureStateBase{
+    public:
+
+        ///
+        /// \return a recycled or new state with a single reference
+        ///
+        static FutureState *create(){
+            Pool &free_states = pool();
+            {
+                std::lock_guard<std::mutex> guard{free_states.mutex};
+                FutureState *state = free_states.first;
+                if(state){
+                    free_states.first = state->next_free_;
+                    state->next_free_ = nullptr;
+                    state->references_ = 1;
+                    return state;
+                }
+            }
+            return new FutureState{};
+        };
+
+        ///
+        /// Adds a reference
+        ///
+        void acquire(){
+            ++references_;
+        };
+
+        ///
+        /// Removes a reference, the state is recycled when the last one is removed
+        ///
+        void release(){
+            if(--references_ == 0){
+                value_.clear();
+                reset();
+                Pool &free_states = pool();
+                std::lock_guard<std::mutex> guard{free_states.mutex};
+                next_free_ = free_states.first;
+                free_states.first = this;
+            }
+        };
+
+        ///
+        /// Stores the value and makes the state ready
+        /// \param args the arguments to construct the value with
+        ///
+        template<typename... Args> void set_value(Args &&... args){
+            value_.emplace(std::forward<Args>(args)...);
+            complete(nullptr);
+        };
+
+        ///
+        /// Stores an error and makes the state ready
+        /// \param error the error
+        ///
+        void set_exception(std::exception_ptr error){
+            complete(error);
+        };
+
+        ///
+        /// Moves the value out of the state, should only be called once after the state is ready without an error
+        /// \return the value
+        ///
+        T take(){
+            return value_.take();
+        };
+
+    private:
+
+        struct Pool{
+            Pool() : mutex(), first(){
+            };
+
+            ~Pool(){
+                while(first){
+                    FutureState *state = first;
+                    first = state->next_free_;
+                    delete state;
+                }
+            };
+
+            std::mutex mutex;
+            FutureState *first;
+        };
+
+        static Pool &pool(){
+            static Pool free_states;
+            return free_states;
+        };
+
+        FutureState() : FutureStateBase(), value_(), next_free_(){
+            references_ = 1;
+        };
+
+        FuturePolicies::Value<T> value_;
+        FutureState *next_free_;
+    };
+
+    ///
+    /// \class The receiving end of an asynchronous result
+    /// Futures can only be moved. A value can be retrieved once, with get() or by a continuation registered with then().
+    ///
+    template<typename T> class Future{
+    public:
+
+        ///
+        /// Creates a future without a state
+        ///
+        Future() : state_(){
+        };
+
+        Future(Future &&future) : state_(future.state_){
+            future.state_ = nullptr;
+        };
+
+        Future &operator=(Future &&future){
+            std::swap(state_, future.state_);
+            return *this;
+        };
+
+        ~Future(){
+            if(state_){
+                state_->release();
+            }
+        };
+
+        ///
+        /// \return true if this future refers to a state, i.e. its value has not been retrieved yet
+        ///
+        bool valid() const{
+            return state_ != nullptr;
+        };
+
+        ///
+        /// \return true if a value or an error is available
+        ///
+        bool ready() const{
+            return state_ && state_->ready();
+        };
+
+        ///
+        /// Blocks until a value or an error is available
+        /// \throw std::future_error if the future has no state
+        ///
+        void wait() const{
+            checked_state()->wait();
+        };
+
+        ///
+        /// Blocks until a value or an error is available or the timeout expires
+        /// \param timeout the maximum amount of time to wait
+        /// \return true if the future is ready, false otherwise
+        /// \throw std::future_error if the future has no state
+        ///
+        template<typename Rep, typename Period> bool wait_for(const std::chrono::duration<Rep, Period> &timeout) const{
+            return checked_state()->wait_for(timeout);
+        };
+
+        ///
+        /// Blocks until the value is available and returns it, the future has no state afterwards
+        /// \return the value
+        /// \throw the stored error, or std::future_error if the future has no state
+        ///
+        T get(){
+            FutureState<T> *state = checked_state();
+            state->wait();
+            state_ = nullptr;
+            Reference reference{state};
+            std::exception_ptr error = state->error();
+            if(error){
+                std::rethrow_exception(error);
+            }
+            return state->take();
+        };
+
+        ///
+        /// Registers a callable that runs once a value or an error is available, on the thread that stores it
+        /// If the future is already ready, the callable runs immediately on the calling thread. The future keeps its state, so get() can be called afterwards.
+        /// Only a single callable can be registered per future and it cannot be combined with then()
+        /// \param continuation a callable object with no parameters or return type
+        /// \throw std::future_error if the future has no state
+        ///
+        template<typename Continuation> void on_ready(Continuation &&continuation){
+            checked_state()->continue_with(std::forward<Continuation>(continuation));
+        };
+
+        ///
+        /// Registers a function that is submitted to an executor once the value is available, the future has no state afterwards
+        /// The function receives the value (or nothing if there is no value), its result is available through the returned future.
+        /// If this future holds an error, the function is not called and the error is passed on to the returned future.
+        /// \param executor an object with a submit(callable) member function (e.g. a FixedThreadPool), should outlive the continuation
+        /// \param function the function
+        /// \return a future for the result of the function
+        /// \throw std::future_error if the future has no state
+        ///
+        template<typename Executor, typename Function> auto then(Executor &executor, Function function) -> Future<decltype(FuturePolicies::Invoke<T>::call(std::declval<Future<T> &>(), function))>{
+            using Result = decltype(FuturePolicies::Invoke<T>::call(std::declval<Future<T> &>(), function));
+            FutureState<T> *state = checked_state();
+            Promise<Result> promise;
+            Future<Result> result = promise.future();
+            state->continue_with(Continuation<Executor, Function, Result>{&executor, std::move(*this), std::move(promise), std::move(function)});
+            return result;
+        };
+
+    private:
+
+        // releases a reference when it goes out of scope
+        struct Reference{
+            explicit Reference(FutureState<T> *state_) : state(state_){
+            };
+
+            ~Reference(){
+                state->release();
+            };
+
+            FutureState<T> *state;
+        };
+
+        template<typename Function, typename Result> struct ContinuationTask{
+            Future<T> antecedent;
+            Promise<Result> promise;
+            Function function;
+
+            void operator()(){
+                promise.set_result([this](){
+                    return FuturePolicies::Invoke<T>::call(antecedent, function);
+                });
+            };
+        };
+
+        template<typename Executor, typename Function, typename Result> struct Continuation{
+            Executor *executor;
+            Future<T> antecedent;
+            Promise<Result> promise;
+            Function function;
+
+            void operator()(){
+                // moving the antecedent out breaks the reference cycle between the state and its continuation
+                executor->submit(ContinuationTask<Function, Result>{std::move(antecedent), std::move(promise), std::move(function)});
+            };
+        };
+
+        explicit Future(FutureState<T> *state) : state_(state){
+        };
+
+        FutureState<T> *checked_state() const{
+            if(!state_){
+                throw std::future_error{std::future_errc::no_state};
+            }
+            return state_;
+        };
+
+        FutureState<T> *state_;
+
+        friend class Promise<T>;
+
+        Future(const Future &) = delete;
+        Future &operator=(const Future &) = delete;
+    };
+
+    ///
+    /// \class The sending end of an asynchronous result
+    /// If a promise is destroyed before a value or an error was stored, its future receives a std::future_error (broken_promise).
+    ///
+    template<typename T> class Promise{
+    public:
+
+        ///
+        /// Creates a promise with a recycled or new state
+        ///
+        Promise() : state_(FutureState<T>::create()), future_retrieved_(false){
+        };
+
+        Promise(Promise &&promise) : state_(promise.state_), future_retrieved_(promise.future_retrieved_){
+            promise.state_ = nullptr;
+        };
+
+        Promise &operator=(Promise &&promise){
+            std::swap(state_, promise.state_);
+            std::swap(future_retrieved_, promise.future_retrieved_);
+            return *this;
+        };
+
+        ~Promise(){
+            if(state_){
+                state_->set_exception(std::make_exception_ptr(std::future_error{std::future_errc::broken_promise}));
+                state_->release();
+            }
+        };
+
+        ///
+        /// \return the future for this promise
+        /// \throw std::future_error if the future was already retrieved or the promise has no state
+        ///
+        Future<T> future(){
+            if(!state_){
+                throw std::future_error{std::future_errc::no_state};
+            }
+            if(future_retrieved_){
+                throw std::future_error{std::future_errc::future_already_retrieved};
+            }
+            future_retrieved_ = true;
+            state_->acquire();
+            return Future<T>{state_};
+        };
+
+        ///
+        /// Stores the value and makes the future ready
+        /// \param args the arguments to construct the value with
+        /// \throw std::future_error if a value or error was already stored
+        ///
+        template<typename... Args> void set_value(Args &&... args){
+            FutureState<T> *state = satisfy();
+            try{
+                state->set_value(std::forward<Args>(args)...);
+            }catch(...){
+                // the value could not be constructed: the future receives the error instead
+                if(!state->ready()){
+                    state->set_exception(std::current_exception());
+                }
+                state->release();
+                throw;
+            }
+            state->release();
+        };
+
+        ///
+        /// Stores an error and makes the future ready
+        /// \param error the error
+        /// \throw std::future_error if a value or error was already stored
+        ///
+        void set_exception(std::exception_ptr error){
+            FutureState<T> *state = satisfy();
+            state->set_exception(error);
+            state->release();
+        };
+
+        ///
+        /// Calls the function and stores its result, or the error it throws
+        /// \param function a callable object with no parameters that returns the value
+        ///
+        template<typename Function> void set_result(Function &&function){
+            if(!state_){
+                throw std::future_error{std::future_errc::promise_already_satisfied};
+            }
+            try{
+                store_result(function, std::is_void<T>{});
+            }catch(...){
+                if(state_){
+                    set_exception(std::current_exception());
+                }else{
+                    throw;
+                }
+            }
+        };
+
+    private:
+
+        template<typename Function> void store_result(Function &function, std::true_type){
+            function();
+            set_value();
+        };
+
+        template<typename Function> void store_result(Function &function, std::false_type){
+            set_value(function());
+        };
+
+        FutureState<T> *satisfy(){
+            if(!state_){
+                throw std::future_error{std::future_errc::promise_already_satisfied};
+            }
+            FutureState<T> *state = state_;
+            state_ = nullptr;
+            return state;
+        };
+
+        FutureState<T> *state_;
+        bool future_retrieved_;
+
+        Promise(const Promise &) = delete;
+        Promise &operator=(const Promise &) = delete;
+    };
+
+}
+
+#endif	/* GAME_FUTURE_H */
+
@@ -1,4 +1,6 @@
 #include "Metrics.h"
+#include "Fixed.h"
+#include "Simd.h"
 
 using namespace Game;
 using namespace std;
@@ -7,4 +9,221 @@ GeometryError::GeometryError(const std::string& message) : runtime_error(message
 
 ZeroVectorError::ZeroVectorError(const std::string& message) : GeometryError(message){}
 
-ZeroVectorError::ZeroVectorError() : GeometryError("invalid operation on a zero vector"){}
\ No newline at end of file
+ZeroVectorError::ZeroVectorError() : GeometryError("invalid operation on a zero vector"){}
+// the kernels read both coordinates of a vector before writing any, so they work in place;
+// separate x and y arrays let the compiler process a full vector register of positions per iteration
+// double and Fixed coordinates use the instruction set specific kernels selected in Simd.cpp instead
+
+static const int64_t *raw(const Fixed *values){
+    return reinterpret_cast<const int64_t *>(values);
+}
+
+static int64_t *raw(Fixed *values){
+    return reinterpret_cast<int64_t *>(values);
+}
+
+template<typename Scalar> static void transform_vectors(const Scalar *coefficients, const Scalar *x, const Scalar *y, Scalar *result_x, Scalar *result_y, size_t count){
+    const Scalar a = coefficients[0], b = coefficients[1], c = coefficients[2];
+    const Scalar d = coefficients[3], e = coefficients[4], f = coefficients[5];
+    for(size_t i = 0; i < count; ++i){
+        Scalar vx = x[i];
+        Scalar vy = y[i];
+        result_x[i] = a * vx + b * vy + c;
+        result_y[i] = d * vx + e * vy + f;
+    }
+}
+
+static void transform_vectors(const double *coefficients, const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    GeometryKernels::active().transform(coefficients, x, y, result_x, result_y, count);
+}
+
+static void transform_vectors(const Fixed *coefficients, const Fixed *x, const Fixed *y, Fixed *result_x, Fixed *result_y, size_t count){
+    FixedKernels::active().transform(raw(coefficients), raw(x), raw(y), raw(result_x), raw(result_y), count);
+}
+
+template<typename Scalar> static void distance_squared_vectors(const Scalar *x, const Scalar *y, Scalar point_x, Scalar point_y, Scalar *result, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        Scalar dx = x[i] - point_x;
+        Scalar dy = y[i] - point_y;
+        result[i] = dx * dx + dy * dy;
+    }
+}
+
+static void distance_squared_vectors(const double *x, const double *y, double point_x, double point_y, double *result, size_t count){
+    GeometryKernels::active().distance_squared(x, y, point_x, point_y, result, count);
+}
+
+static void distance_squared_vectors(const Fixed *x, const Fixed *y, Fixed point_x, Fixed point_y, Fixed *result, size_t count){
+    FixedKernels::active().distance_squared(raw(x), raw(y), point_x.raw(), point_y.raw(), raw(result), count);
+}
+
+template<typename Scalar> static void norm_vectors(const Scalar *x, const Scalar *y, Scalar *result, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        result[i] = sqrt(x[i] * x[i] + y[i] * y[i]);
+    }
+}
+
+static void norm_vectors(const double *x, const double *y, double *result, size_t count){
+    GeometryKernels::active().norm(x, y, result, count);
+}
+
+template<typename Scalar> static bool normalize_vectors(const Scalar *x, const Scalar *y, Scalar *result_x, Scalar *result_y, size_t count){
+    bool valid = true;
+    for(size_t i = 0; i < count; ++i){
+        Scalar vx = x[i];
+        Scalar vy = y[i];
+        Scalar norm = sqrt(vx * vx + vy * vy);
+        bool zero = norm == 0;
+        valid &= !zero;
+        // fixed point division by zero throws, the result for a zero vector is unspecified anyway
+        Scalar divisor = zero ? Scalar{1} : norm;
+        result_x[i] = vx / divisor;
+        result_y[i] = vy / divisor;
+    }
+    return valid;
+}
+
+static bool normalize_vectors(const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    return GeometryKernels::active().normalize(x, y, result_x, result_y, count);
+}
+
+template<typename Scalar> static void dot_vectors(const Scalar *first_x, const Scalar *first_y, const Scalar *second_x, const Scalar *second_y, Scalar *result, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        result[i] = first_x[i] * second_x[i] + first_y[i] * second_y[i];
+    }
+}
+
+static void dot_vectors(const double *first_x, const double *first_y, const double *second_x, const double *second_y, double *result, size_t count){
+    GeometryKernels::active().dot(first_x, first_y, second_x, second_y, result, count);
+}
+
+static void dot_vectors(const Fixed *first_x, const Fixed *first_y, const Fixed *second_x, const Fixed *second_y, Fixed *result, size_t count){
+    FixedKernels::active().dot(raw(first_x), raw(first_y), raw(second_x), raw(second_y), raw(result), count);
+}
+
+template<typename Scalar> static void dot_vector(const Scalar *x, const Scalar *y, Scalar vector_x, Scalar vector_y, Scalar *result, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        result[i] = x[i] * vector_x + y[i] * vector_y;
+    }
+}
+
+static void dot_vector(const double *x, const double *y, double vector_x, double vector_y, double *result, size_t count){
+    GeometryKernels::active().dot_vector(x, y, vector_x, vector_y, result, count);
+}
+
+static void dot_vector(const Fixed *x, const Fixed *y, Fixed vector_x, Fixed vector_y, Fixed *result, size_t count){
+    FixedKernels::active().dot_vector(raw(x), raw(y), vector_x.raw(), vector_y.raw(), raw(result), count);
+}
+
+template<typename Scalar> static void sincos_values(const Scalar *angles, Scalar *sines, Scalar *cosines, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        Scalar angle = angles[i];
+        sines[i] = sin(angle);
+        cosines[i] = cos(angle);
+    }
+}
+
+static void sincos_values(const double *angles, double *sines, double *cosines, size_t count){
+    GeometryKernels::active().sincos(angles, sines, cosines, count);
+}
+
+static void sincos_values(const Fixed *angles, Fixed *sines, Fixed *cosines, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        sincos(angles[i], sines[i], cosines[i]);
+    }
+}
+
+template<typename Scalar> static array<Scalar, 6> coefficients(const Transform2<Scalar> &transform){
+    return array<Scalar, 6>{{transform[0], transform[1], transform[2], transform[3], transform[4], transform[5]}};
+}
+
+template<typename Scalar> void Game::transform(const Transform2<Scalar> &transform, const PositionBuffer<Scalar> &vectors, PositionBuffer<Scalar> &result){
+    array<Scalar, 6> values = coefficients(transform);
+    if(&vectors == &result){
+        transform_vectors(values.data(), result.x(), result.y(), result.x(), result.y(), result.size());
+    }else{
+        result.resize(vectors.size());
+        transform_vectors(values.data(), vectors.x(), vectors.y(), result.x(), result.y(), vectors.size());
+    }
+}
+
+template<typename Scalar> void Game::transform(const Transform2<Scalar> &transform, PositionBuffer<Scalar> &vectors){
+    array<Scalar, 6> values = coefficients(transform);
+    transform_vectors(values.data(), vectors.x(), vectors.y(), vectors.x(), vectors.y(), vectors.size());
+}
+
+template<typename Scalar> void Game::norm_squared(const PositionBuffer<Scalar> &vectors, vector<Scalar> &result){
+    result.resize(vectors.size());
+    distance_squared_vectors(vectors.x(), vectors.y(), Scalar{}, Scalar{}, result.data(), vectors.size());
+}
+
+template<typename Scalar> void Game::norm(const PositionBuffer<Scalar> &vectors, vector<Scalar> &result){
+    result.resize(vectors.size());
+    norm_vectors(vectors.x(), vectors.y(), result.data(), vectors.size());
+}
+
+template<typename Scalar> void Game::normalize(const PositionBuffer<Scalar> &vectors, PositionBuffer<Scalar> &result){
+    if(&vectors != &result){
+        result.resize(vectors.size());
+    }
+    if(!normalize_vectors(vectors.x(), vectors.y(), result.x(), result.y(), vectors.size())){
+        throw ZeroVectorError{};
+    }
+}
+
+template<typename Scalar> void Game::distance_squared(const PositionBuffer<Scalar> &vectors, const Vector2<Scalar> &point, vector<Scalar> &result){
+    result.resize(vectors.size());
+    distance_squared_vectors(vectors.x(), vectors.y(), point.x, point.y, result.data(), vectors.size());
+}
+
+template<typename Scalar> void Game::dot(const PositionBuffer<Scalar> &first, const PositionBuffer<Scalar> &second, vector<Scalar> &result){
+    if(first.size() != second.size()){
+        throw GeometryError{"dot operation on buffers of different sizes"};
+    }
+    result.resize(first.size());
+    dot_vectors(first.x(), first.y(), second.x(), second.y(), result.data(), first.size());
+}
+
+template<typename Scalar> void Game::dot(const PositionBuffer<Scalar> &vectors, const Vector2<Scalar> &vector, std::vector<Scalar> &result){
+    result.resize(vectors.size());
+    dot_vector(vectors.x(), vectors.y(), vector.x, vector.y, result.data(), vectors.size());
+}
+
+template<typename Scalar> void Game::sincos(const vector<Scalar> &angles, vector<Scalar> &sines, vector<Scalar> &cosines){
+    size_t count = angles.size();
+    sines.resize(count);
+    cosines.resize(count);
+    sincos_values(angles.data(), sines.data(), cosines.data(), count);
+}
+
+void Game::sincos(double angle, double &sine, double &cosine){
+    sincos_values(&angle, &sine, &cosine, 1);
+}
+
+template void Game::transform(const Transform2<float> &, const PositionBuffer<float> &, PositionBuffer<float> &);
+template void Game::transform(const Transform2<double> &, const PositionBuffer<double> &, PositionBuffer<double> &);
+template void Game::transform(const Transform2<Fixed> &, const PositionBuffer<Fixed> &, PositionBuffer<Fixed> &);
+template void Game::transform(const Transform2<float> &, PositionBuffer<float> &);
+template void Game::transform(const Transform2<double> &, PositionBuffer<double> &);
+template void Game::transform(const Transform2<Fixed> &, PositionBuffer<Fixed> &);
+template void Game::norm_squared(const PositionBuffer<float> &, vector<float> &);
+template void Game::norm_squared(const PositionBuffer<double> &, vector<double> &);
+template void Game::norm_squared(const PositionBuffer<Fixed> &, vector<Fixed> &);
+template void Game::norm(const PositionBuffer<float> &, vector<float> &);
+template void Game::norm(const PositionBuffer<double> &, vector<double> &);
+template void Game::norm(const PositionBuffer<Fixed> &, vector<Fixed> &);
+template void Game::normalize(const PositionBuffer<float> &, PositionBuffer<float> &);
+template void Game::normalize(const PositionBuffer<double> &, PositionBuffer<double> &);
+template void Game::normalize(const PositionBuffer<Fixed> &, PositionBuffer<Fixed> &);
+template void Game::distance_squared(const PositionBuffer<float> &, const Vector2<float> &, vector<float> &);
+template void Game::distance_squared(const PositionBuffer<double> &, const Vector2<double> &, vector<double> &);
+template void Game::distance_squared(const PositionBuffer<Fixed> &, const Vector2<Fixed> &, vector<Fixed> &);
+template void Game::dot(const PositionBuffer<float> &, const PositionBuffer<float> &, vector<float> &);
+template void Game::dot(const PositionBuffer<double> &, const PositionBuffer<double> &, vector<double> &);
+template void Game::dot(const PositionBuffer<Fixed> &, const PositionBuffer<Fixed> &, vector<Fixed> &);
+template void Game::dot(const PositionBuffer<float> &, const Vector2<float> &, vector<float> &);
+template void Game::dot(const PositionBuffer<double> &, const Vector2<double> &, vector<double> &);
+template void Game::dot(const PositionBuffer<Fixed> &, const Vector2<Fixed> &, vector<Fixed> &);
+template void Game::sincos(const vector<float> &, vector<float> &, vector<float> &);
+template void Game::sincos(const vector<double> &, vector<double> &, vector<double> &);
+template void Game::sincos(const vector<Fixed> &, vector<Fixed> &, vector<Fixed> &);
@@ -9,6 +9,10 @@
 #include <string>
 #include <stdexcept>
 #include <array>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include <cstddef>
 
 namespace Game {
 
@@ -60,6 +64,14 @@ namespace Game {
         Vector2(Scalar x_, Scalar y_) : x(x_), y(y_) {
         };
 
+        ///
+        /// Converts a vector with another coordinate type, rounding if the other type is more precise
+        /// \param vector the vector to convert
+        ///
+
+        template<typename Other> explicit Vector2(const Vector2<Other> &vector) : x(static_cast<Scalar>(vector.x)), y(static_cast<Scalar>(vector.y)) {
+        };
+
         ///
         /// Calculates the square of the norm of this vector
         /// \return the square of the norm of this vector
@@ -75,6 +87,8 @@ namespace Game {
         ///
 
         Scalar norm() const {
+            // scalar types of the game, like Fixed, provide their own sqrt
+            using std::sqrt;
             return sqrt(normSquared());
         };
 
@@ -150,7 +164,9 @@ namespace Game {
         
         using Coordinate = typename std::array<Scalar, 6>::size_type;
         
-        Transform2(std::initializer_list<Scalar> values) : values_(values){};
+        Transform2(std::initializer_list<Scalar> values) : values_(){
+            std::copy(values.begin(), values.begin() + std::min(values.size(), values_.size()), values_.begin());
+        };
         
         Transform2() : values_{Scalar{1}, Scalar{}, Scalar{}, Scalar{}, Scalar{1}, Scalar{}}{};
 
@@ -167,7 +183,9 @@ namespace Game {
         };
         
         static Transform2<Scalar> create_rotation(Scalar theta){
-            return Transform2<Scalar>{std::cos(theta), std::sin(theta), std::cos(theta), -std::sin(theta),  Scalar{}, Scalar{}};
+            using std::cos;
+            using std::sin;
+            return Transform2<Scalar>{cos(theta), -sin(theta), Scalar{}, sin(theta), cos(theta), Scalar{}};
         };
         
         static Transform2<Scalar> create_rotation(Scalar px, Scalar py, Scalar theta){
@@ -185,15 +203,15 @@ namespace Game {
         };
         
         Transform2<Scalar> &concatenate(const Transform2<Scalar> &t){
-            //(A + t) * (B + v) = (AB) + (B*t) + v
+            //t is applied after this transformation: B(Av + a) + b = (BA)v + (Ba + b)
             
             std::array<Scalar,6> new_values;
-            new_values[0] = values_[0]*t.values_[0] + values_[1] * t.values_[3];
-            new_values[1] = values_[0]*t.values_[1] + values_[1] * t.values_[4];
-            new_values[2] = t.values_[0]*values_[2] + t.values_[1]*values_[5] + t.values_[3];
+            new_values[0] = t.values_[0]*values_[0] + t.values_[1] * values_[3];
+            new_values[1] = t.values_[0]*values_[1] + t.values_[1] * values_[4];
+            new_values[2] = t.values_[0]*values_[2] + t.values_[1]*values_[5] + t.values_[2];
             
-            new_values[3] = values_[3]*t.values_[0] + values_[4] * t.values_[3];
-            new_values[4] = values_[3]*t.values_[1] + values_[4] * t.values_[4];
+            new_values[3] = t.values_[3]*values_[0] + t.values_[4] * values_[3];
+            new_values[4] = t.values_[3]*values_[1] + t.values_[4] * values_[4];
             new_values[5] = t.values_[3]*values_[2] + t.values_[4]*values_[5] + t.values_[5];
             
             std::swap(values_, new_values);
@@ -336,6 +354,230 @@ namespace Game {
         }
     };
     
+    ///
+    /// \class stores many two dimensional vectors as a structure of arrays
+    /// The x and y coordinates live in separate contiguous arrays, so the batch functions below process
+    /// several positions per instruction where a loop over Vector2 objects handles them one at a time.
+    /// The batch functions are compiled in Metrics.cpp for float, double and Fixed coordinates. With double and Fixed coordinates they use
+    /// SSE2, AVX2 or AVX-512 as selected in Simd.h and produce bit identical results to the Vector2 and Transform2 functions.
+    ///
+
+    template<typename Scalar_> class PositionBuffer {
+    public:
+        ///
+        /// the type of the coordinates
+        ///
+        using Scalar = Scalar_;
+
+        ///
+        /// Creates an empty buffer
+        ///
+
+        PositionBuffer() : x_(), y_() {
+        };
+
+        ///
+        /// Creates a buffer with the specified amount of zero vectors
+        /// \param size the amount of vectors
+        ///
+
+        explicit PositionBuffer(std::size_t size) : x_(size), y_(size) {
+        };
+
+        ///
+        /// \return the amount of vectors
+        ///
+
+        std::size_t size() const {
+            return x_.size();
+        };
+
+        ///
+        /// \return true if the buffer holds no vectors
+        ///
+
+        bool empty() const {
+            return x_.empty();
+        };
+
+        ///
+        /// Changes the amount of vectors, new vectors are zero vectors
+        /// \param size the new amount of vectors
+        ///
+
+        void resize(std::size_t size) {
+            x_.resize(size);
+            y_.resize(size);
+        };
+
+        ///
+        /// Reserves memory for the specified amount of vectors
+        /// \param capacity the amount of vectors
+        ///
+
+        void reserve(std::size_t capacity) {
+            x_.reserve(capacity);
+            y_.reserve(capacity);
+        };
+
+        ///
+        /// Removes all vectors
+        ///
+
+        void clear() {
+            x_.clear();
+            y_.clear();
+        };
+
+        ///
+        /// Appends a vector
+        /// \param vector the vector
+        ///
+
+        void push_back(const Vector2<Scalar> &vector) {
+            x_.push_back(vector.x);
+            y_.push_back(vector.y);
+        };
+
+        ///
+        /// \param index the index of a vector
+        /// \return the vector
+        ///
+
+        Vector2<Scalar> get(std::size_t index) const {
+            return Vector2<Scalar>{x_[index], y_[index]};
+        };
+
+        ///
+        /// Replaces a vector
+        /// \param index the index of the vector
+        /// \param vector the new vector
+        ///
+
+        void set(std::size_t index, const Vector2<Scalar> &vector) {
+            x_[index] = vector.x;
+            y_[index] = vector.y;
+        };
+
+        ///
+        /// \return the coordinates along the x-axis
+        ///
+
+        Scalar *x() {
+            return x_.data();
+        };
+
+        const Scalar *x() const {
+            return x_.data();
+        };
+
+        ///
+        /// \return the coordinates along the y-axis
+        ///
+
+        Scalar *y() {
+            return y_.data();
+        };
+
+        const Scalar *y() const {
+            return y_.data();
+        };
+
+    private:
+        std::vector<Scalar> x_;
+        std::vector<Scalar> y_;
+    };
+
+    ///
+    /// Applies a transformation to every vector of a buffer
+    /// \param transform the transformation
+    /// \param vectors the vectors
+    /// \param result receives the transformed vectors, may be the same buffer as vectors
+    ///
+
+    template<typename Scalar> void transform(const Transform2<Scalar> &transform, const PositionBuffer<Scalar> &vectors, PositionBuffer<Scalar> &result);
+
+    ///
+    /// Applies a transformation to every vector of a buffer in place
+    /// \param transform the transformation
+    /// \param vectors the vectors
+    ///
+
+    template<typename Scalar> void transform(const Transform2<Scalar> &transform, PositionBuffer<Scalar> &vectors);
+
+    ///
+    /// Calculates the square of the norm of every vector of a buffer
+    /// \param vectors the vectors
+    /// \param result receives the squared norms, in the order of the vectors
+    ///
+
+    template<typename Scalar> void norm_squared(const PositionBuffer<Scalar> &vectors, std::vector<Scalar> &result);
+
+    ///
+    /// Calculates the norm of every vector of a buffer
+    /// \param vectors the vectors
+    /// \param result receives the norms, in the order of the vectors
+    ///
+
+    template<typename Scalar> void norm(const PositionBuffer<Scalar> &vectors, std::vector<Scalar> &result);
+
+    ///
+    /// Normalizes every vector of a buffer
+    /// \param vectors the vectors
+    /// \param result receives the normalized vectors, may be the same buffer as vectors
+    /// \throw ZeroVectorError if one of the vectors is a zero vector, the contents of result are unspecified in that case
+    ///
+
+    template<typename Scalar> void normalize(const PositionBuffer<Scalar> &vectors, PositionBuffer<Scalar> &result);
+
+    ///
+    /// Calculates the square of the distance between every vector of a buffer and a point
+    /// \param vectors the vectors
+    /// \param point the point
+    /// \param result receives the squared distances, in the order of the vectors
+    ///
+
+    template<typename Scalar> void distance_squared(const PositionBuffer<Scalar> &vectors, const Vector2<Scalar> &point, std::vector<Scalar> &result);
+
+    ///
+    /// Performs a dot operation on every pair of vectors with the same index
+    /// \param first the first vectors
+    /// \param second the second vectors, should have as many vectors as first
+    /// \param result receives the scalar results
+    /// \throw GeometryError if the buffers have different sizes
+    ///
+
+    template<typename Scalar> void dot(const PositionBuffer<Scalar> &first, const PositionBuffer<Scalar> &second, std::vector<Scalar> &result);
+
+    ///
+    /// Performs a dot operation of every vector of a buffer with a single vector
+    /// \param vectors the vectors
+    /// \param vector the vector
+    /// \param result receives the scalar results
+    ///
+
+    template<typename Scalar> void dot(const PositionBuffer<Scalar> &vectors, const Vector2<Scalar> &vector, std::vector<Scalar> &result);
+
+    ///
+    /// Calculates the sine and cosine of every angle
+    /// With double coordinates the angles are range reduced and evaluated in vector registers with an absolute error below 2e-16,
+    /// the results are the same as those of the single angle sincos function
+    /// \param angles the angles in radians
+    /// \param sines receives the sines, may be the same vector as angles
+    /// \param cosines receives the cosines, may be the same vector as angles
+    ///
+
+    template<typename Scalar> void sincos(const std::vector<Scalar> &angles, std::vector<Scalar> &sines, std::vector<Scalar> &cosines);
+
+    ///
+    /// Calculates the sine and cosine of a single angle, with the same results as the batch sincos function
+    /// \param angle the angle in radians
+    /// \param sine receives the sine
+    /// \param cosine receives the cosine
+    ///
+
+    void sincos(double angle, double &sine, double &cosine);
+
     ///
     /// Makes the compiler calculate the mathematical constant of pi.
     /// \return 3.14...
@@ -1,4 +1,5 @@
 #include "Object.h"
+#include "SpatialGrid.h"
 
 using namespace Game;
 using namespace std;
@@ -57,11 +58,25 @@ bool Object::operator!=(const Object& o) const {
 }
 
 
-MapObject::MapObject() : position_(){
+MapObject::MapObject() : position_(), anchor_(), grid_(), grid_cell_(), grid_slot_(){
 }
 
-MapObject::~MapObject() {
+MapObject::MapObject(const MapObject &object) : position_(object.position_), anchor_(object.anchor_), grid_(), grid_cell_(), grid_slot_(){
+}
 
+MapObject &MapObject::operator=(const MapObject &object) {
+    position_ = object.position_;
+    anchor_ = object.anchor_;
+    if(grid_){
+        grid_->moved(*this);
+    }
+    return *this;
+}
+
+MapObject::~MapObject() {
+    if(grid_){
+        grid_->remove(this);
+    }
 }
 
 const Position& MapObject::position() const {
@@ -70,6 +85,33 @@ const Position& MapObject::position() const {
 
 void MapObject::position(const Position& position) {
     position_ = position;
+    if(grid_){
+        grid_->moved(*this);
+    }
+}
+
+const AbsolutePosition *MapObject::anchor() const {
+    return anchor_;
+}
+
+void MapObject::anchor(const AbsolutePosition *anchor) {
+    anchor_ = anchor;
+    if(grid_){
+        grid_->moved(*this);
+    }
+}
+
+AbsolutePosition MapObject::absolute_position() const {
+    AbsolutePosition position{position_};
+    return anchor_ ? *anchor_ + position : position;
+}
+
+Position Game::relative_position(const MapObject &object, const AbsolutePosition *anchor) {
+    if(object.anchor() == anchor){
+        return object.position();
+    }
+    AbsolutePosition position = object.absolute_position();
+    return Position{anchor ? position - *anchor : position};
 }
 
 
@@ -6,22 +6,48 @@
 #define	GAME_OBJECT_H
 
 #include "Metrics.h"
+#include "Fixed.h"
 
+#include <cstdint>
 #include <string>
 #include <chrono>
 
 namespace Game {
 
     ///
-    /// a scalar type to use for distance measurements
+    /// a scalar type to use for distance measurements relative to an anchor
+    /// With GAME_FLOAT_COORDINATES it is float, which halves the memory traffic and doubles the SIMD width,
+    /// while the double anchors keep the precision across a galaxy.
+    /// With GAME_FIXED_COORDINATES it is Fixed, so the orbits give bit identical results on every machine, e.g. for replays.
     ///
+#if defined(GAME_FIXED_COORDINATES)
+    using Coordinate = Fixed;
+#elif defined(GAME_FLOAT_COORDINATES)
+    using Coordinate = float;
+#else
     using Coordinate = double;
+#endif
 
     ///
-    /// a two dimensional vector to model the position on a plane
+    /// a scalar type for angles, which grow with the game time and keep double precision unless the coordinates are fixed point
+    ///
+#ifdef GAME_FIXED_COORDINATES
+    using Angle = Fixed;
+#else
+    using Angle = double;
+#endif
+
+    ///
+    /// a two dimensional vector to model the position on a plane, relative to an anchor
     ///
     using Position = Vector2<Coordinate>;
 
+    ///
+    /// a two dimensional vector to model a position relative to the origin of the map, always in double precision
+    /// Star systems use one as the anchor of the positions of their objects
+    ///
+    using AbsolutePosition = Vector2<double>;
+
     ///
     /// a type for unique identifiers of game objects
     ///
@@ -144,12 +170,31 @@ namespace Game {
         ObjectId id_;
     };
 
+    class SpatialGrid;
+    class GridMoveLog;
+
     ///
     /// an object represented on the map
     ///
     class MapObject {
     public:
 
+        ///
+        /// copies the position and anchor, the copy is not indexed by a spatial grid
+        /// \param object the object to copy
+        ///
+        MapObject(const MapObject &object);
+
+        ///
+        /// copies the position and anchor, the membership in a spatial grid stays the same
+        /// \param object the object to copy
+        /// \return this object
+        ///
+        MapObject &operator=(const MapObject &object);
+
+        ///
+        /// destroys this object and removes it from its spatial grid
+        ///
         virtual ~MapObject();
 
         ///
@@ -158,10 +203,26 @@ namespace Game {
         const Position &position() const;
 
         ///
-        /// \param position the object's new position on the map
+        /// \param position the object's new position on the map, a spatial grid indexing this object is updated
         ///
         void position(const Position &position);
 
+        ///
+        /// \return the anchor the position is relative to, nullptr for the origin of the map
+        ///
+        const AbsolutePosition *anchor() const;
+
+        ///
+        /// Changes the anchor, the relative position stays the same
+        /// \param anchor the new anchor, nullptr for the origin of the map, should outlive this object
+        ///
+        void anchor(const AbsolutePosition *anchor);
+
+        ///
+        /// \return the position relative to the origin of the map
+        ///
+        AbsolutePosition absolute_position() const;
+
     protected:
         
         ///
@@ -171,8 +232,24 @@ namespace Game {
 
     private:
         Position position_;
+        const AbsolutePosition *anchor_;
+        // the grid indexing this object and the location of its entry there
+        SpatialGrid *grid_;
+        std::uint32_t grid_cell_;
+        std::uint32_t grid_slot_;
+
+        friend class SpatialGrid;
+        friend class GridMoveLog;
     };
 
+    ///
+    /// Calculates the position of an object relative to an anchor
+    /// \param object the object
+    /// \param anchor the anchor, nullptr for the origin of the map
+    /// \return the position, calculated in double precision unless the object already uses the anchor
+    ///
+    Position relative_position(const MapObject &object, const AbsolutePosition *anchor);
+
 }
 
 #endif	/* OBJECT_H */
@@ -2,11 +2,92 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <utility>
 
 using namespace Game;
 using namespace std;
 
-OrbitalObject::OrbitalObject(MapObject* object)  : orbit_(), object_(object){
+// a root has no orbit, so it may have been moved through its map object
+static void follow_object(GravityWell *root) {
+    const Position &position = root->object()->position();
+    Transform2<Coordinate> local = root->local_transform();
+    if(position.x != local[2] || position.y != local[5]){
+        root->local_offset(position);
+    }
+}
+
+// how many satellites ahead the updates fetch the objects
+static const size_t prefetch_distance = 16;
+
+// the origin of the frame of a gravity well, in the frame of the anchor of one of its satellites
+static Position origin_of(const Transform2<Coordinate> &outer, const MapObject &parent, const MapObject &object) {
+    if(parent.anchor() != object.anchor()){
+        // the parent transform is relative to another anchor, its origin is moved into the frame of this object
+        return relative_position(parent, object.anchor());
+    }
+    return Position{outer[2], outer[5]};
+}
+
+// the translation of compose(), which is all a satellite needs to be positioned
+static Position place(const Transform2<Coordinate> &outer, const Position &offset, const Position &origin) {
+    return Position{outer[0]*offset.x + outer[1]*offset.y + origin.x, outer[3]*offset.x + outer[4]*offset.y + origin.y};
+}
+
+// the same operations as concatenating with the parent transform, without copying either
+static void compose(const Transform2<Coordinate> &outer, const Transform2<Coordinate> &local, const Position &origin, Transform2<Coordinate> &world) {
+    world[0] = outer[0]*local[0] + outer[1]*local[3];
+    world[1] = outer[0]*local[1] + outer[1]*local[4];
+    world[2] = outer[0]*local[2] + outer[1]*local[5] + origin.x;
+    world[3] = outer[3]*local[0] + outer[4]*local[3];
+    world[4] = outer[3]*local[1] + outer[4]*local[4];
+    world[5] = outer[3]*local[2] + outer[4]*local[5] + origin.y;
+}
+
+Bounds::Bounds() : minimum(numeric_limits<double>::infinity(), numeric_limits<double>::infinity()), maximum(-numeric_limits<double>::infinity(), -numeric_limits<double>::infinity()){
+}
+
+Bounds::Bounds(const AbsolutePosition &minimum, const AbsolutePosition &maximum) : minimum(minimum), maximum(maximum){
+}
+
+Bounds Bounds::around(const AbsolutePosition &center, double radius) {
+    return Bounds{AbsolutePosition{center.x - radius, center.y - radius}, AbsolutePosition{center.x + radius, center.y + radius}};
+}
+
+bool Bounds::empty() const {
+    return !(minimum.x <= maximum.x && minimum.y <= maximum.y);
+}
+
+bool Bounds::contains(const AbsolutePosition &position) const {
+    return position.x >= minimum.x && position.x <= maximum.x && position.y >= minimum.y && position.y <= maximum.y;
+}
+
+bool Bounds::intersects(const Bounds &bounds) const {
+    return bounds.maximum.x >= minimum.x && bounds.minimum.x <= maximum.x && bounds.maximum.y >= minimum.y && bounds.minimum.y <= maximum.y;
+}
+
+double Bounds::distance_squared(const AbsolutePosition &position) const {
+    double dx = max(max(minimum.x - position.x, position.x - maximum.x), 0.0);
+    double dy = max(max(minimum.y - position.y, position.y - maximum.y), 0.0);
+    return dx * dx + dy * dy;
+}
+
+void Bounds::expand(const Bounds &bounds) {
+    minimum.x = min(minimum.x, bounds.minimum.x);
+    minimum.y = min(minimum.y, bounds.minimum.y);
+    maximum.x = max(maximum.x, bounds.maximum.x);
+    maximum.y = max(maximum.y, bounds.maximum.y);
+}
+
+bool Bounds::operator==(const Bounds &bounds) const {
+    return minimum == bounds.minimum && maximum == bounds.maximum;
+}
+
+bool Bounds::operator!=(const Bounds &bounds) const {
+    return !(*this == bounds);
+}
+
+OrbitalObject::OrbitalObject(MapObject* object)  : orbit_(), object_(object), offset_(), linear_(), transform_dirty_(true){
 }
 
 MapObject* OrbitalObject::object() const {
@@ -20,23 +101,350 @@ Orbit* OrbitalObject::orbit() const {
     return orbit_;
 }
 
-GravityWell::GravityWell(MapObject* object) : OrbitalObject(object), radius(), orbits_(){
+Transform2<Coordinate> OrbitalObject::local_transform() const {
+    if(!linear_){
+        return Transform2<Coordinate>{Coordinate{1}, Coordinate{}, offset_.x, Coordinate{}, Coordinate{1}, offset_.y};
+    }
+    return Transform2<Coordinate>{linear_[0], linear_[1], offset_.x, linear_[2], linear_[3], offset_.y};
+}
+
+void OrbitalObject::local_transform(const Transform2<Coordinate> &transform) {
+    if(transform[0] == Coordinate{1} && transform[1] == Coordinate{} && transform[3] == Coordinate{} && transform[4] == Coordinate{1}){
+        linear_.reset();
+    }else{
+        if(!linear_){
+            linear_.reset(new Coordinate[4]);
+        }
+        linear_[0] = transform[0];
+        linear_[1] = transform[1];
+        linear_[2] = transform[3];
+        linear_[3] = transform[4];
+    }
+    offset_ = Position{transform[2], transform[5]};
+    mark_dirty();
+}
+
+void OrbitalObject::local_offset(const Position &offset) {
+    offset_ = offset;
+    mark_dirty();
+}
+
+void OrbitalObject::mark_dirty() {
+    transform_dirty_ = true;
+    if(orbit_){
+        mark_path(orbit_->parent());
+    }
+}
+
+void OrbitalObject::mark_path(GravityWell *well) {
+    // the marks form paths from the root, so the first marked ancestor ends the walk
+    for(; well && !well->dirty_satellites_; well = well->orbit_ ? well->orbit_->parent() : nullptr){
+        well->dirty_satellites_ = true;
+    }
+}
+
+Transform2<Coordinate> OrbitalObject::world_transform() const {
+    if(const GravityWell *well = gravity_well()){
+        return well->world_transform_;
+    }
+    Transform2<Coordinate> local = local_transform();
+    if(!orbit_){
+        return local;
+    }
+    const GravityWell *parent = orbit_->parent();
+    Transform2<Coordinate> world;
+    compose(parent->world_transform_, local, origin_of(parent->world_transform_, *parent->object(), *object_), world);
+    return world;
+}
+
+bool OrbitalObject::transform_dirty() const {
+    return transform_dirty_;
+}
+
+Bounds OrbitalObject::bounds() const {
+    AbsolutePosition position = object_->absolute_position();
+    return Bounds{position, position};
+}
+
+GravityWell *OrbitalObject::gravity_well() {
+    return nullptr;
+}
+
+const GravityWell *OrbitalObject::gravity_well() const {
+    return nullptr;
+}
+
+Position OrbitalObject::world_position() const {
+    if(!orbit_){
+        return offset_;
+    }
+    const GravityWell *parent = orbit_->parent();
+    return place(parent->world_transform_, offset_, origin_of(parent->world_transform_, *parent->object(), *object_));
+}
+
+bool OrbitalObject::update_position(bool parent_changed) {
+    if(!transform_dirty_ && !parent_changed){
+        return false;
+    }
+    object_->position(world_position());
+    transform_dirty_ = false;
+    return true;
+}
+
+bool OrbitalObject::propagate_transforms(bool parent_changed) {
+    return update_position(parent_changed);
+}
+
+bool OrbitalObject::advance(Duration current, bool parent_changed) {
+    update(current);
+    return update_position(parent_changed);
+}
+
+OrbitalObject::~OrbitalObject() {
+}
+
+GravityWell::GravityWell(MapObject* object) : OrbitalObject(object), radius(), orbits_(), active_orbits_(), circular_orbits_(), paused_(), dirty_satellites_(), bounds_(), revision_(),
+        world_transform_(){
 }
 
 const std::vector<Orbit*> &GravityWell::orbits() const {
     return orbits_;
 }
 
+bool GravityWell::paused() const {
+    return paused_;
+}
+
+void GravityWell::paused(bool paused) {
+    if(paused != paused_){
+        paused_ = paused;
+        revise(this);
+    }
+}
+
+void GravityWell::revise(GravityWell *well) {
+    for(; well; well = well->orbit() ? well->orbit()->parent() : nullptr){
+        ++well->revision_;
+    }
+}
+
 void GravityWell::update(Duration current) {
+    if(!orbit()){
+        follow_object(this);
+    }
+    advance(current, false);
+}
+
+void GravityWell::update_transforms() {
+    if(!orbit()){
+        follow_object(this);
+    }
+    propagate_transforms(false);
+}
+
+bool GravityWell::update_world_transform(bool parent_changed) {
+    if(!transform_dirty_ && !parent_changed){
+        return false;
+    }
+    Transform2<Coordinate> local = local_transform();
+    if(orbit_){
+        const GravityWell *parent = orbit_->parent();
+        compose(parent->world_transform_, local, origin_of(parent->world_transform_, *parent->object(), *object_), world_transform_);
+    }else{
+        world_transform_ = local;
+    }
+    object_->position(Position{world_transform_[2], world_transform_[5]});
+    transform_dirty_ = false;
+    return true;
+}
+
+inline AbsolutePosition GravityWell::position_satellite(OrbitalObject *satellite, const AbsolutePosition *own_anchor) const {
+    MapObject *object = satellite->object_;
+    const AbsolutePosition *anchor = object->anchor();
+    Position origin = anchor == own_anchor ? Position{world_transform_[2], world_transform_[5]} : relative_position(*object_, anchor);
+    Position position = place(world_transform_, satellite->offset_, origin);
+    object->position(position);
+    satellite->transform_dirty_ = false;
+    // the same as MapObject::absolute_position(), without reading the object again
+    AbsolutePosition absolute{position};
+    return anchor ? *anchor + absolute : absolute;
+}
+
+bool GravityWell::propagate_transforms(bool parent_changed) {
+    return propagate_satellites(update_world_transform(parent_changed));
+}
+
+bool GravityWell::advance(Duration current, bool parent_changed) {
+    bool changed = update_world_transform(parent_changed);
+    if(paused_){
+        return propagate_satellites(changed);
+    }
+    // unless something was marked or this gravity well moved, the stationary satellites keep their positions
+    bool everything = changed || dirty_satellites_, moved = false;
+    // the marks of the satellites end here, they are all positioned below
+    dirty_satellites_ = true;
+    // the offsets of the moving orbits are set without marks, like a change of the parent they make the satellite move below;
+    // the circular ones are taken from the batch while their satellites are visited, the batched orbits are in the same order here
+    circular_orbits_.evaluate(current);
+    size_t batched = 0;
+    const AbsolutePosition *anchor = object_->anchor();
+    // when every satellite is visited the bounds are refit on the way, while the satellites are still in the cache
+    Bounds bounds = own_bounds();
+    const vector<Orbit *> &orbits = everything ? orbits_ : active_orbits_;
+    for(size_t i = 0; i < orbits.size(); ++i){
+        // the orbits, their satellites and the map objects are fetched ahead in turn, each one needs the one before
+        if(i + 3 * prefetch_distance < orbits.size()){
+            __builtin_prefetch(orbits[i + 3 * prefetch_distance]);
+        }
+        if(i + 2 * prefetch_distance < orbits.size()){
+            __builtin_prefetch(orbits[i + 2 * prefetch_distance]->child_, 1);
+        }
+        if(i + prefetch_distance < orbits.size()){
+            __builtin_prefetch(orbits[i + prefetch_distance]->child_->object_, 1);
+        }
+        Orbit *orbit = orbits[i];
+        OrbitalObject *child = orbit->child_;
+        if(orbit->batched_){
+            child->offset_ = circular_orbits_.offset(batched++);
+        }else if(!orbit->stationary_){
+            child->offset_ = orbit->calculate_offset(current);
+        }
+        if(orbit->well_){
+            if(child->advance(current, changed || !orbit->stationary_)){
+                moved = true;
+            }
+            if(everything){
+                bounds.expand(child->bounds());
+            }
+            continue;
+        }
+        // any other satellite is positioned here, which saves the calls of advance() for most of the tree
+        child->update(current);
+        if(changed || !orbit->stationary_ || child->transform_dirty_){
+            AbsolutePosition position = position_satellite(child, anchor);
+            moved = true;
+            if(everything){
+                bounds.expand(Bounds{position, position});
+            }
+        }else if(everything){
+            bounds.expand(child->bounds());
+        }
+    }
+    dirty_satellites_ = false;
+    if(everything){
+        return fit_bounds(bounds);
+    }
+    return moved && refit_bounds();
+}
+
+bool GravityWell::propagate_satellites(bool changed) {
+    if(!changed && !dirty_satellites_){
+        return false;
+    }
+    dirty_satellites_ = false;
+    for(Orbit *orbit : orbits_){
+        orbit->child_->propagate_transforms(changed);
+    }
+    return refit_bounds();
+}
+
+Bounds GravityWell::own_bounds() const {
+    return Bounds::around(object()->absolute_position(), static_cast<double>(radius));
+}
+
+bool GravityWell::refit_bounds() {
+    Bounds bounds = own_bounds();
+    for(Orbit *orbit : orbits_){
+        bounds.expand(orbit->child_->bounds());
+    }
+    return fit_bounds(bounds);
+}
+
+bool GravityWell::fit_bounds(const Bounds &bounds) {
+    if(bounds == bounds_){
+        return false;
+    }
+    bounds_ = bounds;
+    return true;
+}
+
+Bounds GravityWell::bounds() const {
+    return bounds_;
+}
+
+GravityWell *GravityWell::gravity_well() {
+    return this;
+}
+
+const GravityWell *GravityWell::gravity_well() const {
+    return this;
+}
+
+template<typename Prune, typename Accept> void GravityWell::collect(Prune prune, Accept accept, vector<OrbitalObject *> &result) const {
+    if(accept(object()->absolute_position(), static_cast<double>(radius))){
+        result.push_back(const_cast<GravityWell *>(this));
+    }
     for(Orbit *orbit : orbits_){
-        orbit->update(current);
+        OrbitalObject *child = orbit->child_;
+        Bounds bounds = child->bounds();
+        if(!prune(bounds)){
+            continue;
+        }
+        if(const GravityWell *well = child->gravity_well()){
+            well->collect(prune, accept, result);
+        }else if(accept(bounds.minimum, 0.0)){
+            result.push_back(child);
+        }
+    }
+}
+
+void GravityWell::inside(const Bounds &area, vector<OrbitalObject *> &result) const {
+    result.clear();
+    if(!area.intersects(bounds_)){
+        return;
     }
+    collect([&](const Bounds &bounds){
+        return area.intersects(bounds);
+    }, [&](const AbsolutePosition &center, double object_radius){
+        return area.distance_squared(center) <= object_radius * object_radius;
+    }, result);
 }
 
+void GravityWell::within(const AbsolutePosition &center, double radius, vector<OrbitalObject *> &result) const {
+    result.clear();
+    if(bounds_.distance_squared(center) > radius * radius){
+        return;
+    }
+    collect([&](const Bounds &bounds){
+        return bounds.distance_squared(center) <= radius * radius;
+    }, [&](const AbsolutePosition &position, double object_radius){
+        return (position - center).norm() <= radius + object_radius;
+    }, result);
+}
+
+OrbitalObject *GravityWell::pick(const AbsolutePosition &position, double tolerance) const {
+    vector<OrbitalObject *> candidates;
+    if(bounds_.distance_squared(position) > tolerance * tolerance){
+        return nullptr;
+    }
+    // every accepted object is nearer than the ones before, so the last one is the nearest
+    double best = tolerance;
+    collect([&](const Bounds &bounds){
+        return bounds.distance_squared(position) <= best * best;
+    }, [&](const AbsolutePosition &center, double object_radius){
+        double distance = max((center - position).norm() - object_radius, 0.0);
+        if(distance > best || (distance == best && !candidates.empty())){
+            return false;
+        }
+        best = distance;
+        return true;
+    }, candidates);
+    return candidates.empty() ? nullptr : candidates.back();
+}
 
 GravityWell::~GravityWell() {}
 
-Orbit::Orbit() : parent_(), child_(){
+Orbit::Orbit() : parent_(), child_(), batched_(), stationary_(), well_(){
 }
 
 OrbitalObject* Orbit::child() const {
@@ -48,10 +456,20 @@ GravityWell* Orbit::parent() const {
 }
 
 void Orbit::update(Duration current) {
-    child_->object()->position(calculate_position(current));
+    if(!stationary()){
+        child_->local_offset(calculate_offset(current));
+    }
     child_->update(current);
 }
 
+bool Orbit::stationary() const {
+    return false;
+}
+
+CircularOrbit *Orbit::circular() {
+    return nullptr;
+}
+
 void Orbit::detach() {
     Game::detach(this);
 }
@@ -64,31 +482,343 @@ void Game::attach(GravityWell* parent, OrbitalObject* child, Orbit* orbit) {
     orbit->child_ = child;
     parent->orbits_.push_back(orbit);
     child->orbit_ = orbit;
+    child->local_offset(orbit->calculate_offset(Duration::zero()));
+    orbit->stationary_ = orbit->stationary();
+    orbit->well_ = child->gravity_well() != nullptr;
+    if(!orbit->stationary_ || orbit->well_){
+        parent->active_orbits_.push_back(orbit);
+    }
+    // a circular orbit that claims to be stationary is not batched, every batched orbit is then visited by each update of its parent
+    CircularOrbit *circular = orbit->stationary_ ? nullptr : orbit->circular();
+    if(circular){
+        parent->circular_orbits_.add(circular);
+        orbit->batched_ = true;
+    }
+    GravityWell::revise(parent);
 }
 
 void Game::detach(Orbit *orbit){
+    // the bounds of the parent shrink at the next transform update
+    OrbitalObject::mark_path(orbit->parent_);
+    GravityWell::revise(orbit->parent_);
     vector<Orbit *> &orbits = orbit->parent_->orbits_;
     orbits.erase(find(orbits.begin(), orbits.end(), orbit));
+    vector<Orbit *> &active_orbits = orbit->parent_->active_orbits_;
+    vector<Orbit *>::iterator active = find(active_orbits.begin(), active_orbits.end(), orbit);
+    if(active != active_orbits.end()){
+        active_orbits.erase(active);
+    }
+    if(orbit->batched_){
+        orbit->parent_->circular_orbits_.remove(static_cast<CircularOrbit *>(orbit));
+        orbit->batched_ = false;
+    }
     orbit->child_->orbit_ = nullptr;
     orbit->parent_ = nullptr;
     orbit->child_ = nullptr;
 }
 
-StaticOrbit::StaticOrbit(const Position& relative_position) : relative_position_(){
+StaticOrbit::StaticOrbit(const Position& relative_position) : relative_position_(relative_position){
+}
+
+Position StaticOrbit::calculate_offset(Duration) {
+    return relative_position_;
+}
+
+bool StaticOrbit::stationary() const {
+    return true;
+}
+
+CircularOrbit::CircularOrbit(Coordinate radius, Duration period, Coordinate phase) : radius_(radius), phase_(phase), period_(period){
+}
+
+Position CircularOrbit::calculate_offset(Duration current) {
+    Angle sine, cosine;
+    sincos(angle(current), sine, cosine);
+    return Position{static_cast<Coordinate>(cosine)*radius_, static_cast<Coordinate>(sine)*radius_};
+}
+
+CircularOrbit *CircularOrbit::circular() {
+    return this;
 }
 
-Position StaticOrbit::calculate_position(Duration current) {
-    return parent_->object()->position() + relative_position_;
+Angle CircularOrbit::angle(Duration current) const {
+    return angle(phase_, period_, current);
 }
 
-CircularOrbit::CircularOrbit(Coordinate radius, Duration period, Coordinate phase) : radius_(radius), period_(period), phase_(phase){
+Angle CircularOrbit::angle(Coordinate phase, Duration period, Duration current) {
+#ifdef GAME_FIXED_COORDINATES
+    // the angle advances by pi per period, whole turns are removed with integers so the angle stays exact in long games
+    Duration half_turns = current % (period * 2);
+    return phase + Fixed::pi() * Fixed::ratio(half_turns.count(), period.count());
+#else
+    return phase + (pi() * current / period);
+#endif
 }
 
-Position CircularOrbit::calculate_position(Duration current) {
-    using namespace std::chrono;
-    duration<double> current_duration = current % period_;
-    double theta = phase_ + (pi() * current / period_);
-    Position parent_pos = parent_->object()->position();
-    return Position{parent_pos.x+cos(theta)*radius_, parent_pos.y+sin(theta)*radius_};
+CircularOrbitBatch::CircularOrbitBatch() : orbits_(), satellites_(), radii_(), phases_(), periods_(), angles_(), sines_(), cosines_(){
 }
 
+void CircularOrbitBatch::add(CircularOrbit *orbit){
+    orbits_.push_back(orbit);
+    satellites_.push_back(orbit->child_);
+    radii_.push_back(orbit->radius_);
+    phases_.push_back(orbit->phase_);
+    periods_.push_back(orbit->period_);
+}
+
+bool CircularOrbitBatch::remove(CircularOrbit *orbit){
+    auto found = find(orbits_.begin(), orbits_.end(), orbit);
+    if(found == orbits_.end()){
+        return false;
+    }else{
+        ptrdiff_t index = found - orbits_.begin();
+        orbits_.erase(found);
+        satellites_.erase(satellites_.begin() + index);
+        radii_.erase(radii_.begin() + index);
+        phases_.erase(phases_.begin() + index);
+        periods_.erase(periods_.begin() + index);
+        return true;
+    }
+}
+
+void CircularOrbitBatch::clear(){
+    orbits_.clear();
+    satellites_.clear();
+    radii_.clear();
+    phases_.clear();
+    periods_.clear();
+}
+
+const vector<CircularOrbit *> &CircularOrbitBatch::orbits() const{
+    return orbits_;
+}
+
+void CircularOrbitBatch::update(Duration current){
+    evaluate(current);
+    for(size_t i = 0; i < orbits_.size(); ++i){
+        satellites_[i]->offset_ = offset(i);
+    }
+}
+
+void CircularOrbitBatch::evaluate(Duration current){
+    angles_.resize(orbits_.size());
+    for(size_t i = 0; i < orbits_.size(); ++i){
+        angles_[i] = CircularOrbit::angle(phases_[i], periods_[i], current);
+    }
+    sincos(angles_, sines_, cosines_);
+}
+
+inline Position CircularOrbitBatch::offset(size_t index) const{
+    Coordinate cosine = static_cast<Coordinate>(cosines_[index]), sine = static_cast<Coordinate>(sines_[index]);
+    return Position{cosine*radii_[index], sine*radii_[index]};
+}
+
+FlatOrbitTree::FlatOrbitTree(GravityWell *root) : root_(root), revision_(), rebuilt_(), objects_(), wells_(), well_entries_(), well_parents_(), groups_(), moved_(), totals_(),
+        satellites_(), custom_orbits_(), radii_(), phases_(), periods_(), angles_(), sines_(), cosines_(){
+    rebuild();
+}
+
+GravityWell *FlatOrbitTree::root() const {
+    return root_;
+}
+
+bool FlatOrbitTree::outdated() const {
+    return revision_ != root_->revision_;
+}
+
+const vector<OrbitalObject *> &FlatOrbitTree::objects() const {
+    return objects_;
+}
+
+void FlatOrbitTree::rebuild() {
+    objects_.clear();
+    wells_.clear();
+    well_entries_.clear();
+    well_parents_.clear();
+    satellites_.clear();
+    custom_orbits_.clear();
+    radii_.clear();
+    phases_.clear();
+    periods_.clear();
+    // depth first, so the satellites follow their gravity well closely; pending orbits keep the index of the gravity well of their parent
+    vector<pair<Orbit *, uint32_t>> pending;
+    auto add_well = [&](GravityWell *well, uint32_t parent, const Entry &entry){
+        uint32_t index = static_cast<uint32_t>(wells_.size());
+        wells_.push_back(well);
+        well_entries_.push_back(entry);
+        well_parents_.push_back(parent);
+        for(vector<Orbit *>::const_reverse_iterator orbit = well->orbits_.rbegin(); orbit != well->orbits_.rend(); ++orbit){
+            pending.emplace_back(*orbit, index);
+        }
+    };
+    add_well(root_, 0, Entry{root_, 0, Source::ROOT});
+    // the gravity wells below a paused one, including itself
+    vector<bool> paused;
+    // the other satellites in the order they are found, with the range they go to: twice the index of their gravity well, plus one if they do not move
+    vector<pair<uint32_t, Entry>> found;
+    while(!pending.empty()){
+        Orbit *orbit = pending.back().first;
+        uint32_t parent = pending.back().second;
+        pending.pop_back();
+        paused.resize(wells_.size());
+        paused[parent] = paused[parent] || wells_[parent]->paused_ || (parent > 0 && paused[well_parents_[parent]]);
+        Entry entry{orbit->child_, 0, Source::STATIONARY};
+        if(paused[parent]){
+            entry.source = Source::PAUSED;
+        }else if(orbit->batched_){
+            entry.source = Source::CIRCULAR;
+            entry.orbit = static_cast<uint32_t>(radii_.size());
+            const CircularOrbit *circular = static_cast<const CircularOrbit *>(orbit);
+            radii_.push_back(circular->radius_);
+            phases_.push_back(circular->phase_);
+            periods_.push_back(circular->period_);
+        }else if(!orbit->stationary_){
+            entry.source = Source::CUSTOM;
+            entry.orbit = static_cast<uint32_t>(custom_orbits_.size());
+            custom_orbits_.push_back(orbit);
+        }
+        if(GravityWell *well = orbit->child_->gravity_well()){
+            add_well(well, parent, entry);
+        }else{
+            bool moving = entry.source == Source::CIRCULAR || entry.source == Source::CUSTOM;
+            found.emplace_back(2 * parent + (moving ? 0 : 1), entry);
+        }
+    }
+    // sorted by range, keeping the order they were found in
+    vector<uint32_t> starts(2 * wells_.size() + 1);
+    for(const pair<uint32_t, Entry> &satellite : found){
+        ++starts[satellite.first + 1];
+    }
+    for(size_t i = 1; i < starts.size(); ++i){
+        starts[i] += starts[i - 1];
+    }
+    groups_.resize(wells_.size());
+    for(size_t i = 0; i < wells_.size(); ++i){
+        groups_[i] = Group{starts[2 * i], starts[2 * i + 1], starts[2 * i + 2], Bounds{}};
+    }
+    satellites_.resize(found.size(), Entry{nullptr, 0, Source::STATIONARY});
+    for(const pair<uint32_t, Entry> &satellite : found){
+        satellites_[starts[satellite.first]++] = satellite.second;
+    }
+    objects_.insert(objects_.end(), wells_.begin(), wells_.end());
+    for(const Entry &satellite : satellites_){
+        objects_.push_back(satellite.object);
+    }
+    moved_.resize(wells_.size());
+    totals_.resize(wells_.size());
+    revision_ = root_->revision_;
+    rebuilt_ = true;
+}
+
+bool FlatOrbitTree::move(const Entry &entry, OrbitalObject *object, Duration current) {
+    if(entry.source == Source::CIRCULAR){
+        Coordinate cosine = static_cast<Coordinate>(cosines_[entry.orbit]), sine = static_cast<Coordinate>(sines_[entry.orbit]);
+        object->offset_ = Position{cosine*radii_[entry.orbit], sine*radii_[entry.orbit]};
+        return true;
+    }else if(entry.source == Source::CUSTOM){
+        object->offset_ = custom_orbits_[entry.orbit]->calculate_offset(current);
+        return true;
+    }
+    return false;
+}
+
+void FlatOrbitTree::update(Duration current) {
+    if(outdated()){
+        rebuild();
+    }
+    // after a rebuild every object is positioned once, afterwards only the moving orbits and what they carry
+    bool everything = rebuilt_;
+    rebuilt_ = false;
+
+    angles_.resize(radii_.size());
+    for(size_t i = 0; i < radii_.size(); ++i){
+        angles_[i] = CircularOrbit::angle(phases_[i], periods_[i], current);
+    }
+    sincos(angles_, sines_, cosines_);
+
+    // the gravity wells, parents before children, so the world transformation of the parent is always current
+    for(size_t i = 0; i < wells_.size(); ++i){
+        GravityWell *well = wells_[i];
+        const Entry &entry = well_entries_[i];
+        bool moved;
+        if(entry.source == Source::ROOT){
+            if(!well->orbit_){
+                follow_object(root_);
+            }
+            moved = well->update_world_transform(everything);
+        }else{
+            uint32_t parent = well_parents_[i];
+            // an unchanged gravity well is not moved, the marks of its parent tell if it was changed
+            moved = move(entry, well, current) || everything || moved_[parent] || (wells_[parent]->dirty_satellites_ && well->transform_dirty_);
+            if(moved){
+                well->update_world_transform(true);
+            }
+        }
+        moved_[i] = moved;
+        totals_[i] = well->own_bounds();
+    }
+
+    // the other satellites of each gravity well, which only move their map objects
+    for(size_t i = 0; i < wells_.size(); ++i){
+        Group &group = groups_[i];
+        if(group.begin == group.end){
+            continue;
+        }
+        const GravityWell *well = wells_[i];
+        const AbsolutePosition *anchor = well->object_->anchor();
+        Bounds bounds;
+        // the moving satellites in a tight loop
+        for(size_t j = group.begin; j < group.moving_end; ++j){
+            // the satellites and their map objects are scattered over the heap, so they are fetched ahead
+            if(j + 2 * prefetch_distance < satellites_.size()){
+                __builtin_prefetch(satellites_[j + 2 * prefetch_distance].object, 1);
+            }
+            if(j + prefetch_distance < satellites_.size()){
+                __builtin_prefetch(satellites_[j + prefetch_distance].object->object_, 1);
+            }
+            const Entry &entry = satellites_[j];
+            OrbitalObject *satellite = entry.object;
+            move(entry, satellite, current);
+            satellite->update(current);
+            AbsolutePosition position = well->position_satellite(satellite, anchor);
+            bounds.expand(Bounds{position, position});
+        }
+        // the stationary and paused satellites keep their positions and their box unless the gravity well moved or one of them was changed
+        bool all = everything || moved_[i];
+        if(group.moving_end != group.end && (all || well->dirty_satellites_)){
+            Bounds stationary_bounds;
+            for(size_t j = group.moving_end; j < group.end; ++j){
+                // fetched ahead like the moving ones
+                if(j + 2 * prefetch_distance < satellites_.size()){
+                    __builtin_prefetch(satellites_[j + 2 * prefetch_distance].object, 1);
+                }
+                if(j + prefetch_distance < satellites_.size()){
+                    __builtin_prefetch(satellites_[j + prefetch_distance].object->object_, 1);
+                }
+                const Entry &entry = satellites_[j];
+                OrbitalObject *satellite = entry.object;
+                if(!all && !satellite->transform_dirty_){
+                    stationary_bounds.expand(satellite->bounds());
+                    continue;
+                }
+                if(entry.source != Source::PAUSED){
+                    satellite->update(current);
+                }
+                AbsolutePosition position = well->position_satellite(satellite, anchor);
+                stationary_bounds.expand(Bounds{position, position});
+            }
+            group.stationary_bounds = stationary_bounds;
+        }
+        bounds.expand(group.stationary_bounds);
+        totals_[i].expand(bounds);
+    }
+
+    // the gravity wells in reverse, so the box of each one is complete before it is added to the box of its parent
+    for(size_t i = wells_.size(); i-- > 0;){
+        wells_[i]->bounds_ = totals_[i];
+        wells_[i]->dirty_satellites_ = false;
+        if(i > 0){
+            totals_[well_parents_[i]].expand(totals_[i]);
+        }
+    }
+}
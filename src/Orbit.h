@@ -10,6 +10,8 @@
 
 #include "Object.h"
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace Game {
@@ -20,6 +22,10 @@ namespace Game {
 
     class OrbitalObject;
 
+    class CircularOrbit;
+
+    class FlatOrbitTree;
+
     ///
     /// Attaches the child to the parent's gravity well using the specified orbit
     /// The orbit will be added to the gravity well's orbit list and the child's orbit will be set
@@ -32,11 +38,144 @@ namespace Game {
     ///
     /// Detaches the gravity well and satellite
     /// Removes the orbit from the gravity well's orbit list and unsets the child orbit
-    /// The orbit is not deleted
+    /// The orbit is not deleted. The map object of the satellite keeps its last position, and the world transformation of a satellite
+    /// that is no gravity well becomes its local transformation, it is no longer composed with the former parent
     /// \param orbit the orbit
     ///
     void detach(Orbit *orbit);
 
+    ///
+    /// \class An axis aligned bounding box relative to the origin of the map, e.g. of a star system
+    ///
+    struct Bounds {
+
+        ///
+        /// creates an empty box, which contains nothing and grows to the first box it is expanded with
+        ///
+        Bounds();
+
+        ///
+        /// creates a box
+        /// \param minimum the corner with the smallest coordinates
+        /// \param maximum the corner with the largest coordinates
+        ///
+        Bounds(const AbsolutePosition &minimum, const AbsolutePosition &maximum);
+
+        ///
+        /// \param center the center of a circle
+        /// \param radius the radius of the circle
+        /// \return the smallest box around the circle
+        ///
+        static Bounds around(const AbsolutePosition &center, double radius);
+
+        ///
+        /// \return true if the box contains nothing
+        ///
+        bool empty() const;
+
+        ///
+        /// \param position a position
+        /// \return true if the box contains the position, including its border
+        ///
+        bool contains(const AbsolutePosition &position) const;
+
+        ///
+        /// \param bounds another box
+        /// \return true if the boxes overlap, including their borders
+        ///
+        bool intersects(const Bounds &bounds) const;
+
+        ///
+        /// \param position a position
+        /// \return the squared distance from the position to the nearest point of the box, zero inside
+        ///
+        double distance_squared(const AbsolutePosition &position) const;
+
+        ///
+        /// grows the box to contain another box
+        /// \param bounds the other box
+        ///
+        void expand(const Bounds &bounds);
+
+        bool operator==(const Bounds &bounds) const;
+
+        bool operator!=(const Bounds &bounds) const;
+
+        ///
+        /// the corner with the smallest coordinates
+        ///
+        AbsolutePosition minimum;
+
+        ///
+        /// the corner with the largest coordinates
+        ///
+        AbsolutePosition maximum;
+    };
+
+    ///
+    /// \class Evaluates a set of circular orbits together, so their trigonometry runs in one vectorized pass
+    /// The parameters and satellites of the orbits are copied into arrays when they are added, so an update does not visit the orbits.
+    /// Orbits around the satellite of another orbit in the set should be added after that orbit, so its parent is positioned first
+    ///
+    class CircularOrbitBatch {
+    public:
+
+        ///
+        /// creates an empty batch
+        ///
+        CircularOrbitBatch();
+
+        ///
+        /// adds an orbit
+        /// \param orbit the orbit, should stay attached while it is in the batch
+        ///
+        void add(CircularOrbit *orbit);
+
+        ///
+        /// removes an orbit
+        /// \param orbit the orbit
+        /// \return true if the orbit was in the batch
+        ///
+        bool remove(CircularOrbit *orbit);
+
+        ///
+        /// removes all orbits
+        ///
+        void clear();
+
+        ///
+        /// \return the orbits in the order they are evaluated
+        ///
+        const std::vector<CircularOrbit *> &orbits() const;
+
+        ///
+        /// sets the local offsets of the satellites of all orbits without marking them, and does not update the orbits of those satellites
+        /// or position them. A gravity well does not call it, it takes each offset from its batch while it positions that satellite.
+        /// \param current the elapsed time since game start
+        ///
+        void update(Duration current);
+
+    private:
+
+        // calculates the sines and cosines of all orbits
+        void evaluate(Duration current);
+
+        // the offset of the satellite of an orbit from the last evaluation
+        Position offset(std::size_t index) const;
+
+        std::vector<CircularOrbit *> orbits_;
+        // in the order of the orbits
+        std::vector<OrbitalObject *> satellites_;
+        std::vector<Coordinate> radii_;
+        std::vector<Coordinate> phases_;
+        std::vector<Duration> periods_;
+        std::vector<Angle> angles_;
+        std::vector<Angle> sines_;
+        std::vector<Angle> cosines_;
+
+        friend class GravityWell;
+    };
+
     ///
     /// A type representing an object in orbit around another object
     ///
@@ -64,10 +203,103 @@ namespace Game {
         /// \return the current orbit of this orbital object
         ///
         Orbit *orbit() const;
+
+        ///
+        /// \return the transformation from the frame of this object to the frame of its parent, for a satellite the translation set by its orbit
+        ///
+        Transform2<Coordinate> local_transform() const;
+
+        ///
+        /// changes the local transformation and marks this object and its satellites for the next transform update
+        /// \param transform the transformation
+        ///
+        void local_transform(const Transform2<Coordinate> &transform);
+
+        ///
+        /// changes only the translation of the local transformation, as orbits do every tick, see local_transform()
+        /// \param offset the position relative to the parent
+        ///
+        void local_offset(const Position &offset);
+
+        ///
+        /// \return the transformation from the frame of this object to the frame of its anchor. Only gravity wells keep it, as of the last transform update,
+        /// for any other object it is composed when called from the local transformation and the world transformation of its gravity well,
+        /// or equals the local transformation once the object is detached.
+        ///
+        Transform2<Coordinate> world_transform() const;
+
+        ///
+        /// \return true if the local transformation changed since the last transform update
+        ///
+        bool transform_dirty() const;
+
+        ///
+        /// \return the bounding box of this object and everything that orbits it, relative to the origin of the map, as of the last transform update
+        ///
+        virtual Bounds bounds() const;
+
+        ///
+        /// \return this object if it is a gravity well, whose satellites are part of the orbit tree, nullptr otherwise
+        ///
+        virtual GravityWell *gravity_well();
+
+        ///
+        /// \return this object if it is a gravity well, nullptr otherwise
+        ///
+        virtual const GravityWell *gravity_well() const;
+
+        virtual ~OrbitalObject();
+
+    protected:
+
+        ///
+        /// repositions the map object if this object or its parent changed
+        /// \param parent_changed true if the world transformation of the parent changed or the orbit moved this object
+        /// \return true if the object was repositioned
+        ///
+        bool update_position(bool parent_changed);
+
+        ///
+        /// recalculates the world transformations of this object and its satellites where they are outdated
+        /// \param parent_changed true if the world transformation of the parent changed
+        /// \return true if the bounds changed
+        ///
+        virtual bool propagate_transforms(bool parent_changed);
+
+        ///
+        /// updates this object and its satellites for the elapsed time, then recalculates the world transformations where they are outdated,
+        /// in the same traversal so every node is visited once per tick
+        /// \param current the elapsed time since game start
+        /// \param parent_changed true if the world transformation of the parent changed
+        /// \return true if the bounds changed
+        ///
+        virtual bool advance(Duration current, bool parent_changed);
+
     private:
+
+        // marks this object and the path from its root for the next transform update
+        void mark_dirty();
+
+        // marks the path from a gravity well to its root
+        static void mark_path(GravityWell *well);
+
+        // the position of the origin of this object relative to its anchor, as the translation of its world transformation
+        Position world_position() const;
+
         Orbit *orbit_;
         MapObject * const object_;
-
+        // the translation of the local transformation, next to the pointers so an orbit moving the object every tick touches one cache line;
+        // orbits set it without marks, the object is positioned in the same update
+        Position offset_;
+        // the other coefficients of the local transformation, in the order of Transform2, which only change through local_transform();
+        // null while they are those of the identity, so the satellites that are only moved by their orbits stay small
+        std::unique_ptr<Coordinate[]> linear_;
+        // true if the local transformation changed since the last transform update
+        bool transform_dirty_;
+
+        friend class GravityWell;
+        friend class CircularOrbitBatch;
+        friend class FlatOrbitTree;
         friend void attach(GravityWell *parent, OrbitalObject *child, Orbit *orbit);
         friend void detach(Orbit *orbit);
     };
@@ -84,16 +316,71 @@ namespace Game {
         GravityWell(MapObject *object);
 
         ///
-        /// updates the orbital object and its child orbits
+        /// updates the child orbits unless paused and positions the changed subtrees, the parent should be up to date.
+        /// A root that was moved through its map object takes the new position as its local transformation.
         /// \param current the elapsed time since game start
         ///
         void update(Duration duration);
 
+        ///
+        /// recalculates the world transformations and positions of this gravity well and its satellites where they are outdated,
+        /// the parent should be up to date. A root that was moved through its map object takes the new position as its local transformation.
+        ///
+        void update_transforms();
+
         ///
         /// \return the list of satellite orbits
         ///
         const std::vector<Orbit *> &orbits() const;
 
+        ///
+        /// \return the bounding box of the circle of this gravity well and everything that orbits it, relative to the origin of the map.
+        /// It is refit during the transform updates, only where something moved, so it can be used to cull or pick whole star systems.
+        ///
+        Bounds bounds() const;
+
+        GravityWell *gravity_well();
+
+        const GravityWell *gravity_well() const;
+
+        ///
+        /// Finds the objects of this subtree inside a box, skipping every gravity well whose bounds do not overlap it, e.g. to cull a viewport
+        /// Satellites are found by their positions and gravity wells by their circles
+        /// \param area the box, relative to the origin of the map
+        /// \param result receives the objects, its previous contents are discarded
+        ///
+        void inside(const Bounds &area, std::vector<OrbitalObject *> &result) const;
+
+        ///
+        /// Finds the objects of this subtree within a circle, skipping every gravity well whose bounds are too far away
+        /// Satellites are found by their positions and gravity wells by their circles
+        /// \param center the center of the circle, relative to the origin of the map
+        /// \param radius the radius of the circle
+        /// \param result receives the objects, its previous contents are discarded
+        ///
+        void within(const AbsolutePosition &center, double radius, std::vector<OrbitalObject *> &result) const;
+
+        ///
+        /// Finds the object of this subtree nearest to a position, e.g. to pick an object with the mouse
+        /// The distance to a gravity well is the distance to its circle, zero inside
+        /// \param position the position, relative to the origin of the map
+        /// \param tolerance the largest distance to consider
+        /// \return the nearest object, nullptr if there is none within the tolerance
+        ///
+        OrbitalObject *pick(const AbsolutePosition &position, double tolerance) const;
+
+        ///
+        /// \return true if the orbits around this gravity well are frozen
+        ///
+        bool paused() const;
+
+        ///
+        /// freezes or resumes the orbits around this gravity well and everything that orbits its satellites,
+        /// a paused system costs nothing per tick unless its parent moves
+        /// \param paused true to freeze the orbits
+        ///
+        void paused(bool paused);
+
         ///
         /// destroys this gravity well
         /// warning does not destroy orbits!
@@ -105,9 +392,54 @@ namespace Game {
         ///
         Coordinate radius;
 
+    protected:
+
+        bool propagate_transforms(bool parent_changed);
+
+        bool advance(Duration current, bool parent_changed);
+
     private:
-        std::vector<Orbit *> orbits_;
 
+        // recalculates the world transformation and position if this gravity well or its parent changed, returns true if they changed
+        bool update_world_transform(bool parent_changed);
+
+        // positions a satellite that is no gravity well like OrbitalObject::update_position(), returns its position relative to the origin of the map;
+        // the anchor of this gravity well is read once for all its satellites
+        AbsolutePosition position_satellite(OrbitalObject *satellite, const AbsolutePosition *own_anchor) const;
+
+        // positions the satellites where they are outdated, returns true if the bounds changed
+        bool propagate_satellites(bool changed);
+
+        // the box around the circle of this gravity well alone
+        Bounds own_bounds() const;
+
+        // recalculates the bounds from the satellites, returns true if they changed
+        bool refit_bounds();
+
+        // replaces the bounds, returns true if they changed
+        bool fit_bounds(const Bounds &bounds);
+
+        // visits the subtrees whose bounds pass the pruning test, the accepting test gets the center and radius of an object
+        template<typename Prune, typename Accept> void collect(Prune prune, Accept accept, std::vector<OrbitalObject *> &result) const;
+
+        // counts a change of the orbits below a gravity well and each of its ancestors
+        static void revise(GravityWell *well);
+
+        std::vector<Orbit *> orbits_;
+        // the orbits that can change while this gravity well stays put: moving orbits and gravity wells, which may have moving satellites
+        std::vector<Orbit *> active_orbits_;
+        CircularOrbitBatch circular_orbits_;
+        bool paused_;
+        // true if a satellite or something further down has an outdated world transformation or bounds
+        bool dirty_satellites_;
+        Bounds bounds_;
+        // changes whenever an orbit is attached or detached or a gravity well is paused or resumed in this subtree
+        unsigned revision_;
+        // the satellites compose their world transformations from this one, so only gravity wells keep it
+        Transform2<Coordinate> world_transform_;
+
+        friend class OrbitalObject;
+        friend class FlatOrbitTree;
         friend void attach(GravityWell *parent, OrbitalObject *child, Orbit *orbit);
         friend void detach(Orbit *orbit);
     };
@@ -128,7 +460,11 @@ namespace Game {
         OrbitalObject *child() const;
 
         ///
-        /// updates the position of the satellite
+        /// updates the offset of the satellite and its own orbits and marks it for the next transform update.
+        /// This only marks the satellite dirty: its position, world transformation and bounds, and those of the objects around it,
+        /// are stale until the root of the tree updates its transforms (see GravityWell::update_transforms()), which GravityWell::update()
+        /// and FlatOrbitTree::update() also do. So after updating any number of orbits the tree is propagated once instead of once per orbit.
+        /// The offset comes from calculate_offset(), which replaces calculate_position(): an orbit implementation overrides calculate_offset().
         /// \param current the elapsed time since game start
         ///
         void update(Duration current);
@@ -162,11 +498,31 @@ namespace Game {
         
         ///
         /// should be implemented to calculate the child's position for a given elapsed time
-        /// \return the child position
+        /// \return the child position relative to the parent
+        ///
+        virtual Position calculate_offset(Duration current) = 0;
+
+        ///
+        /// \return true if calculate_offset() does not depend on the time, the offset is then calculated once when attaching
+        /// and a satellite that is no gravity well is only visited when its parent moves
+        ///
+        virtual bool stationary() const;
+
+        ///
+        /// \return this orbit if it is a circular orbit, which its parent positions in a batch, nullptr otherwise
         ///
-        virtual Position calculate_position(Duration current) = 0;
+        virtual CircularOrbit *circular();
         
     private:
+        // true if the parent positions the child through its batch of circular orbits
+        bool batched_;
+        // the result of stationary() when attached, so the tick does not ask every orbit
+        bool stationary_;
+        // true if the child is a gravity well, which positions its own satellites
+        bool well_;
+
+        friend class GravityWell;
+        friend class FlatOrbitTree;
         friend void attach(GravityWell *parent, OrbitalObject *child, Orbit *orbit);
         friend void detach(Orbit *orbit);
     };
@@ -185,7 +541,9 @@ namespace Game {
 
     protected:
         
-        Position calculate_position(Duration current);
+        Position calculate_offset(Duration current);
+
+        bool stationary() const;
 
     private:
         const Position relative_position_;
@@ -206,12 +564,134 @@ namespace Game {
 
     protected:
 
-        Position calculate_position(Duration duration);
+        Position calculate_offset(Duration duration);
+
+        CircularOrbit *circular();
 
     private:
+        // the coordinates are adjacent so float coordinates share one slot before the period
         Coordinate radius_;
-        Duration period_;
         Coordinate phase_;
+        Duration period_;
+
+        Angle angle(Duration current) const;
+
+        static Angle angle(Coordinate phase, Duration period, Duration current);
+
+        friend class CircularOrbitBatch;
+        friend class FlatOrbitTree;
+    };
+
+    ///
+    /// \class A gravity well and everything that orbits it, flattened into arrays ordered parents before children
+    /// Each entry keeps the index of its parent, the source of its offset and the parameters of its circular orbit, if any,
+    /// so one linear pass positions the whole tree without recursion or virtual orbit calls, and the sines and cosines of all
+    /// circular orbits are calculated in one vectorized batch. The gravity wells are positioned first, then the other satellites of each gravity well,
+    /// which are kept together with the moving ones before the stationary and paused ones. A stationary range is skipped as a whole,
+    /// with the box it had, unless its gravity well moved or one of its satellites was changed.
+    /// The results are the same as those of GravityWell::update(), including the transformations, positions and bounds.
+    /// Attaching or detaching an orbit or pausing or resuming a gravity well in the tree makes it outdated,
+    /// the next update rebuilds it. Orbits should not be deleted while they are part of the tree.
+    /// The boxes of the satellites that did not move are kept between updates, so the tree should not also be updated
+    /// through GravityWell::update() or Orbit::update() unless it is rebuilt afterwards.
+    ///
+    class FlatOrbitTree {
+    public:
+
+        ///
+        /// flattens a gravity well and everything that orbits it
+        /// \param root the gravity well, should outlive the tree
+        ///
+        FlatOrbitTree(GravityWell *root);
+
+        ///
+        /// \return the gravity well the tree was flattened from
+        ///
+        GravityWell *root() const;
+
+        ///
+        /// updates the orbits unless they are paused and positions every object of the tree, like GravityWell::update(),
+        /// rebuilding the tree first if it is outdated
+        /// \param current the elapsed time since game start
+        ///
+        void update(Duration current);
+
+        ///
+        /// flattens the tree again from its root
+        ///
+        void rebuild();
+
+        ///
+        /// \return true if an orbit was attached or detached or a gravity well was paused or resumed since the last rebuild
+        ///
+        bool outdated() const;
+
+        ///
+        /// \return the objects of the tree in the order they are positioned, each after its parent
+        ///
+        const std::vector<OrbitalObject *> &objects() const;
+
+    private:
+
+        // where the local offset of an object comes from during an update
+        enum class Source : std::uint8_t {
+            // the root, positioned by its own parent or its map object
+            ROOT,
+            // a stationary orbit, the offset set when attaching is kept
+            STATIONARY,
+            // an orbit below a paused gravity well, neither the offset nor the object are updated
+            PAUSED,
+            // a circular orbit, calculated in the batch
+            CIRCULAR,
+            // any other orbit, calculated by the orbit
+            CUSTOM
+        };
+
+        // a gravity well or another satellite
+        struct Entry {
+            OrbitalObject *object;
+            // the index of the parameters of its circular orbit or of its custom orbit
+            std::uint32_t orbit;
+            Source source;
+        };
+
+        // the satellites of a gravity well that are no gravity wells
+        struct Group {
+            // the index of the first satellite, of the first one that does not move every update and the one past the last
+            std::uint32_t begin;
+            std::uint32_t moving_end;
+            std::uint32_t end;
+            // the box around the ones that do not move every update, kept while they are skipped
+            Bounds stationary_bounds;
+        };
+
+        GravityWell *root_;
+        unsigned revision_;
+        // true until the first update after a rebuild, which positions every object
+        bool rebuilt_;
+        // the gravity wells first, then the other satellites, so every object is after its parent
+        std::vector<OrbitalObject *> objects_;
+        // indexed by gravity well, the root first and every other gravity well after its parent
+        std::vector<GravityWell *> wells_;
+        std::vector<Entry> well_entries_;
+        std::vector<std::uint32_t> well_parents_;
+        std::vector<Group> groups_;
+        // true for the gravity wells positioned by the current update, whose satellites are positioned too
+        std::vector<std::uint8_t> moved_;
+        std::vector<Bounds> totals_;
+        // the satellites that are no gravity wells, in the order of their gravity wells
+        std::vector<Entry> satellites_;
+        std::vector<Orbit *> custom_orbits_;
+        // the parameters of the circular orbits
+        std::vector<Coordinate> radii_;
+        std::vector<Coordinate> phases_;
+        std::vector<Duration> periods_;
+        std::vector<Angle> angles_;
+        std::vector<Angle> sines_;
+        std::vector<Angle> cosines_;
+
+        // sets the offset of an object from its orbit, returns true if the orbit moves it every update
+        bool move(const Entry &entry, OrbitalObject *object, Duration current);
     };
 
 }
@@ -112,7 +112,7 @@ BOOST_PYTHON_MODULE(NameGenerator){
 BOOST_PYTHON_MODULE(NameGeneratorExt){
 }
 
-ScriptCallResult::ScriptCallResult(std::future<boost::python::object> &&result_future) : future_(forward<future<boost::python::object>>(result_future)){};
+ScriptCallResult::ScriptCallResult(Future<boost::python::object> &&result_future) : future_(forward<Future<boost::python::object>>(result_future)){};
 
 
 ScriptCallResult::ScriptCallResult(ScriptCallResult &&result) : future_(){
@@ -124,6 +124,10 @@ ScriptCallResult &ScriptCallResult::operator=(ScriptCallResult &&result){
     return *this;
 };
 
+bool ScriptCallResult::ready() const{
+    return future_.ready();
+}
+
 ScriptSystem::GILGuard::GILGuard(){
     gstate_ = PyGILState_Ensure();
 }
@@ -135,7 +139,8 @@ ScriptSystem::GILGuard::~GILGuard() {
 
 const ApplicationId ScriptSystem::id{"script"};
 
-ScriptSystem::ScriptSystem(size_t executor_thread_count) : writer_(), executors_(executor_thread_count){
+ScriptSystem::ScriptSystem(size_t executor_thread_count, FixedThreadPool::Scheduling executor_scheduling, size_t executor_min_thread_count, Duration executor_growth_threshold, Duration executor_retire_timeout)
+        : writer_(), executors_(executor_min_thread_count, executor_thread_count, executor_growth_threshold, executor_retire_timeout, executor_scheduling){
     using namespace boost::python;
     
     Py_Initialize();
@@ -172,6 +177,10 @@ ScriptSystem::~ScriptSystem(){
     Py_Finalize();    
 }
 
+FixedThreadPool &ScriptSystem::executors(){
+    return executors_;
+}
+
 ScriptWriter &ScriptSystem::writer(){
     return writer_;
 }
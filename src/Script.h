@@ -105,7 +105,7 @@ namespace Game {
     
     class ScriptCallResult{
     public:
-        ScriptCallResult(std::future<boost::python::object> &&future);
+        ScriptCallResult(Future<boost::python::object> &&future);
         
         ScriptCallResult(ScriptCallResult &&result);
         
@@ -115,8 +115,14 @@ namespace Game {
             return static_cast<T>(boost::python::extract<T>(future_.get()));
         };
         
+        bool ready() const;
+        
+        template<typename Executor, typename Function> auto then(Executor &executor, Function function) -> decltype(std::declval<Future<boost::python::object> &>().then(executor, function)){
+            return future_.then(executor, std::move(function));
+        };
+        
     private:
-        std::future<boost::python::object> future_;
+        Future<boost::python::object> future_;
         
         ScriptCallResult(const ScriptCallResult &) = delete;
         ScriptCallResult &operator=(const ScriptCallResult &) = delete;
@@ -127,7 +133,17 @@ namespace Game {
         
         static const ApplicationId id;
         
-        ScriptSystem(std::size_t executor_thread_count = 2);
+        ///
+        /// Starts the interpreter and the executors that run submitted calls
+        /// \param executor_thread_count the maximum amount of executor threads
+        /// \param executor_scheduling the way calls are distributed, INLINE or DETERMINISTIC run them on the calling thread
+        /// \param executor_min_thread_count the amount of executor threads that never retire
+        /// \param executor_growth_threshold an executor thread is added when the oldest queued call has waited longer than this
+        /// \param executor_retire_timeout an executor thread above the minimum retires when it has been idle for this long
+        ///
+        ScriptSystem(std::size_t executor_thread_count = 4, FixedThreadPool::Scheduling executor_scheduling = FixedThreadPool::Scheduling::SHARED_QUEUE,
+                std::size_t executor_min_thread_count = 1, Duration executor_growth_threshold = std::chrono::milliseconds(2),
+                Duration executor_retire_timeout = std::chrono::seconds(5));
         
         void run(const ScriptContext &context, const Script &script);
         
@@ -135,6 +151,11 @@ namespace Game {
         
         ScriptWriter &writer();
         
+        ///
+        /// \return the pool that runs submitted calls, e.g. to read its statistics
+        ///
+        FixedThreadPool &executors();
+        
         template<typename Callable> auto evaluate_in_module(const std::string &module_name, Callable callable) -> decltype(callable(boost::python::object{})){
             using namespace std;
             using namespace boost::python;
@@ -199,12 +220,10 @@ namespace Game {
             return std::bind(&call_named_function<Args...>, named_function, args...);
         };
         
-        template<typename Function> ScriptCallResult submit_call(Function function){
+        template<typename Function> ScriptCallResult submit_call(Function function, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
             using namespace std;
             using namespace boost::python;
-            packaged_task<object ()> task{function};
-            ScriptCallResult result{task.get_future()};
-            executors_.submit(move(task));
+            ScriptCallResult result{executors_.submit_async(move(function), priority)};
             return move(result);
         };
         
@@ -222,7 +241,7 @@ namespace Game {
         
     private:
         ScriptWriter writer_;
-        FixedThreadPool executors_;
+        ElasticThreadPool executors_;
         boost::python::object main_module_;
         PyThreadState *main_thread_state_;
         
@@ -0,0 +1,772 @@
+#include "Simd.h"
+#include "Fixed.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GAME_SIMD_X86 1
+#include <immintrin.h>
+#define GAME_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+using namespace Game;
+using namespace std;
+
+//
+// scalar implementations, also used for the elements that do not fill a vector register
+//
+
+static void transform_scalar(const double *coefficients, const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    const double a = coefficients[0], b = coefficients[1], c = coefficients[2];
+    const double d = coefficients[3], e = coefficients[4], f = coefficients[5];
+    for(size_t i = 0; i < count; ++i){
+        double vx = x[i];
+        double vy = y[i];
+        result_x[i] = a * vx + b * vy + c;
+        result_y[i] = d * vx + e * vy + f;
+    }
+}
+
+static void distance_squared_scalar(const double *x, const double *y, double point_x, double point_y, double *result, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        double dx = x[i] - point_x;
+        double dy = y[i] - point_y;
+        result[i] = dx * dx + dy * dy;
+    }
+}
+
+static void norm_scalar(const double *x, const double *y, double *result, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        result[i] = sqrt(x[i] * x[i] + y[i] * y[i]);
+    }
+}
+
+static bool normalize_scalar(const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    bool valid = true;
+    for(size_t i = 0; i < count; ++i){
+        double vx = x[i];
+        double vy = y[i];
+        double norm = sqrt(vx * vx + vy * vy);
+        valid &= norm != 0;
+        result_x[i] = vx / norm;
+        result_y[i] = vy / norm;
+    }
+    return valid;
+}
+
+static void dot_scalar(const double *first_x, const double *first_y, const double *second_x, const double *second_y, double *result, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        result[i] = first_x[i] * second_x[i] + first_y[i] * second_y[i];
+    }
+}
+
+static void dot_vector_scalar(const double *x, const double *y, double vector_x, double vector_y, double *result, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        result[i] = x[i] * vector_x + y[i] * vector_y;
+    }
+}
+
+//
+// sine and cosine: the angle is reduced to [-pi/4, pi/4] by subtracting the nearest multiple of pi/2 (Cody-Waite),
+// then the fdlibm minimax polynomials are evaluated on the remainder and the results are swapped and negated per quadrant
+//
+
+// pi/2 split in three parts, the first two have 33 significant bits so their products with a multiple below 2^20 are exact
+static const double two_over_pi = 6.36619772367581382433e-01;
+static const double pi_over_2_first = 1.57079632673412561417e+00;
+static const double pi_over_2_second = 6.07710050630396597660e-11;
+static const double pi_over_2_third = 2.02226624871116645580e-21;
+
+// adding and subtracting 1.5 * 2^52 rounds to the nearest integer, which ends up in the low bits of the sum
+static const double round_to_integer = 6755399441055744.0;
+
+// above this magnitude, and for infinities and NaN, the reduction is inaccurate and the standard library is used instead
+static const double reduction_limit = 1.6e6;
+
+static const double sine_coefficients[] = {-1.66666666666666324348e-01, 8.33333333332248946124e-03, -1.98412698298579493134e-04, 2.75573137070700676789e-06, -2.50507602534068634195e-08, 1.58969099521155010221e-10};
+static const double cosine_coefficients[] = {4.16666666666666019037e-02, -1.38888888888741095749e-03, 2.48015872894767294178e-05, -2.75573143513906633035e-07, 2.08757232129817482790e-09, -1.13596475577881948265e-11};
+
+static void sincos_scalar(const double *angles, double *sines, double *cosines, size_t count){
+    const double *s = sine_coefficients, *c = cosine_coefficients;
+    for(size_t i = 0; i < count; ++i){
+        double angle = angles[i];
+        if(!(fabs(angle) <= reduction_limit)){
+            sines[i] = sin(angle);
+            cosines[i] = cos(angle);
+            continue;
+        }
+        double rounded = angle * two_over_pi + round_to_integer;
+        double multiple = rounded - round_to_integer;
+        uint64_t quadrant;
+        memcpy(&quadrant, &rounded, sizeof(quadrant));
+        double r = angle - multiple * pi_over_2_first;
+        r = r - multiple * pi_over_2_second;
+        r = r - multiple * pi_over_2_third;
+        double z = r * r;
+        double sine = r + z * r * (s[0] + z * (s[1] + z * (s[2] + z * (s[3] + z * (s[4] + z * s[5])))));
+        double half = 0.5 * z;
+        double w = 1.0 - half;
+        double cosine = w + (((1.0 - w) - half) + z * (z * (c[0] + z * (c[1] + z * (c[2] + z * (c[3] + z * (c[4] + z * c[5])))))));
+        sines[i] = quadrant & 1 ? cosine : sine;
+        cosines[i] = quadrant & 1 ? sine : cosine;
+        if(quadrant & 2){
+            sines[i] = -sines[i];
+        }
+        if((quadrant + 1) & 2){
+            cosines[i] = -cosines[i];
+        }
+    }
+}
+
+static const GeometryKernels scalar_kernels{transform_scalar, distance_squared_scalar, norm_scalar, normalize_scalar, dot_scalar, dot_vector_scalar, sincos_scalar};
+
+#ifdef GAME_SIMD_X86
+
+//
+// SSE2 implementations
+//
+
+GAME_TARGET("sse2") static void transform_sse2(const double *coefficients, const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    const __m128d a = _mm_set1_pd(coefficients[0]), b = _mm_set1_pd(coefficients[1]), c = _mm_set1_pd(coefficients[2]);
+    const __m128d d = _mm_set1_pd(coefficients[3]), e = _mm_set1_pd(coefficients[4]), f = _mm_set1_pd(coefficients[5]);
+    size_t i = 0;
+    for(; i + 2 <= count; i += 2){
+        __m128d vx = _mm_loadu_pd(x + i);
+        __m128d vy = _mm_loadu_pd(y + i);
+        _mm_storeu_pd(result_x + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, vx), _mm_mul_pd(b, vy)), c));
+        _mm_storeu_pd(result_y + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(d, vx), _mm_mul_pd(e, vy)), f));
+    }
+    transform_scalar(coefficients, x + i, y + i, result_x + i, result_y + i, count - i);
+}
+
+GAME_TARGET("sse2") static void distance_squared_sse2(const double *x, const double *y, double point_x, double point_y, double *result, size_t count){
+    const __m128d px = _mm_set1_pd(point_x), py = _mm_set1_pd(point_y);
+    size_t i = 0;
+    for(; i + 2 <= count; i += 2){
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + i), px);
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + i), py);
+        _mm_storeu_pd(result + i, _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+    }
+    distance_squared_scalar(x + i, y + i, point_x, point_y, result + i, count - i);
+}
+
+GAME_TARGET("sse2") static void norm_sse2(const double *x, const double *y, double *result, size_t count){
+    size_t i = 0;
+    for(; i + 2 <= count; i += 2){
+        __m128d vx = _mm_loadu_pd(x + i);
+        __m128d vy = _mm_loadu_pd(y + i);
+        _mm_storeu_pd(result + i, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(vx, vx), _mm_mul_pd(vy, vy))));
+    }
+    norm_scalar(x + i, y + i, result + i, count - i);
+}
+
+GAME_TARGET("sse2") static bool normalize_sse2(const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    const __m128d zero = _mm_setzero_pd();
+    int zero_mask = 0;
+    size_t i = 0;
+    for(; i + 2 <= count; i += 2){
+        __m128d vx = _mm_loadu_pd(x + i);
+        __m128d vy = _mm_loadu_pd(y + i);
+        __m128d norm = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(vx, vx), _mm_mul_pd(vy, vy)));
+        zero_mask |= _mm_movemask_pd(_mm_cmpeq_pd(norm, zero));
+        _mm_storeu_pd(result_x + i, _mm_div_pd(vx, norm));
+        _mm_storeu_pd(result_y + i, _mm_div_pd(vy, norm));
+    }
+    return normalize_scalar(x + i, y + i, result_x + i, result_y + i, count - i) && zero_mask == 0;
+}
+
+GAME_TARGET("sse2") static void dot_sse2(const double *first_x, const double *first_y, const double *second_x, const double *second_y, double *result, size_t count){
+    size_t i = 0;
+    for(; i + 2 <= count; i += 2){
+        __m128d x = _mm_mul_pd(_mm_loadu_pd(first_x + i), _mm_loadu_pd(second_x + i));
+        __m128d y = _mm_mul_pd(_mm_loadu_pd(first_y + i), _mm_loadu_pd(second_y + i));
+        _mm_storeu_pd(result + i, _mm_add_pd(x, y));
+    }
+    dot_scalar(first_x + i, first_y + i, second_x + i, second_y + i, result + i, count - i);
+}
+
+GAME_TARGET("sse2") static void dot_vector_sse2(const double *x, const double *y, double vector_x, double vector_y, double *result, size_t count){
+    const __m128d vx = _mm_set1_pd(vector_x), vy = _mm_set1_pd(vector_y);
+    size_t i = 0;
+    for(; i + 2 <= count; i += 2){
+        _mm_storeu_pd(result + i, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(x + i), vx), _mm_mul_pd(_mm_loadu_pd(y + i), vy)));
+    }
+    dot_vector_scalar(x + i, y + i, vector_x, vector_y, result + i, count - i);
+}
+
+GAME_TARGET("sse2") static void sincos_sse2(const double *angles, double *sines, double *cosines, size_t count){
+    const __m128d scale = _mm_set1_pd(two_over_pi), rounding = _mm_set1_pd(round_to_integer), limit = _mm_set1_pd(reduction_limit);
+    const __m128d first = _mm_set1_pd(pi_over_2_first), second = _mm_set1_pd(pi_over_2_second), third = _mm_set1_pd(pi_over_2_third);
+    const __m128d magnitude = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFF)), half = _mm_set1_pd(0.5), one = _mm_set1_pd(1.0);
+    const __m128i odd = _mm_set1_epi64x(1), negative = _mm_set1_epi64x(2);
+    const double *s = sine_coefficients, *c = cosine_coefficients;
+    size_t i = 0;
+    for(; i + 2 <= count; i += 2){
+        __m128d angle = _mm_loadu_pd(angles + i);
+        __m128d rounded = _mm_add_pd(_mm_mul_pd(angle, scale), rounding);
+        __m128d multiple = _mm_sub_pd(rounded, rounding);
+        __m128i quadrant = _mm_castpd_si128(rounded);
+        __m128d r = _mm_sub_pd(angle, _mm_mul_pd(multiple, first));
+        r = _mm_sub_pd(r, _mm_mul_pd(multiple, second));
+        r = _mm_sub_pd(r, _mm_mul_pd(multiple, third));
+        __m128d z = _mm_mul_pd(r, r);
+        __m128d p = _mm_add_pd(_mm_set1_pd(s[4]), _mm_mul_pd(z, _mm_set1_pd(s[5])));
+        p = _mm_add_pd(_mm_set1_pd(s[3]), _mm_mul_pd(z, p));
+        p = _mm_add_pd(_mm_set1_pd(s[2]), _mm_mul_pd(z, p));
+        p = _mm_add_pd(_mm_set1_pd(s[1]), _mm_mul_pd(z, p));
+        p = _mm_add_pd(_mm_set1_pd(s[0]), _mm_mul_pd(z, p));
+        __m128d sine = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(z, r), p));
+        __m128d q = _mm_add_pd(_mm_set1_pd(c[4]), _mm_mul_pd(z, _mm_set1_pd(c[5])));
+        q = _mm_add_pd(_mm_set1_pd(c[3]), _mm_mul_pd(z, q));
+        q = _mm_add_pd(_mm_set1_pd(c[2]), _mm_mul_pd(z, q));
+        q = _mm_add_pd(_mm_set1_pd(c[1]), _mm_mul_pd(z, q));
+        q = _mm_add_pd(_mm_set1_pd(c[0]), _mm_mul_pd(z, q));
+        __m128d h = _mm_mul_pd(half, z);
+        __m128d w = _mm_sub_pd(one, h);
+        __m128d cosine = _mm_add_pd(w, _mm_add_pd(_mm_sub_pd(_mm_sub_pd(one, w), h), _mm_mul_pd(z, _mm_mul_pd(z, q))));
+        // SSE2 lacks 64 bit comparisons, the low halves of the comparison are copied to the high halves
+        __m128d swap = _mm_castsi128_pd(_mm_shuffle_epi32(_mm_cmpeq_epi32(_mm_and_si128(quadrant, odd), odd), _MM_SHUFFLE(2, 2, 0, 0)));
+        __m128d sine_sign = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(quadrant, negative), 62));
+        __m128d cosine_sign = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(_mm_add_epi64(quadrant, odd), negative), 62));
+        _mm_storeu_pd(sines + i, _mm_xor_pd(_mm_or_pd(_mm_and_pd(swap, cosine), _mm_andnot_pd(swap, sine)), sine_sign));
+        _mm_storeu_pd(cosines + i, _mm_xor_pd(_mm_or_pd(_mm_and_pd(swap, sine), _mm_andnot_pd(swap, cosine)), cosine_sign));
+        int outside = _mm_movemask_pd(_mm_cmpnle_pd(_mm_and_pd(angle, magnitude), limit));
+        if(outside){
+            double lanes[2];
+            _mm_storeu_pd(lanes, angle);
+            for(int lane = 0; lane < 2; ++lane){
+                if(outside & (1 << lane)){
+                    sincos_scalar(lanes + lane, sines + i + lane, cosines + i + lane, 1);
+                }
+            }
+        }
+    }
+    sincos_scalar(angles + i, sines + i, cosines + i, count - i);
+}
+
+static const GeometryKernels sse2_kernels{transform_sse2, distance_squared_sse2, norm_sse2, normalize_sse2, dot_sse2, dot_vector_sse2, sincos_sse2};
+
+//
+// AVX2 implementations, the target deliberately excludes FMA so products are rounded before they are added
+//
+
+GAME_TARGET("avx2") static void transform_avx2(const double *coefficients, const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    const __m256d a = _mm256_set1_pd(coefficients[0]), b = _mm256_set1_pd(coefficients[1]), c = _mm256_set1_pd(coefficients[2]);
+    const __m256d d = _mm256_set1_pd(coefficients[3]), e = _mm256_set1_pd(coefficients[4]), f = _mm256_set1_pd(coefficients[5]);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256d vx = _mm256_loadu_pd(x + i);
+        __m256d vy = _mm256_loadu_pd(y + i);
+        _mm256_storeu_pd(result_x + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a, vx), _mm256_mul_pd(b, vy)), c));
+        _mm256_storeu_pd(result_y + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(d, vx), _mm256_mul_pd(e, vy)), f));
+    }
+    transform_sse2(coefficients, x + i, y + i, result_x + i, result_y + i, count - i);
+}
+
+GAME_TARGET("avx2") static void distance_squared_avx2(const double *x, const double *y, double point_x, double point_y, double *result, size_t count){
+    const __m256d px = _mm256_set1_pd(point_x), py = _mm256_set1_pd(point_y);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), px);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), py);
+        _mm256_storeu_pd(result + i, _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+    }
+    distance_squared_sse2(x + i, y + i, point_x, point_y, result + i, count - i);
+}
+
+GAME_TARGET("avx2") static void norm_avx2(const double *x, const double *y, double *result, size_t count){
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256d vx = _mm256_loadu_pd(x + i);
+        __m256d vy = _mm256_loadu_pd(y + i);
+        _mm256_storeu_pd(result + i, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(vx, vx), _mm256_mul_pd(vy, vy))));
+    }
+    norm_sse2(x + i, y + i, result + i, count - i);
+}
+
+GAME_TARGET("avx2") static bool normalize_avx2(const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    const __m256d zero = _mm256_setzero_pd();
+    int zero_mask = 0;
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256d vx = _mm256_loadu_pd(x + i);
+        __m256d vy = _mm256_loadu_pd(y + i);
+        __m256d norm = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(vx, vx), _mm256_mul_pd(vy, vy)));
+        zero_mask |= _mm256_movemask_pd(_mm256_cmp_pd(norm, zero, _CMP_EQ_OQ));
+        _mm256_storeu_pd(result_x + i, _mm256_div_pd(vx, norm));
+        _mm256_storeu_pd(result_y + i, _mm256_div_pd(vy, norm));
+    }
+    return normalize_sse2(x + i, y + i, result_x + i, result_y + i, count - i) && zero_mask == 0;
+}
+
+GAME_TARGET("avx2") static void dot_avx2(const double *first_x, const double *first_y, const double *second_x, const double *second_y, double *result, size_t count){
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256d x = _mm256_mul_pd(_mm256_loadu_pd(first_x + i), _mm256_loadu_pd(second_x + i));
+        __m256d y = _mm256_mul_pd(_mm256_loadu_pd(first_y + i), _mm256_loadu_pd(second_y + i));
+        _mm256_storeu_pd(result + i, _mm256_add_pd(x, y));
+    }
+    dot_sse2(first_x + i, first_y + i, second_x + i, second_y + i, result + i, count - i);
+}
+
+GAME_TARGET("avx2") static void dot_vector_avx2(const double *x, const double *y, double vector_x, double vector_y, double *result, size_t count){
+    const __m256d vx = _mm256_set1_pd(vector_x), vy = _mm256_set1_pd(vector_y);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        _mm256_storeu_pd(result + i, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(x + i), vx), _mm256_mul_pd(_mm256_loadu_pd(y + i), vy)));
+    }
+    dot_vector_sse2(x + i, y + i, vector_x, vector_y, result + i, count - i);
+}
+
+GAME_TARGET("avx2") static void sincos_avx2(const double *angles, double *sines, double *cosines, size_t count){
+    const __m256d scale = _mm256_set1_pd(two_over_pi), rounding = _mm256_set1_pd(round_to_integer), limit = _mm256_set1_pd(reduction_limit);
+    const __m256d first = _mm256_set1_pd(pi_over_2_first), second = _mm256_set1_pd(pi_over_2_second), third = _mm256_set1_pd(pi_over_2_third);
+    const __m256d magnitude = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFF)), half = _mm256_set1_pd(0.5), one = _mm256_set1_pd(1.0);
+    const __m256i odd = _mm256_set1_epi64x(1), negative = _mm256_set1_epi64x(2);
+    const double *s = sine_coefficients, *c = cosine_coefficients;
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256d angle = _mm256_loadu_pd(angles + i);
+        __m256d rounded = _mm256_add_pd(_mm256_mul_pd(angle, scale), rounding);
+        __m256d multiple = _mm256_sub_pd(rounded, rounding);
+        __m256i quadrant = _mm256_castpd_si256(rounded);
+        __m256d r = _mm256_sub_pd(angle, _mm256_mul_pd(multiple, first));
+        r = _mm256_sub_pd(r, _mm256_mul_pd(multiple, second));
+        r = _mm256_sub_pd(r, _mm256_mul_pd(multiple, third));
+        __m256d z = _mm256_mul_pd(r, r);
+        __m256d p = _mm256_add_pd(_mm256_set1_pd(s[4]), _mm256_mul_pd(z, _mm256_set1_pd(s[5])));
+        p = _mm256_add_pd(_mm256_set1_pd(s[3]), _mm256_mul_pd(z, p));
+        p = _mm256_add_pd(_mm256_set1_pd(s[2]), _mm256_mul_pd(z, p));
+        p = _mm256_add_pd(_mm256_set1_pd(s[1]), _mm256_mul_pd(z, p));
+        p = _mm256_add_pd(_mm256_set1_pd(s[0]), _mm256_mul_pd(z, p));
+        __m256d sine = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(z, r), p));
+        __m256d q = _mm256_add_pd(_mm256_set1_pd(c[4]), _mm256_mul_pd(z, _mm256_set1_pd(c[5])));
+        q = _mm256_add_pd(_mm256_set1_pd(c[3]), _mm256_mul_pd(z, q));
+        q = _mm256_add_pd(_mm256_set1_pd(c[2]), _mm256_mul_pd(z, q));
+        q = _mm256_add_pd(_mm256_set1_pd(c[1]), _mm256_mul_pd(z, q));
+        q = _mm256_add_pd(_mm256_set1_pd(c[0]), _mm256_mul_pd(z, q));
+        __m256d h = _mm256_mul_pd(half, z);
+        __m256d w = _mm256_sub_pd(one, h);
+        __m256d cosine = _mm256_add_pd(w, _mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(one, w), h), _mm256_mul_pd(z, _mm256_mul_pd(z, q))));
+        // blendv only looks at the sign bit, so the quadrant bits are shifted there
+        __m256d swap = _mm256_castsi256_pd(_mm256_slli_epi64(quadrant, 63));
+        __m256d sine_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(quadrant, negative), 62));
+        __m256d cosine_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(quadrant, odd), negative), 62));
+        _mm256_storeu_pd(sines + i, _mm256_xor_pd(_mm256_blendv_pd(sine, cosine, swap), sine_sign));
+        _mm256_storeu_pd(cosines + i, _mm256_xor_pd(_mm256_blendv_pd(cosine, sine, swap), cosine_sign));
+        int outside = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(angle, magnitude), limit, _CMP_NLE_UQ));
+        if(outside){
+            double lanes[4];
+            _mm256_storeu_pd(lanes, angle);
+            for(int lane = 0; lane < 4; ++lane){
+                if(outside & (1 << lane)){
+                    sincos_scalar(lanes + lane, sines + i + lane, cosines + i + lane, 1);
+                }
+            }
+        }
+    }
+    sincos_sse2(angles + i, sines + i, cosines + i, count - i);
+}
+
+static const GeometryKernels avx2_kernels{transform_avx2, distance_squared_avx2, norm_avx2, normalize_avx2, dot_avx2, dot_vector_avx2, sincos_avx2};
+
+//
+// AVX-512 implementations, the remaining elements are handled with masked loads and stores
+//
+
+// the unmasked intrinsics pass an undefined vector to their masked builtins, which GCC reports as maybe uninitialized,
+// with all lanes selected and a zero vector as source these compile to the same unmasked instructions
+
+GAME_TARGET("avx512f") static inline __m512d sqrt_avx512(__m512d value){
+    return _mm512_mask_sqrt_pd(_mm512_setzero_pd(), 0xFF, value);
+}
+
+GAME_TARGET("avx512f") static inline __m512i multiply_low_avx512(__m512i first, __m512i second){
+    return _mm512_mask_mul_epu32(_mm512_setzero_si512(), 0xFF, first, second);
+}
+
+GAME_TARGET("avx512f") static inline __m512i shift_left_avx512(__m512i value, unsigned int bits){
+    return _mm512_mask_slli_epi64(_mm512_setzero_si512(), 0xFF, value, bits);
+}
+
+GAME_TARGET("avx512f") static inline __m512i shift_right_avx512(__m512i value, unsigned int bits){
+    return _mm512_mask_srli_epi64(_mm512_setzero_si512(), 0xFF, value, bits);
+}
+
+GAME_TARGET("avx512f") static void transform_avx512(const double *coefficients, const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    const __m512d a = _mm512_set1_pd(coefficients[0]), b = _mm512_set1_pd(coefficients[1]), c = _mm512_set1_pd(coefficients[2]);
+    const __m512d d = _mm512_set1_pd(coefficients[3]), e = _mm512_set1_pd(coefficients[4]), f = _mm512_set1_pd(coefficients[5]);
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d vx = _mm512_maskz_loadu_pd(mask, x + i);
+        __m512d vy = _mm512_maskz_loadu_pd(mask, y + i);
+        _mm512_mask_storeu_pd(result_x + i, mask, _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(a, vx), _mm512_mul_pd(b, vy)), c));
+        _mm512_mask_storeu_pd(result_y + i, mask, _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(d, vx), _mm512_mul_pd(e, vy)), f));
+    }
+}
+
+GAME_TARGET("avx512f") static void distance_squared_avx512(const double *x, const double *y, double point_x, double point_y, double *result, size_t count){
+    const __m512d px = _mm512_set1_pd(point_x), py = _mm512_set1_pd(point_y);
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d dx = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, x + i), px);
+        __m512d dy = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, y + i), py);
+        _mm512_mask_storeu_pd(result + i, mask, _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)));
+    }
+}
+
+GAME_TARGET("avx512f") static void norm_avx512(const double *x, const double *y, double *result, size_t count){
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d vx = _mm512_maskz_loadu_pd(mask, x + i);
+        __m512d vy = _mm512_maskz_loadu_pd(mask, y + i);
+        _mm512_mask_storeu_pd(result + i, mask, sqrt_avx512(_mm512_add_pd(_mm512_mul_pd(vx, vx), _mm512_mul_pd(vy, vy))));
+    }
+}
+
+GAME_TARGET("avx512f") static bool normalize_avx512(const double *x, const double *y, double *result_x, double *result_y, size_t count){
+    const __m512d zero = _mm512_setzero_pd();
+    __mmask8 zero_mask = 0;
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d vx = _mm512_maskz_loadu_pd(mask, x + i);
+        __m512d vy = _mm512_maskz_loadu_pd(mask, y + i);
+        __m512d norm = sqrt_avx512(_mm512_add_pd(_mm512_mul_pd(vx, vx), _mm512_mul_pd(vy, vy)));
+        // the lanes beyond the end are zero vectors as well, so only the loaded lanes are checked
+        zero_mask |= _mm512_mask_cmp_pd_mask(mask, norm, zero, _CMP_EQ_OQ);
+        _mm512_mask_storeu_pd(result_x + i, mask, _mm512_div_pd(vx, norm));
+        _mm512_mask_storeu_pd(result_y + i, mask, _mm512_div_pd(vy, norm));
+    }
+    return zero_mask == 0;
+}
+
+GAME_TARGET("avx512f") static void dot_avx512(const double *first_x, const double *first_y, const double *second_x, const double *second_y, double *result, size_t count){
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d x = _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, first_x + i), _mm512_maskz_loadu_pd(mask, second_x + i));
+        __m512d y = _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, first_y + i), _mm512_maskz_loadu_pd(mask, second_y + i));
+        _mm512_mask_storeu_pd(result + i, mask, _mm512_add_pd(x, y));
+    }
+}
+
+GAME_TARGET("avx512f") static void dot_vector_avx512(const double *x, const double *y, double vector_x, double vector_y, double *result, size_t count){
+    const __m512d vx = _mm512_set1_pd(vector_x), vy = _mm512_set1_pd(vector_y);
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d products = _mm512_add_pd(_mm512_mul_pd(_mm512_maskz_loadu_pd(mask, x + i), vx), _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, y + i), vy));
+        _mm512_mask_storeu_pd(result + i, mask, products);
+    }
+}
+
+GAME_TARGET("avx512f") static void sincos_avx512(const double *angles, double *sines, double *cosines, size_t count){
+    const __m512d scale = _mm512_set1_pd(two_over_pi), rounding = _mm512_set1_pd(round_to_integer), limit = _mm512_set1_pd(reduction_limit);
+    const __m512d first = _mm512_set1_pd(pi_over_2_first), second = _mm512_set1_pd(pi_over_2_second), third = _mm512_set1_pd(pi_over_2_third);
+    const __m512d half = _mm512_set1_pd(0.5), one = _mm512_set1_pd(1.0);
+    const __m512i magnitude = _mm512_set1_epi64(0x7FFFFFFFFFFFFFFF), odd = _mm512_set1_epi64(1), negative = _mm512_set1_epi64(2);
+    const double *s = sine_coefficients, *c = cosine_coefficients;
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d angle = _mm512_maskz_loadu_pd(mask, angles + i);
+        __m512d rounded = _mm512_add_pd(_mm512_mul_pd(angle, scale), rounding);
+        __m512d multiple = _mm512_sub_pd(rounded, rounding);
+        __m512i quadrant = _mm512_castpd_si512(rounded);
+        __m512d r = _mm512_sub_pd(angle, _mm512_mul_pd(multiple, first));
+        r = _mm512_sub_pd(r, _mm512_mul_pd(multiple, second));
+        r = _mm512_sub_pd(r, _mm512_mul_pd(multiple, third));
+        __m512d z = _mm512_mul_pd(r, r);
+        __m512d p = _mm512_add_pd(_mm512_set1_pd(s[4]), _mm512_mul_pd(z, _mm512_set1_pd(s[5])));
+        p = _mm512_add_pd(_mm512_set1_pd(s[3]), _mm512_mul_pd(z, p));
+        p = _mm512_add_pd(_mm512_set1_pd(s[2]), _mm512_mul_pd(z, p));
+        p = _mm512_add_pd(_mm512_set1_pd(s[1]), _mm512_mul_pd(z, p));
+        p = _mm512_add_pd(_mm512_set1_pd(s[0]), _mm512_mul_pd(z, p));
+        __m512d sine = _mm512_add_pd(r, _mm512_mul_pd(_mm512_mul_pd(z, r), p));
+        __m512d q = _mm512_add_pd(_mm512_set1_pd(c[4]), _mm512_mul_pd(z, _mm512_set1_pd(c[5])));
+        q = _mm512_add_pd(_mm512_set1_pd(c[3]), _mm512_mul_pd(z, q));
+        q = _mm512_add_pd(_mm512_set1_pd(c[2]), _mm512_mul_pd(z, q));
+        q = _mm512_add_pd(_mm512_set1_pd(c[1]), _mm512_mul_pd(z, q));
+        q = _mm512_add_pd(_mm512_set1_pd(c[0]), _mm512_mul_pd(z, q));
+        __m512d h = _mm512_mul_pd(half, z);
+        __m512d w = _mm512_sub_pd(one, h);
+        __m512d cosine = _mm512_add_pd(w, _mm512_add_pd(_mm512_sub_pd(_mm512_sub_pd(one, w), h), _mm512_mul_pd(z, _mm512_mul_pd(z, q))));
+        // AVX-512F has no floating point xor, the signs are flipped with integer operations
+        __mmask8 swap = _mm512_test_epi64_mask(quadrant, odd);
+        __m512i sine_sign = shift_left_avx512(_mm512_and_si512(quadrant, negative), 62);
+        __m512i cosine_sign = shift_left_avx512(_mm512_and_si512(_mm512_add_epi64(quadrant, odd), negative), 62);
+        __m512i swapped_sine = _mm512_castpd_si512(_mm512_mask_blend_pd(swap, sine, cosine));
+        __m512i swapped_cosine = _mm512_castpd_si512(_mm512_mask_blend_pd(swap, cosine, sine));
+        _mm512_mask_storeu_pd(sines + i, mask, _mm512_castsi512_pd(_mm512_xor_si512(swapped_sine, sine_sign)));
+        _mm512_mask_storeu_pd(cosines + i, mask, _mm512_castsi512_pd(_mm512_xor_si512(swapped_cosine, cosine_sign)));
+        __m512d absolute = _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(angle), magnitude));
+        __mmask8 outside = _mm512_mask_cmp_pd_mask(mask, absolute, limit, _CMP_NLE_UQ);
+        if(outside){
+            double lanes[8];
+            _mm512_storeu_pd(lanes, angle);
+            for(int lane = 0; lane < 8; ++lane){
+                if(outside & (1 << lane)){
+                    sincos_scalar(lanes + lane, sines + i + lane, cosines + i + lane, 1);
+                }
+            }
+        }
+    }
+}
+
+static const GeometryKernels avx512_kernels{transform_avx512, distance_squared_avx512, norm_avx512, normalize_avx512, dot_avx512, dot_vector_avx512, sincos_avx512};
+
+#endif
+
+//
+// fixed point implementations, the scalar ones use the Fixed operators that the vector ones reproduce
+//
+
+static void transform_fixed_scalar(const int64_t *coefficients, const int64_t *x, const int64_t *y, int64_t *result_x, int64_t *result_y, size_t count){
+    const Fixed a = Fixed::from_raw(coefficients[0]), b = Fixed::from_raw(coefficients[1]), c = Fixed::from_raw(coefficients[2]);
+    const Fixed d = Fixed::from_raw(coefficients[3]), e = Fixed::from_raw(coefficients[4]), f = Fixed::from_raw(coefficients[5]);
+    for(size_t i = 0; i < count; ++i){
+        Fixed vx = Fixed::from_raw(x[i]);
+        Fixed vy = Fixed::from_raw(y[i]);
+        result_x[i] = (a * vx + b * vy + c).raw();
+        result_y[i] = (d * vx + e * vy + f).raw();
+    }
+}
+
+static void distance_squared_fixed_scalar(const int64_t *x, const int64_t *y, int64_t point_x, int64_t point_y, int64_t *result, size_t count){
+    const Fixed px = Fixed::from_raw(point_x), py = Fixed::from_raw(point_y);
+    for(size_t i = 0; i < count; ++i){
+        Fixed dx = Fixed::from_raw(x[i]) - px;
+        Fixed dy = Fixed::from_raw(y[i]) - py;
+        result[i] = (dx * dx + dy * dy).raw();
+    }
+}
+
+static void dot_fixed_scalar(const int64_t *first_x, const int64_t *first_y, const int64_t *second_x, const int64_t *second_y, int64_t *result, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        result[i] = (Fixed::from_raw(first_x[i]) * Fixed::from_raw(second_x[i]) + Fixed::from_raw(first_y[i]) * Fixed::from_raw(second_y[i])).raw();
+    }
+}
+
+static void dot_vector_fixed_scalar(const int64_t *x, const int64_t *y, int64_t vector_x, int64_t vector_y, int64_t *result, size_t count){
+    const Fixed vx = Fixed::from_raw(vector_x), vy = Fixed::from_raw(vector_y);
+    for(size_t i = 0; i < count; ++i){
+        result[i] = (Fixed::from_raw(x[i]) * vx + Fixed::from_raw(y[i]) * vy).raw();
+    }
+}
+
+static const FixedKernels fixed_scalar_kernels{transform_fixed_scalar, distance_squared_fixed_scalar, dot_fixed_scalar, dot_vector_fixed_scalar};
+
+#ifdef GAME_SIMD_X86
+
+// the rounded product (first * second + 2^31) >> 32 from four 32 bit products: with a = ah * 2^32 + al and b = bh * 2^32 + bl
+// it is ah * bh * 2^32 + ah * bl + al * bh + ((al * bl + 2^31) >> 32), where only the low 64 bits are kept
+GAME_TARGET("avx2") static inline __m256i multiply_fixed_avx2(__m256i first, __m256i second){
+    const __m256i zero = _mm256_setzero_si256(), half = _mm256_set1_epi64x(int64_t{1} << 31);
+    __m256i first_high = _mm256_srli_epi64(first, 32), second_high = _mm256_srli_epi64(second, 32);
+    __m256i low = _mm256_srli_epi64(_mm256_add_epi64(_mm256_mul_epu32(first, second), half), 32);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(first_high, second), _mm256_mul_epu32(first, second_high));
+    __m256i high = _mm256_slli_epi64(_mm256_mul_epu32(first_high, second_high), 32);
+    // the multiplications treat a negative high half as unsigned, which adds 2^32 times the low half of the other number
+    __m256i first_correction = _mm256_and_si256(_mm256_cmpgt_epi64(zero, first), _mm256_slli_epi64(second, 32));
+    __m256i second_correction = _mm256_and_si256(_mm256_cmpgt_epi64(zero, second), _mm256_slli_epi64(first, 32));
+    __m256i product = _mm256_add_epi64(_mm256_add_epi64(high, cross), low);
+    return _mm256_sub_epi64(_mm256_sub_epi64(product, first_correction), second_correction);
+}
+
+GAME_TARGET("avx2") static void transform_fixed_avx2(const int64_t *coefficients, const int64_t *x, const int64_t *y, int64_t *result_x, int64_t *result_y, size_t count){
+    const __m256i a = _mm256_set1_epi64x(coefficients[0]), b = _mm256_set1_epi64x(coefficients[1]), c = _mm256_set1_epi64x(coefficients[2]);
+    const __m256i d = _mm256_set1_epi64x(coefficients[3]), e = _mm256_set1_epi64x(coefficients[4]), f = _mm256_set1_epi64x(coefficients[5]);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+        __m256i vy = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+        __m256i rx = _mm256_add_epi64(_mm256_add_epi64(multiply_fixed_avx2(a, vx), multiply_fixed_avx2(b, vy)), c);
+        __m256i ry = _mm256_add_epi64(_mm256_add_epi64(multiply_fixed_avx2(d, vx), multiply_fixed_avx2(e, vy)), f);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(result_x + i), rx);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(result_y + i), ry);
+    }
+    transform_fixed_scalar(coefficients, x + i, y + i, result_x + i, result_y + i, count - i);
+}
+
+GAME_TARGET("avx2") static void distance_squared_fixed_avx2(const int64_t *x, const int64_t *y, int64_t point_x, int64_t point_y, int64_t *result, size_t count){
+    const __m256i px = _mm256_set1_epi64x(point_x), py = _mm256_set1_epi64x(point_y);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256i dx = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i)), px);
+        __m256i dy = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i)), py);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i), _mm256_add_epi64(multiply_fixed_avx2(dx, dx), multiply_fixed_avx2(dy, dy)));
+    }
+    distance_squared_fixed_scalar(x + i, y + i, point_x, point_y, result + i, count - i);
+}
+
+GAME_TARGET("avx2") static void dot_fixed_avx2(const int64_t *first_x, const int64_t *first_y, const int64_t *second_x, const int64_t *second_y, int64_t *result, size_t count){
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256i x = multiply_fixed_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(first_x + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(second_x + i)));
+        __m256i y = multiply_fixed_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(first_y + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(second_y + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i), _mm256_add_epi64(x, y));
+    }
+    dot_fixed_scalar(first_x + i, first_y + i, second_x + i, second_y + i, result + i, count - i);
+}
+
+GAME_TARGET("avx2") static void dot_vector_fixed_avx2(const int64_t *x, const int64_t *y, int64_t vector_x, int64_t vector_y, int64_t *result, size_t count){
+    const __m256i vx = _mm256_set1_epi64x(vector_x), vy = _mm256_set1_epi64x(vector_y);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256i px = multiply_fixed_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i)), vx);
+        __m256i py = multiply_fixed_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i)), vy);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i), _mm256_add_epi64(px, py));
+    }
+    dot_vector_fixed_scalar(x + i, y + i, vector_x, vector_y, result + i, count - i);
+}
+
+static const FixedKernels fixed_avx2_kernels{transform_fixed_avx2, distance_squared_fixed_avx2, dot_fixed_avx2, dot_vector_fixed_avx2};
+
+// see multiply_fixed_avx2
+GAME_TARGET("avx512f") static inline __m512i multiply_fixed_avx512(__m512i first, __m512i second){
+    const __m512i zero = _mm512_setzero_si512(), half = _mm512_set1_epi64(int64_t{1} << 31);
+    __m512i first_high = shift_right_avx512(first, 32), second_high = shift_right_avx512(second, 32);
+    __m512i low = shift_right_avx512(_mm512_add_epi64(multiply_low_avx512(first, second), half), 32);
+    __m512i cross = _mm512_add_epi64(multiply_low_avx512(first_high, second), multiply_low_avx512(first, second_high));
+    __m512i high = shift_left_avx512(multiply_low_avx512(first_high, second_high), 32);
+    __m512i product = _mm512_add_epi64(_mm512_add_epi64(high, cross), low);
+    product = _mm512_mask_sub_epi64(product, _mm512_cmpgt_epi64_mask(zero, first), product, shift_left_avx512(second, 32));
+    return _mm512_mask_sub_epi64(product, _mm512_cmpgt_epi64_mask(zero, second), product, shift_left_avx512(first, 32));
+}
+
+GAME_TARGET("avx512f") static void transform_fixed_avx512(const int64_t *coefficients, const int64_t *x, const int64_t *y, int64_t *result_x, int64_t *result_y, size_t count){
+    const __m512i a = _mm512_set1_epi64(coefficients[0]), b = _mm512_set1_epi64(coefficients[1]), c = _mm512_set1_epi64(coefficients[2]);
+    const __m512i d = _mm512_set1_epi64(coefficients[3]), e = _mm512_set1_epi64(coefficients[4]), f = _mm512_set1_epi64(coefficients[5]);
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512i vx = _mm512_maskz_loadu_epi64(mask, x + i);
+        __m512i vy = _mm512_maskz_loadu_epi64(mask, y + i);
+        _mm512_mask_storeu_epi64(result_x + i, mask, _mm512_add_epi64(_mm512_add_epi64(multiply_fixed_avx512(a, vx), multiply_fixed_avx512(b, vy)), c));
+        _mm512_mask_storeu_epi64(result_y + i, mask, _mm512_add_epi64(_mm512_add_epi64(multiply_fixed_avx512(d, vx), multiply_fixed_avx512(e, vy)), f));
+    }
+}
+
+GAME_TARGET("avx512f") static void distance_squared_fixed_avx512(const int64_t *x, const int64_t *y, int64_t point_x, int64_t point_y, int64_t *result, size_t count){
+    const __m512i px = _mm512_set1_epi64(point_x), py = _mm512_set1_epi64(point_y);
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512i dx = _mm512_sub_epi64(_mm512_maskz_loadu_epi64(mask, x + i), px);
+        __m512i dy = _mm512_sub_epi64(_mm512_maskz_loadu_epi64(mask, y + i), py);
+        _mm512_mask_storeu_epi64(result + i, mask, _mm512_add_epi64(multiply_fixed_avx512(dx, dx), multiply_fixed_avx512(dy, dy)));
+    }
+}
+
+GAME_TARGET("avx512f") static void dot_fixed_avx512(const int64_t *first_x, const int64_t *first_y, const int64_t *second_x, const int64_t *second_y, int64_t *result, size_t count){
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512i x = multiply_fixed_avx512(_mm512_maskz_loadu_epi64(mask, first_x + i), _mm512_maskz_loadu_epi64(mask, second_x + i));
+        __m512i y = multiply_fixed_avx512(_mm512_maskz_loadu_epi64(mask, first_y + i), _mm512_maskz_loadu_epi64(mask, second_y + i));
+        _mm512_mask_storeu_epi64(result + i, mask, _mm512_add_epi64(x, y));
+    }
+}
+
+GAME_TARGET("avx512f") static void dot_vector_fixed_avx512(const int64_t *x, const int64_t *y, int64_t vector_x, int64_t vector_y, int64_t *result, size_t count){
+    const __m512i vx = _mm512_set1_epi64(vector_x), vy = _mm512_set1_epi64(vector_y);
+    for(size_t i = 0; i < count; i += 8){
+        __mmask8 mask = count - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512i px = multiply_fixed_avx512(_mm512_maskz_loadu_epi64(mask, x + i), vx);
+        __m512i py = multiply_fixed_avx512(_mm512_maskz_loadu_epi64(mask, y + i), vy);
+        _mm512_mask_storeu_epi64(result + i, mask, _mm512_add_epi64(px, py));
+    }
+}
+
+static const FixedKernels fixed_avx512_kernels{transform_fixed_avx512, distance_squared_fixed_avx512, dot_fixed_avx512, dot_vector_fixed_avx512};
+
+#endif
+
+static SimdLevel detect_simd_level(){
+#ifdef GAME_SIMD_X86
+    // also checks that the operating system saves the wider registers
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")){
+        return SimdLevel::AVX512;
+    }
+    if(__builtin_cpu_supports("avx2")){
+        return SimdLevel::AVX2;
+    }
+    if(__builtin_cpu_supports("sse2")){
+        return SimdLevel::SSE2;
+    }
+#endif
+    return SimdLevel::SCALAR;
+}
+
+// -1 until a level is selected explicitly
+static atomic<int> selected_level{-1};
+
+SimdLevel Game::supported_simd_level(){
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+SimdLevel Game::simd_level(){
+    int level = selected_level.load(memory_order_relaxed);
+    return level < 0 ? supported_simd_level() : static_cast<SimdLevel>(level);
+}
+
+void Game::simd_level(SimdLevel level){
+    if(static_cast<int>(level) > static_cast<int>(supported_simd_level())){
+        throw invalid_argument{string{"the processor does not support "} + simd_level_name(level)};
+    }
+    selected_level.store(static_cast<int>(level), memory_order_relaxed);
+}
+
+const char *Game::simd_level_name(SimdLevel level){
+    switch(level){
+        case SimdLevel::SCALAR:
+            return "scalar";
+        case SimdLevel::SSE2:
+            return "sse2";
+        case SimdLevel::AVX2:
+            return "avx2";
+        case SimdLevel::AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+const GeometryKernels &GeometryKernels::active(){
+    return at(simd_level());
+}
+
+const GeometryKernels &GeometryKernels::at(SimdLevel level){
+#ifdef GAME_SIMD_X86
+    switch(level){
+        case SimdLevel::SCALAR:
+            return scalar_kernels;
+        case SimdLevel::SSE2:
+            return sse2_kernels;
+        case SimdLevel::AVX2:
+            return avx2_kernels;
+        case SimdLevel::AVX512:
+            return avx512_kernels;
+    }
+#endif
+    return scalar_kernels;
+}
+
+const FixedKernels &FixedKernels::active(){
+    return at(simd_level());
+}
+
+const FixedKernels &FixedKernels::at(SimdLevel level){
+#ifdef GAME_SIMD_X86
+    switch(level){
+        case SimdLevel::SCALAR:
+        case SimdLevel::SSE2:
+            return fixed_scalar_kernels;
+        case SimdLevel::AVX2:
+            return fixed_avx2_kernels;
+        case SimdLevel::AVX512:
+            return fixed_avx512_kernels;
+    }
+#endif
+    return fixed_scalar_kernels;
+}
@@ -0,0 +1,161 @@
+///
+/// \file contains the selection of instruction set specific implementations of the batch geometry functions
+///
+
+#ifndef GAME_SIMD_H
+#define	GAME_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Game{
+
+    ///
+    /// The vector instruction sets the batch geometry functions can use, in increasing order of width
+    ///
+    enum class SimdLevel{
+        ///
+        /// plain C++ loops, which the compiler may still vectorize for the baseline instruction set
+        ///
+        SCALAR,
+
+        ///
+        /// 128 bit vectors, two doubles per instruction
+        ///
+        SSE2,
+
+        ///
+        /// 256 bit vectors, four doubles per instruction
+        ///
+        AVX2,
+
+        ///
+        /// 512 bit vectors, eight doubles per instruction
+        ///
+        AVX512
+    };
+
+    ///
+    /// \return the widest level supported by the processor and operating system, determined once with CPUID
+    ///
+    SimdLevel supported_simd_level();
+
+    ///
+    /// \return the level used by the batch geometry functions, the supported level unless changed
+    ///
+    SimdLevel simd_level();
+
+    ///
+    /// Changes the level used by the batch geometry functions, e.g. to compare implementations
+    /// Should be called before other threads use the batch geometry functions
+    /// \param level the level
+    /// \throw std::invalid_argument if the processor does not support the level
+    ///
+    void simd_level(SimdLevel level);
+
+    ///
+    /// \param level a level
+    /// \return the name of the level, e.g. "avx2"
+    ///
+    const char *simd_level_name(SimdLevel level);
+
+    ///
+    /// \class The implementations of the batch geometry functions for double coordinates at one level
+    /// All implementations perform the same IEEE operations in the same order as the scalar Vector2 and Transform2 functions,
+    /// or the scalar sincos implementation, without fused multiply-add, so they produce bit identical results: the tolerance between levels is zero.
+    /// The arrays may be the same for input and output, but may not overlap otherwise.
+    ///
+    struct GeometryKernels{
+
+        ///
+        /// Applies an affine transformation with the coefficients of a Transform2
+        ///
+        void (*transform)(const double *coefficients, const double *x, const double *y, double *result_x, double *result_y, std::size_t count);
+
+        ///
+        /// Calculates the squared distances to a point, with (0, 0) these are the squared norms
+        ///
+        void (*distance_squared)(const double *x, const double *y, double point_x, double point_y, double *result, std::size_t count);
+
+        ///
+        /// Calculates the norms
+        ///
+        void (*norm)(const double *x, const double *y, double *result, std::size_t count);
+
+        ///
+        /// Normalizes the vectors
+        /// \return false if one of the vectors is a zero vector, the results are unspecified in that case
+        ///
+        bool (*normalize)(const double *x, const double *y, double *result_x, double *result_y, std::size_t count);
+
+        ///
+        /// Calculates the dot products of pairs of vectors
+        ///
+        void (*dot)(const double *first_x, const double *first_y, const double *second_x, const double *second_y, double *result, std::size_t count);
+
+        ///
+        /// Calculates the dot products with a single vector
+        ///
+        void (*dot_vector)(const double *x, const double *y, double vector_x, double vector_y, double *result, std::size_t count);
+
+        ///
+        /// Calculates the sines and cosines of angles in radians, with an absolute error below 2e-16
+        /// Angles with a magnitude above 1.6e6 radians fall back to std::sin and std::cos
+        ///
+        void (*sincos)(const double *angles, double *sines, double *cosines, std::size_t count);
+
+        ///
+        /// \return the implementations for the level returned by simd_level()
+        ///
+        static const GeometryKernels &active();
+
+        ///
+        /// \param level a level
+        /// \return the implementations for the level, which should be supported by the processor before they are called
+        ///
+        static const GeometryKernels &at(SimdLevel level);
+    };
+
+    ///
+    /// \class The implementations of the batch geometry functions for Fixed coordinates at one level, on their 64 bit representations
+    /// They perform the same integer operations as the Fixed operators, so the results are identical at every level.
+    /// Products are rounded 128 bit products emulated with 32 bit multiplications, SSE2 lacks those for signed numbers and uses the scalar implementations.
+    ///
+    struct FixedKernels{
+
+        ///
+        /// Applies an affine transformation with the coefficients of a Transform2
+        ///
+        void (*transform)(const std::int64_t *coefficients, const std::int64_t *x, const std::int64_t *y, std::int64_t *result_x, std::int64_t *result_y, std::size_t count);
+
+        ///
+        /// Calculates the squared distances to a point, with (0, 0) these are the squared norms
+        ///
+        void (*distance_squared)(const std::int64_t *x, const std::int64_t *y, std::int64_t point_x, std::int64_t point_y, std::int64_t *result, std::size_t count);
+
+        ///
+        /// Calculates the dot products of pairs of vectors
+        ///
+        void (*dot)(const std::int64_t *first_x, const std::int64_t *first_y, const std::int64_t *second_x, const std::int64_t *second_y, std::int64_t *result, std::size_t count);
+
+        ///
+        /// Calculates the dot products with a single vector
+        ///
+        void (*dot_vector)(const std::int64_t *x, const std::int64_t *y, std::int64_t vector_x, std::int64_t vector_y, std::int64_t *result, std::size_t count);
+
+        ///
+        /// \return the implementations for the level returned by simd_level()
+        ///
+        static const FixedKernels &active();
+
+        ///
+        /// \param level a level
+        /// \return the implementations for the level, which should be supported by the processor before they are called
+        ///
+        static const FixedKernels &at(SimdLevel level);
+    };
+
+}
+
+#endif	/* GAME_SIMD_H */
+
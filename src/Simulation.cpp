@@ -0,0 +1,135 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace Game;
+using namespace std;
+
+Duration SimulationStatistics::average_tick_duration() const{
+    if(tick_count == 0){
+        return Duration::zero();
+    }else{
+        return total_tick_duration / tick_count;
+    }
+}
+
+Simulation::Simulation(FixedThreadPool &pool, Duration step, size_t max_steps_per_frame) : pool_(pool), step_(step), max_steps_per_frame_(max_steps_per_frame), roots_(), trees_(), moves_(), time_(Duration::zero()), accumulator_(Duration::zero()), last_frame_(), started_(false), statistics_(){
+    if(step_ <= Duration::zero()){
+        throw invalid_argument{"simulation step should be positive"};
+    }
+    if(max_steps_per_frame_ == 0){
+        throw invalid_argument{"simulation should perform at least one step per frame"};
+    }
+}
+
+void Simulation::add(GravityWell *root){
+    if(root->orbit()){
+        throw invalid_argument{"gravity well in orbit is not a root"};
+    }
+    if(find(roots_.begin(), roots_.end(), root) != roots_.end()){
+        throw invalid_argument{"gravity well already added to simulation"};
+    }
+    roots_.push_back(root);
+    trees_.emplace_back(root);
+    moves_.emplace_back();
+}
+
+bool Simulation::remove(GravityWell *root){
+    auto found = find(roots_.begin(), roots_.end(), root);
+    if(found == roots_.end()){
+        return false;
+    }else{
+        trees_.erase(trees_.begin() + (found - roots_.begin()));
+        moves_.erase(moves_.begin() + (found - roots_.begin()));
+        roots_.erase(found);
+        return true;
+    }
+}
+
+const vector<GravityWell *> &Simulation::roots() const{
+    return roots_;
+}
+
+size_t Simulation::advance(Duration elapsed){
+    size_t steps = 0;
+    accumulator_ += elapsed;
+    while(accumulator_ >= step_ && steps < max_steps_per_frame_){
+        tick();
+        accumulator_ -= step_;
+        ++steps;
+    }
+    if(accumulator_ >= step_){
+        // too far behind: drop the backlog, otherwise every following frame would take longer than the one before
+        statistics_.dropped_tick_count += static_cast<size_t>(accumulator_ / step_);
+        accumulator_ %= step_;
+    }
+    return steps;
+}
+
+size_t Simulation::frame(){
+    TimePoint now = Clock::now();
+    if(!started_){
+        started_ = true;
+        last_frame_ = now;
+        return 0;
+    }
+    Duration elapsed = now - last_frame_;
+    last_frame_ = now;
+    return advance(elapsed);
+}
+
+void Simulation::tick(){
+    TimePoint start = Clock::now();
+    time_ += step_;
+    Duration current = time_;
+    try{
+        pool_.parallel_for(0, roots_.size(), [this, current](size_t index){
+            GridMoveLog::Scope scope{moves_[index]};
+            trees_[index].update(current);
+        }, 1);
+    }catch(...){
+        // the objects that did move stay indexed at their new positions and the logs are empty again for the next tick
+        apply_moves();
+        throw;
+    }
+    apply_moves();
+    Duration tick_duration = Clock::now() - start;
+    ++statistics_.tick_count;
+    if(tick_duration > step_){
+        ++statistics_.overrun_count;
+    }
+    statistics_.last_tick_duration = tick_duration;
+    statistics_.max_tick_duration = max(statistics_.max_tick_duration, tick_duration);
+    statistics_.total_tick_duration += tick_duration;
+}
+
+void Simulation::apply_moves(){
+    for(GridMoveLog &moves : moves_){
+        moves.apply();
+    }
+}
+
+Duration Simulation::time() const{
+    return time_;
+}
+
+Duration Simulation::step() const{
+    return step_;
+}
+
+size_t Simulation::max_steps_per_frame() const{
+    return max_steps_per_frame_;
+}
+
+double Simulation::interpolation() const{
+    return static_cast<double>(accumulator_.count()) / static_cast<double>(step_.count());
+}
+
+const SimulationStatistics &Simulation::statistics() const{
+    return statistics_;
+}
+
+void Simulation::reset_statistics(){
+    statistics_ = SimulationStatistics{};
+}
@@ -0,0 +1,175 @@
+///
+/// \file contains the fixed time step scheduler that advances the orbital simulation
+///
+
+#ifndef GAME_SIMULATION_H
+#define	GAME_SIMULATION_H
+
+#include "Object.h"
+#include "Orbit.h"
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace Game{
+
+    ///
+    /// \class Timing information about the ticks performed by a Simulation
+    ///
+    struct SimulationStatistics{
+
+        ///
+        /// the amount of ticks performed
+        ///
+        std::size_t tick_count;
+
+        ///
+        /// the amount of ticks that took longer than the time step
+        ///
+        std::size_t overrun_count;
+
+        ///
+        /// the amount of ticks that were skipped because a frame needed more than the maximum amount of steps to catch up
+        ///
+        std::size_t dropped_tick_count;
+
+        ///
+        /// the wall clock duration of the last tick
+        ///
+        Duration last_tick_duration;
+
+        ///
+        /// the wall clock duration of the slowest tick
+        ///
+        Duration max_tick_duration;
+
+        ///
+        /// the total wall clock duration of all ticks
+        ///
+        Duration total_tick_duration;
+
+        ///
+        /// \return the average wall clock duration of a tick, or Duration::zero() if no ticks were performed
+        ///
+        Duration average_tick_duration() const;
+    };
+
+    ///
+    /// \class A fixed time step scheduler for the gravity well hierarchies of the game
+    /// Elapsed wall clock time is collected in an accumulator and the simulation is advanced in steps of exactly one time step,
+    /// so the simulation does not depend on the frame rate. The amount of steps per frame is limited: if a frame falls further behind,
+    /// the remaining time is dropped instead of letting the backlog grow.
+    /// Every tick, the root gravity wells are updated in parallel on the thread pool, one task per root, since their hierarchies are independent.
+    /// Each hierarchy is updated through a FlatOrbitTree, which is rebuilt in its task after orbits were attached or detached.
+    /// Objects of different hierarchies may share a SpatialGrid: each task records its moves in a GridMoveLog of its root,
+    /// and the grids are updated on the calling thread after all tasks finished, in the order of the roots.
+    /// This class is not thread safe, it should be driven by a single thread (usually the main loop).
+    ///
+    class Simulation{
+    public:
+
+        ///
+        /// Creates a new simulation at time zero without any gravity wells
+        /// \param pool the thread pool used to update the root gravity wells, should outlive this simulation
+        /// \param step the simulation time step
+        /// \param max_steps_per_frame the maximum amount of ticks performed by a single call to advance() or frame()
+        /// \throw std::invalid_argument if the step is not positive or max_steps_per_frame is 0
+        ///
+        Simulation(FixedThreadPool &pool, Duration step = std::chrono::duration_cast<Duration>(std::chrono::seconds(1)) / 60, std::size_t max_steps_per_frame = 5);
+
+        ///
+        /// Adds the root of a gravity well hierarchy, it is updated every tick with all of its satellites
+        /// \param root the gravity well, should not be in orbit itself and should outlive this simulation or be removed first
+        /// \throw std::invalid_argument if the gravity well is in orbit or was already added
+        ///
+        void add(GravityWell *root);
+
+        ///
+        /// Removes the root of a gravity well hierarchy
+        /// \param root the gravity well
+        /// \return true if the gravity well was removed, false if it was not part of this simulation
+        ///
+        bool remove(GravityWell *root);
+
+        ///
+        /// \return the root gravity wells
+        ///
+        const std::vector<GravityWell *> &roots() const;
+
+        ///
+        /// Adds elapsed wall clock time and performs as many ticks as fit in the accumulated time, up to the maximum amount of steps per frame
+        /// \param elapsed the elapsed wall clock time
+        /// \return the amount of ticks performed
+        ///
+        std::size_t advance(Duration elapsed);
+
+        ///
+        /// Calls advance() with the wall clock time elapsed since the previous call to this function
+        /// The first call only starts measuring time and performs no ticks
+        /// \return the amount of ticks performed
+        ///
+        std::size_t frame();
+
+        ///
+        /// Advances the simulation by exactly one time step, ignoring the accumulator
+        /// If updating a hierarchy throws, the moves of the other hierarchies are still applied to their grids before the first error is rethrown
+        ///
+        void tick();
+
+        ///
+        /// \return the elapsed simulation time since the start of the game
+        ///
+        Duration time() const;
+
+        ///
+        /// \return the simulation time step
+        ///
+        Duration step() const;
+
+        ///
+        /// \return the maximum amount of ticks per frame
+        ///
+        std::size_t max_steps_per_frame() const;
+
+        ///
+        /// \return the fraction of a time step that is accumulated but not simulated yet, in [0, 1), useful to interpolate positions when rendering
+        ///
+        double interpolation() const;
+
+        ///
+        /// \return the timing information of all ticks since creation or the last call to reset_statistics()
+        ///
+        const SimulationStatistics &statistics() const;
+
+        ///
+        /// Resets the timing information
+        ///
+        void reset_statistics();
+
+    private:
+        FixedThreadPool &pool_;
+        const Duration step_;
+        const std::size_t max_steps_per_frame_;
+        std::vector<GravityWell *> roots_;
+        // the flattened hierarchies of the roots, in the same order
+        std::vector<FlatOrbitTree> trees_;
+        // the moves of indexed objects during the current tick, one log per root in the same order
+        std::vector<GridMoveLog> moves_;
+        Duration time_;
+        Duration accumulator_;
+        TimePoint last_frame_;
+        bool started_;
+        SimulationStatistics statistics_;
+
+        void apply_moves();
+
+        Simulation(const Simulation &) = delete;
+        Simulation &operator=(const Simulation &) = delete;
+    };
+
+}
+
+#endif	/* GAME_SIMULATION_H */
+
@@ -0,0 +1,279 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+using namespace Game;
+using namespace std;
+
+static uint64_t cell_key(int32_t x, int32_t y){
+    return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+}
+
+static double squared_distance(const Position &position, double x, double y){
+    double dx = static_cast<double>(position.x) - x;
+    double dy = static_cast<double>(position.y) - y;
+    return dx * dx + dy * dy;
+}
+
+SpatialGrid::SpatialGrid(Coordinate cell_size, const AbsolutePosition *anchor) : cell_size_(cell_size), inverse_cell_size_(), anchor_(anchor), size_(), cells_(), free_cells_(), lookup_(){
+    if(!(cell_size > Coordinate{})){
+        throw invalid_argument{"the cell size of a spatial grid should be positive"};
+    }
+    inverse_cell_size_ = 1.0 / static_cast<double>(cell_size);
+}
+
+SpatialGrid::~SpatialGrid(){
+    for(Cell &cell : cells_){
+        for(Entry &entry : cell.entries){
+            entry.object->grid_ = nullptr;
+        }
+    }
+}
+
+void SpatialGrid::insert(MapObject *object){
+    if(object->grid_){
+        throw invalid_argument{"the object is already indexed by a spatial grid"};
+    }
+    Position position = relative_position(*object, anchor_);
+    add(*object, position, cell_coordinate(static_cast<double>(position.x)), cell_coordinate(static_cast<double>(position.y)));
+    object->grid_ = this;
+    ++size_;
+}
+
+void SpatialGrid::remove(MapObject *object){
+    if(object->grid_ != this){
+        throw invalid_argument{"the object is not indexed by this spatial grid"};
+    }
+    erase(*object);
+    object->grid_ = nullptr;
+    --size_;
+}
+
+size_t SpatialGrid::size() const{
+    return size_;
+}
+
+Coordinate SpatialGrid::cell_size() const{
+    return cell_size_;
+}
+
+const AbsolutePosition *SpatialGrid::anchor() const{
+    return anchor_;
+}
+
+void SpatialGrid::moved(MapObject &object){
+    if(GridMoveLog::current_log_){
+        GridMoveLog::current_log_->objects_.push_back(&object);
+    }else{
+        update(object);
+    }
+}
+
+void SpatialGrid::update(MapObject &object){
+    Position position = relative_position(object, anchor_);
+    int32_t x = cell_coordinate(static_cast<double>(position.x)), y = cell_coordinate(static_cast<double>(position.y));
+    Cell &cell = cells_[object.grid_cell_];
+    if(cell.x == x && cell.y == y){
+        cell.entries[object.grid_slot_].position = position;
+        return;
+    }
+    erase(object);
+    add(object, position, x, y);
+}
+
+void SpatialGrid::add(MapObject &object, const Position &position, int32_t x, int32_t y){
+    uint64_t key = cell_key(x, y);
+    unordered_map<uint64_t, uint32_t>::iterator found = lookup_.find(key);
+    uint32_t index;
+    if(found != lookup_.end()){
+        index = found->second;
+    }else{
+        if(free_cells_.empty()){
+            index = static_cast<uint32_t>(cells_.size());
+            cells_.push_back(Cell{});
+        }else{
+            index = free_cells_.back();
+            free_cells_.pop_back();
+        }
+        cells_[index].x = x;
+        cells_[index].y = y;
+        lookup_.emplace(key, index);
+    }
+    vector<Entry> &entries = cells_[index].entries;
+    object.grid_cell_ = index;
+    object.grid_slot_ = static_cast<uint32_t>(entries.size());
+    entries.push_back(Entry{position, &object});
+}
+
+void SpatialGrid::erase(MapObject &object){
+    Cell &cell = cells_[object.grid_cell_];
+    // the last entry fills the gap, so only its slot changes
+    Entry &entry = cell.entries[object.grid_slot_];
+    entry = cell.entries.back();
+    entry.object->grid_slot_ = object.grid_slot_;
+    cell.entries.pop_back();
+    if(cell.entries.empty()){
+        lookup_.erase(cell_key(cell.x, cell.y));
+        free_cells_.push_back(object.grid_cell_);
+    }
+}
+
+int32_t SpatialGrid::cell_coordinate(double value) const{
+    // positions beyond the range share the outermost cells, which keeps the queries correct but slower there
+    double cell = floor(value * inverse_cell_size_);
+    if(!(cell > numeric_limits<int32_t>::min())){
+        return numeric_limits<int32_t>::min();
+    }
+    if(cell > numeric_limits<int32_t>::max()){
+        return numeric_limits<int32_t>::max();
+    }
+    return static_cast<int32_t>(cell);
+}
+
+template<typename Visitor> void SpatialGrid::visit(int64_t minimum_x, int64_t minimum_y, int64_t maximum_x, int64_t maximum_y, Visitor visitor) const{
+    minimum_x = max<int64_t>(minimum_x, numeric_limits<int32_t>::min());
+    minimum_y = max<int64_t>(minimum_y, numeric_limits<int32_t>::min());
+    maximum_x = min<int64_t>(maximum_x, numeric_limits<int32_t>::max());
+    maximum_y = min<int64_t>(maximum_y, numeric_limits<int32_t>::max());
+    if(minimum_x > maximum_x || minimum_y > maximum_y){
+        return;
+    }
+    if(static_cast<double>(maximum_x - minimum_x + 1) * static_cast<double>(maximum_y - minimum_y + 1) > static_cast<double>(lookup_.size())){
+        // more cells in the range than occupied cells, scanning the occupied cells is cheaper than hashing every cell of the range
+        for(const Cell &cell : cells_){
+            if(!cell.entries.empty() && cell.x >= minimum_x && cell.x <= maximum_x && cell.y >= minimum_y && cell.y <= maximum_y){
+                visitor(cell);
+            }
+        }
+        return;
+    }
+    for(int64_t x = minimum_x; x <= maximum_x; ++x){
+        for(int64_t y = minimum_y; y <= maximum_y; ++y){
+            unordered_map<uint64_t, uint32_t>::const_iterator found = lookup_.find(cell_key(static_cast<int32_t>(x), static_cast<int32_t>(y)));
+            if(found != lookup_.end()){
+                visitor(cells_[found->second]);
+            }
+        }
+    }
+}
+
+void SpatialGrid::within(const Position &center, Coordinate radius, vector<MapObject *> &result) const{
+    result.clear();
+    double x = static_cast<double>(center.x), y = static_cast<double>(center.y), r = static_cast<double>(radius);
+    double limit = r * r;
+    visit(cell_coordinate(x - r), cell_coordinate(y - r), cell_coordinate(x + r), cell_coordinate(y + r), [&](const Cell &cell){
+        for(const Entry &entry : cell.entries){
+            if(squared_distance(entry.position, x, y) <= limit){
+                result.push_back(entry.object);
+            }
+        }
+    });
+}
+
+void SpatialGrid::inside(const Position &minimum, const Position &maximum, vector<MapObject *> &result) const{
+    result.clear();
+    visit(cell_coordinate(static_cast<double>(minimum.x)), cell_coordinate(static_cast<double>(minimum.y)),
+            cell_coordinate(static_cast<double>(maximum.x)), cell_coordinate(static_cast<double>(maximum.y)), [&](const Cell &cell){
+        for(const Entry &entry : cell.entries){
+            if(entry.position.x >= minimum.x && entry.position.x <= maximum.x && entry.position.y >= minimum.y && entry.position.y <= maximum.y){
+                result.push_back(entry.object);
+            }
+        }
+    });
+}
+
+void SpatialGrid::nearest(const Position &point, size_t count, vector<MapObject *> &result) const{
+    result.clear();
+    if(count == 0 || size_ == 0){
+        return;
+    }
+    double x = static_cast<double>(point.x), y = static_cast<double>(point.y);
+    double cell_size = static_cast<double>(cell_size_);
+    // a max heap of the best candidates so far, the farthest one on top
+    vector<pair<double, MapObject *>> best;
+    best.reserve(min(count, size_));
+    auto consider = [&](const Cell &cell){
+        for(const Entry &entry : cell.entries){
+            double distance = squared_distance(entry.position, x, y);
+            if(best.size() < count){
+                best.emplace_back(distance, entry.object);
+                push_heap(best.begin(), best.end());
+            }else if(distance < best.front().first){
+                pop_heap(best.begin(), best.end());
+                best.back() = make_pair(distance, entry.object);
+                push_heap(best.begin(), best.end());
+            }
+        }
+    };
+
+    int64_t center_x = cell_coordinate(x), center_y = cell_coordinate(y);
+    size_t seen = 0, lookups = 0;
+    for(int64_t ring = 0; seen < size_; ++ring){
+        if(best.size() == count){
+            // the rings so far cover a square of cells around the point, everything outside is at least this far away
+            double margin = min(min(x - (center_x - ring + 1) * cell_size, (center_x + ring) * cell_size - x),
+                    min(y - (center_y - ring + 1) * cell_size, (center_y + ring) * cell_size - y));
+            if(margin > 0 && margin * margin > best.front().first){
+                break;
+            }
+        }
+        lookups += ring == 0 ? 1 : 8 * ring;
+        if(lookups > lookup_.size()){
+            // the point is far from the objects or they are sparse, one pass over all occupied cells is cheaper than more rings
+            best.clear();
+            for(const Cell &cell : cells_){
+                consider(cell);
+            }
+            break;
+        }
+        auto visit_ring = [&](const Cell &cell){
+            seen += cell.entries.size();
+            consider(cell);
+        };
+        if(ring == 0){
+            visit(center_x, center_y, center_x, center_y, visit_ring);
+        }else{
+            visit(center_x - ring, center_y - ring, center_x + ring, center_y - ring, visit_ring);
+            visit(center_x - ring, center_y + ring, center_x + ring, center_y + ring, visit_ring);
+            visit(center_x - ring, center_y - ring + 1, center_x - ring, center_y + ring - 1, visit_ring);
+            visit(center_x + ring, center_y - ring + 1, center_x + ring, center_y + ring - 1, visit_ring);
+        }
+    }
+
+    sort_heap(best.begin(), best.end());
+    result.reserve(best.size());
+    for(const pair<double, MapObject *> &candidate : best){
+        result.push_back(candidate.second);
+    }
+}
+
+thread_local GridMoveLog *GridMoveLog::current_log_ = nullptr;
+
+GridMoveLog::Scope::Scope(GridMoveLog &log) : previous_(current_log_){
+    current_log_ = &log;
+}
+
+GridMoveLog::Scope::~Scope(){
+    current_log_ = previous_;
+}
+
+GridMoveLog::GridMoveLog() : objects_(){
+}
+
+bool GridMoveLog::empty() const{
+    return objects_.empty();
+}
+
+void GridMoveLog::apply(){
+    // an object moved twice is updated twice, which is cheap and keeps recording a single push_back
+    for(MapObject *object : objects_){
+        if(object->grid_){
+            object->grid_->update(*object);
+        }
+    }
+    objects_.clear();
+}
@@ -0,0 +1,200 @@
+///
+/// \file contains a uniform grid that indexes map objects by their positions
+///
+
+#ifndef GAME_SPATIAL_GRID_H
+#define	GAME_SPATIAL_GRID_H
+
+#include "Object.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+namespace Game{
+
+    ///
+    /// \class A uniform grid of square cells over the positions of map objects, relative to one anchor
+    /// Only the occupied cells are stored, in a hash map, so the grid is unbounded and its memory grows with the objects, not the area.
+    /// An indexed object reports its moves itself: MapObject::position() updates the cached position in constant time
+    /// and moves the entry to another cell when the object crosses a cell boundary.
+    /// Queries only visit the cells that overlap the query area, or every occupied cell once if that is cheaper.
+    /// The cell size should be near the typical query radius: smaller cells cost more lookups, larger cells more distance tests.
+    /// A grid is not thread safe, objects should not be moved while another thread queries it.
+    /// Indexed objects may be moved by several threads at once if each of them records its moves in a GridMoveLog.
+    ///
+    class SpatialGrid{
+    public:
+
+        ///
+        /// Creates an empty grid
+        /// \param cell_size the edge length of the cells
+        /// \param anchor the anchor of the positions of the grid and its queries, nullptr for the origin of the map
+        /// \throw std::invalid_argument if the cell size is not positive
+        ///
+        SpatialGrid(Coordinate cell_size, const AbsolutePosition *anchor = nullptr);
+
+        SpatialGrid(const SpatialGrid &) = delete;
+
+        SpatialGrid &operator=(const SpatialGrid &) = delete;
+
+        ///
+        /// Removes all objects from the grid
+        ///
+        ~SpatialGrid();
+
+        ///
+        /// Adds an object, which is indexed until it is removed or destroyed
+        /// \param object the object
+        /// \throw std::invalid_argument if the object is already indexed by a grid
+        ///
+        void insert(MapObject *object);
+
+        ///
+        /// Removes an object
+        /// \param object the object
+        /// \throw std::invalid_argument if the object is not indexed by this grid
+        ///
+        void remove(MapObject *object);
+
+        ///
+        /// \return the amount of indexed objects
+        ///
+        std::size_t size() const;
+
+        ///
+        /// \return the edge length of the cells
+        ///
+        Coordinate cell_size() const;
+
+        ///
+        /// \return the anchor of the positions of the grid, nullptr for the origin of the map
+        ///
+        const AbsolutePosition *anchor() const;
+
+        ///
+        /// Finds the objects within a circle, including its border
+        /// \param center the center, relative to the anchor of the grid
+        /// \param radius the radius
+        /// \param result receives the objects in no particular order, its previous contents are discarded
+        ///
+        void within(const Position &center, Coordinate radius, std::vector<MapObject *> &result) const;
+
+        ///
+        /// Finds the objects inside a rectangle, including its border, e.g. a viewport
+        /// \param minimum the corner with the smallest coordinates, relative to the anchor of the grid
+        /// \param maximum the corner with the largest coordinates
+        /// \param result receives the objects in no particular order, its previous contents are discarded
+        ///
+        void inside(const Position &minimum, const Position &maximum, std::vector<MapObject *> &result) const;
+
+        ///
+        /// Finds the objects nearest to a point, searching rings of cells outward until no closer object can exist
+        /// \param point the point, relative to the anchor of the grid
+        /// \param count the maximum amount of objects to find
+        /// \param result receives the objects ordered by increasing distance, ties in no particular order; its previous contents are discarded
+        ///
+        void nearest(const Position &point, std::size_t count, std::vector<MapObject *> &result) const;
+
+    private:
+
+        struct Entry{
+            Position position;
+            MapObject *object;
+        };
+
+        struct Cell{
+            std::int32_t x;
+            std::int32_t y;
+            std::vector<Entry> entries;
+        };
+
+        // updates the entry of an indexed object after it changed its position or anchor, or records it in the active log of the thread
+        void moved(MapObject &object);
+
+        void update(MapObject &object);
+
+        void add(MapObject &object, const Position &position, std::int32_t x, std::int32_t y);
+
+        void erase(MapObject &object);
+
+        std::int32_t cell_coordinate(double value) const;
+
+        template<typename Visitor> void visit(std::int64_t minimum_x, std::int64_t minimum_y, std::int64_t maximum_x, std::int64_t maximum_y, Visitor visitor) const;
+
+        Coordinate cell_size_;
+        double inverse_cell_size_;
+        const AbsolutePosition *anchor_;
+        std::size_t size_;
+        std::vector<Cell> cells_;
+        // cells that were emptied, reused before new cells are appended
+        std::vector<std::uint32_t> free_cells_;
+        std::unordered_map<std::uint64_t, std::uint32_t> lookup_;
+
+        friend class MapObject;
+        friend class GridMoveLog;
+    };
+
+    ///
+    /// \class Records the moves of objects indexed by spatial grids, to update the grids later on one thread
+    /// While a log is active on a thread, moving an indexed object there only changes the object and appends it to the log,
+    /// so threads that move different objects of the same grid do not touch the grid. Queries see the old positions until apply() is called.
+    /// The recorded objects should stay indexed until then. A log should only be active on one thread at a time.
+    ///
+    class GridMoveLog{
+    public:
+
+        ///
+        /// \class Activates a log on the calling thread until the end of its scope, the previously active log is restored afterwards
+        ///
+        class Scope{
+        public:
+
+            ///
+            /// Activates a log on the calling thread
+            /// \param log the log
+            ///
+            explicit Scope(GridMoveLog &log);
+
+            Scope(const Scope &) = delete;
+
+            Scope &operator=(const Scope &) = delete;
+
+            ///
+            /// Restores the previously active log
+            ///
+            ~Scope();
+
+        private:
+            GridMoveLog *previous_;
+        };
+
+        ///
+        /// Creates an empty log
+        ///
+        GridMoveLog();
+
+        ///
+        /// \return true if no moves were recorded since the last call to apply()
+        ///
+        bool empty() const;
+
+        ///
+        /// Updates the grids of the recorded objects and empties the log
+        /// Should not run concurrently with moves or queries of the same grids
+        ///
+        void apply();
+
+    private:
+        std::vector<MapObject *> objects_;
+
+        static thread_local GridMoveLog *current_log_;
+
+        friend class SpatialGrid;
+    };
+
+}
+
+#endif	/* GAME_SPATIAL_GRID_H */
+
@@ -0,0 +1,232 @@
+#include "Task.h"
+
+using namespace Game;
+using namespace std;
+
+Task::Task() : storage_(), operations_(), queued_at_(), previous_(), next_(){
+}
+
+Task::~Task(){
+    reset();
+}
+
+void Task::execute(){
+    operations_->execute(&storage_);
+}
+
+void Task::reset(){
+    queued_at_ = TimePoint{};
+    if(operations_){
+        const Operations *operations = operations_;
+        operations_ = nullptr;
+        operations->destroy(&storage_);
+    }
+}
+
+bool Task::empty() const{
+    return !operations_;
+}
+
+TimePoint Task::queued_at() const{
+    return queued_at_;
+}
+
+void Task::queued_at(TimePoint time){
+    queued_at_ = time;
+}
+
+TaskQueue::TaskQueue() : first_(), last_(), size_(){
+}
+
+TaskQueue::TaskQueue(TaskQueue &&queue) : first_(queue.first_), last_(queue.last_), size_(queue.size_){
+    queue.first_ = nullptr;
+    queue.last_ = nullptr;
+    queue.size_ = 0;
+}
+
+TaskQueue &TaskQueue::operator=(TaskQueue &&queue){
+    swap(first_, queue.first_);
+    swap(last_, queue.last_);
+    swap(size_, queue.size_);
+    return *this;
+}
+
+bool TaskQueue::empty() const{
+    return size_ == 0;
+}
+
+size_t TaskQueue::size() const{
+    return size_;
+}
+
+Task *TaskQueue::front() const{
+    return first_;
+}
+
+void TaskQueue::push_back(Task *task){
+    task->previous_ = last_;
+    task->next_ = nullptr;
+    if(last_){
+        last_->next_ = task;
+    }else{
+        first_ = task;
+    }
+    last_ = task;
+    ++size_;
+}
+
+void TaskQueue::push_front(Task *task){
+    task->previous_ = nullptr;
+    task->next_ = first_;
+    if(first_){
+        first_->previous_ = task;
+    }else{
+        last_ = task;
+    }
+    first_ = task;
+    ++size_;
+}
+
+Task *TaskQueue::pop_front(){
+    Task *task = first_;
+    if(task){
+        first_ = task->next_;
+        if(first_){
+            first_->previous_ = nullptr;
+        }else{
+            last_ = nullptr;
+        }
+        task->next_ = nullptr;
+        --size_;
+    }
+    return task;
+}
+
+Task *TaskQueue::pop_back(){
+    Task *task = last_;
+    if(task){
+        last_ = task->previous_;
+        if(last_){
+            last_->next_ = nullptr;
+        }else{
+            first_ = nullptr;
+        }
+        task->previous_ = nullptr;
+        --size_;
+    }
+    return task;
+}
+
+void TaskQueue::splice_back(TaskQueue &queue){
+    if(queue.first_){
+        if(last_){
+            last_->next_ = queue.first_;
+            queue.first_->previous_ = last_;
+        }else{
+            first_ = queue.first_;
+        }
+        last_ = queue.last_;
+        size_ += queue.size_;
+        queue.first_ = nullptr;
+        queue.last_ = nullptr;
+        queue.size_ = 0;
+    }
+}
+
+void TaskQueue::splice_front(TaskQueue &queue){
+    if(queue.first_){
+        if(first_){
+            first_->previous_ = queue.last_;
+            queue.last_->next_ = first_;
+        }else{
+            last_ = queue.last_;
+        }
+        first_ = queue.first_;
+        size_ += queue.size_;
+        queue.first_ = nullptr;
+        queue.last_ = nullptr;
+        queue.size_ = 0;
+    }
+}
+
+size_t TaskQueue::transfer_front(TaskQueue &queue, size_t count){
+    size_t transferred = 0;
+    Task *task;
+    while(transferred < count && (task = pop_front())){
+        queue.push_back(task);
+        ++transferred;
+    }
+    return transferred;
+}
+
+TaskAllocator::TaskAllocator() : mutex_(), free_tasks_(), allocation_count_(){
+}
+
+TaskAllocator::~TaskAllocator(){
+    Task *task;
+    while((task = free_tasks_.pop_front())){
+        delete task;
+    }
+}
+
+Task *TaskAllocator::acquire(){
+    {
+        lock_guard<mutex> guard{mutex_};
+        Task *task = free_tasks_.pop_front();
+        if(task){
+            return task;
+        }
+    }
+    ++allocation_count_;
+    return new Task{};
+}
+
+void TaskAllocator::release(Task *task){
+    task->reset();
+    lock_guard<mutex> guard{mutex_};
+    free_tasks_.push_front(task);
+}
+
+void TaskAllocator::acquire(TaskQueue &queue, size_t count){
+    {
+        lock_guard<mutex> guard{mutex_};
+        if(free_tasks_.transfer_front(queue, count) > 0){
+            return;
+        }
+    }
+    ++allocation_count_;
+    queue.push_back(new Task{});
+}
+
+void TaskAllocator::release(TaskQueue &queue){
+    lock_guard<mutex> guard{mutex_};
+    free_tasks_.splice_front(queue);
+}
+
+size_t TaskAllocator::allocation_count() const{
+    return allocation_count_;
+}
+
+TaskCache::TaskCache(TaskAllocator &allocator) : allocator_(allocator), free_tasks_(){
+}
+
+TaskCache::~TaskCache(){
+    allocator_.release(free_tasks_);
+}
+
+Task *TaskCache::acquire(){
+    if(free_tasks_.empty()){
+        allocator_.acquire(free_tasks_, batch_size);
+    }
+    return free_tasks_.pop_front();
+}
+
+void TaskCache::release(Task *task){
+    task->reset();
+    free_tasks_.push_front(task);
+    if(free_tasks_.size() > 2 * batch_size){
+        TaskQueue surplus;
+        free_tasks_.transfer_front(surplus, batch_size);
+        allocator_.release(surplus);
+    }
+}
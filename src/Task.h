@@ -0,0 +1,356 @@
+///
+/// \file contains the type erased task representation shared by the executors
+///
+
+#ifndef GAME_TASK_H
+#define	GAME_TASK_H
+
+#include "Object.h"
+
+#include <cstddef>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Game{
+
+    class TaskQueue;
+
+    class TaskAllocator;
+
+    class TaskCache;
+
+    ///
+    /// \class A type erased callable with no parameters or return type
+    /// Small callables are stored inside the task itself, larger ones are allocated on the heap.
+    /// Tasks are recycled by a TaskAllocator and can be linked into exactly one TaskQueue at a time.
+    ///
+    class Task{
+    public:
+
+        ///
+        /// the maximum size in bytes of a callable that is stored without a heap allocation
+        ///
+        static const std::size_t inline_capacity = 48;
+
+        ///
+        /// Creates an empty task
+        ///
+        Task();
+
+        ///
+        /// Destroys the task and its callable
+        ///
+        ~Task();
+
+        ///
+        /// Stores a callable in this task, the task should be empty
+        /// \param callable a callable object with no parameters or return type
+        /// \return true if the callable is stored inline, false if it was allocated on the heap
+        ///
+        template<typename T> bool assign(T &&callable){
+            using Callable = typename std::decay<T>::type;
+            return store<Callable>(std::forward<T>(callable), std::integral_constant<bool, sizeof(Callable) <= inline_capacity && alignof(Callable) <= alignof(std::max_align_t)>{});
+        };
+        
+        ///
+        /// Calls the stored callable
+        ///
+        void execute();
+
+        ///
+        /// Destroys the stored callable and forgets the queue time, the task will be empty after this call
+        ///
+        void reset();
+
+        ///
+        /// \return true if no callable is stored, false otherwise
+        ///
+        bool empty() const;
+
+        ///
+        /// \return the time the task was last queued, as recorded by the executor
+        ///
+        TimePoint queued_at() const;
+
+        ///
+        /// Records the time the task was queued, executors that do not measure queue wait times can ignore this
+        /// \param time the time
+        ///
+        void queued_at(TimePoint time);
+
+    private:
+
+        using Storage = std::aligned_storage<inline_capacity, alignof(std::max_align_t)>::type;
+
+        struct Operations{
+            void (*execute)(void *storage);
+            void (*destroy)(void *storage);
+        };
+
+        template<typename Callable> struct InlineOperations{
+            static void execute(void *storage){
+                (*static_cast<Callable *>(storage))();
+            };
+
+            static void destroy(void *storage){
+                static_cast<Callable *>(storage)->~Callable();
+            };
+
+            static const Operations operations;
+        };
+
+        template<typename Callable> struct HeapOperations{
+            static void execute(void *storage){
+                (**static_cast<Callable **>(storage))();
+            };
+
+            static void destroy(void *storage){
+                delete *static_cast<Callable **>(storage);
+            };
+
+            static const Operations operations;
+        };
+
+        template<typename Callable, typename T> bool store(T &&callable, std::true_type){
+            new (&storage_) Callable(std::forward<T>(callable));
+            operations_ = &InlineOperations<Callable>::operations;
+            return true;
+        };
+
+        template<typename Callable, typename T> bool store(T &&callable, std::false_type){
+            *reinterpret_cast<Callable **>(&storage_) = new Callable(std::forward<T>(callable));
+            operations_ = &HeapOperations<Callable>::operations;
+            return false;
+        };
+
+        Storage storage_;
+        const Operations *operations_;
+        TimePoint queued_at_;
+        Task *previous_;
+        Task *next_;
+
+        friend class TaskQueue;
+
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+    };
+
+    template<typename Callable> const Task::Operations Task::InlineOperations<Callable>::operations{&Task::InlineOperations<Callable>::execute, &Task::InlineOperations<Callable>::destroy};
+
+    template<typename Callable> const Task::Operations Task::HeapOperations<Callable>::operations{&Task::HeapOperations<Callable>::execute, &Task::HeapOperations<Callable>::destroy};
+
+    ///
+    /// \class An intrusive double ended queue of tasks
+    /// This class is not thread safe and never allocates memory.
+    /// The queue does not own its tasks: they should be removed before the queue is destroyed.
+    ///
+    class TaskQueue{
+    public:
+
+        ///
+        /// Creates an empty queue
+        ///
+        TaskQueue();
+
+        TaskQueue(TaskQueue &&queue);
+
+        TaskQueue &operator=(TaskQueue &&queue);
+
+        ///
+        /// \return true if the queue contains no tasks
+        ///
+        bool empty() const;
+
+        ///
+        /// \return the amount of tasks in the queue
+        ///
+        std::size_t size() const;
+
+        ///
+        /// \return the first task in the queue or nullptr if the queue is empty
+        ///
+        Task *front() const;
+
+        ///
+        /// \param task a task that is not part of any queue
+        ///
+        void push_back(Task *task);
+
+        ///
+        /// \param task a task that is not part of any queue
+        ///
+        void push_front(Task *task);
+
+        ///
+        /// Removes the first task from the queue
+        /// \return the removed task or nullptr if the queue was empty
+        ///
+        Task *pop_front();
+
+        ///
+        /// Removes the last task from the queue
+        /// \return the removed task or nullptr if the queue was empty
+        ///
+        Task *pop_back();
+
+        ///
+        /// Moves all tasks from the other queue to the back of this queue, preserving their order
+        /// \param queue the other queue, will be empty after this call
+        ///
+        void splice_back(TaskQueue &queue);
+
+        ///
+        /// Moves all tasks from the other queue to the front of this queue, preserving their order
+        /// \param queue the other queue, will be empty after this call
+        ///
+        void splice_front(TaskQueue &queue);
+
+        ///
+        /// Moves at most count tasks from the front of this queue to the back of the other queue
+        /// \param queue the other queue
+        /// \param count the maximum amount of tasks to move
+        /// \return the amount of tasks moved
+        ///
+        std::size_t transfer_front(TaskQueue &queue, std::size_t count);
+
+    private:
+        Task *first_;
+        Task *last_;
+        std::size_t size_;
+
+        TaskQueue(const TaskQueue &) = delete;
+        TaskQueue &operator=(const TaskQueue &) = delete;
+    };
+
+    ///
+    /// \class A thread safe pool of recycled tasks
+    /// Tasks are only allocated when no recycled task is available, so a steady workload performs no allocations.
+    ///
+    class TaskAllocator{
+    public:
+
+        ///
+        /// Creates an empty pool
+        ///
+        TaskAllocator();
+
+        ///
+        /// Destroys the pool and all recycled tasks
+        ///
+        ~TaskAllocator();
+
+        ///
+        /// Creates a task for the callable, reusing a recycled task if available
+        /// \param callable a callable object with no parameters or return type
+        /// \return a new task
+        ///
+        template<typename T> Task *create(T &&callable){
+            return assign(acquire(), std::forward<T>(callable));
+        };
+
+        ///
+        /// Stores a callable in an empty task and records the allocation if the callable does not fit inline
+        /// If the callable can not be copied, the task is recycled and the error is rethrown
+        /// \param task an empty task
+        /// \param callable a callable object with no parameters or return type
+        /// \return the task
+        ///
+        template<typename T> Task *assign(Task *task, T &&callable){
+            try{
+                if(!task->assign(std::forward<T>(callable))){
+                    ++allocation_count_;
+                }
+                return task;
+            }catch(...){
+                release(task);
+                throw;
+            }
+        };
+
+        ///
+        /// \return an empty task
+        ///
+        Task *acquire();
+
+        ///
+        /// Destroys the task's callable and recycles the task
+        /// \param task the task
+        ///
+        void release(Task *task);
+
+        ///
+        /// Moves at most count recycled tasks into the queue, allocating one if none are available
+        /// \param queue the queue to add the empty tasks to
+        /// \param count the maximum amount of tasks
+        ///
+        void acquire(TaskQueue &queue, std::size_t count);
+
+        ///
+        /// Recycles all tasks in the queue, the tasks should be empty
+        /// \param queue the queue, will be empty after this call
+        ///
+        void release(TaskQueue &queue);
+
+        ///
+        /// \return the total amount of heap allocations (tasks and callables too large to be stored inline) performed by this pool
+        ///
+        std::size_t allocation_count() const;
+
+    private:
+        std::mutex mutex_;
+        TaskQueue free_tasks_;
+        std::atomic<std::size_t> allocation_count_;
+
+        TaskAllocator(const TaskAllocator &) = delete;
+        TaskAllocator &operator=(const TaskAllocator &) = delete;
+    };
+
+    ///
+    /// \class A small unsynchronized cache of recycled tasks in front of a TaskAllocator
+    /// A cache should only be used by a single thread, it exchanges tasks with the allocator in batches.
+    ///
+    class TaskCache{
+    public:
+
+        ///
+        /// the amount of tasks exchanged with the allocator at once
+        ///
+        static const std::size_t batch_size = 64;
+
+        ///
+        /// Creates an empty cache
+        /// \param allocator the allocator to exchange tasks with, should outlive this cache
+        ///
+        explicit TaskCache(TaskAllocator &allocator);
+
+        ///
+        /// Returns all cached tasks to the allocator
+        ///
+        ~TaskCache();
+
+        ///
+        /// \return an empty task
+        ///
+        Task *acquire();
+
+        ///
+        /// Destroys the task's callable and recycles the task
+        /// \param task the task
+        ///
+        void release(Task *task);
+
+    private:
+        TaskAllocator &allocator_;
+        TaskQueue free_tasks_;
+
+        TaskCache(const TaskCache &) = delete;
+        TaskCache &operator=(const TaskCache &) = delete;
+    };
+
+}
+
+#endif	/* GAME_TASK_H */
+
@@ -0,0 +1,141 @@
+#include "TaskGraph.h"
+
+#include <future>
+#include <stdexcept>
+
+using namespace Game;
+using namespace std;
+
+TaskGraph::Vertex::Vertex(Action &&action_) : action(move(action_)), successors(), predecessor_count(), pending_count(){
+}
+
+TaskGraph::TaskGraph() : vertices_(), roots_(), validated_(true), pool_(), group_(), priority_(TaskPriority::FRAME_CRITICAL), failed_(false), reached_count_(), mutex_(), error_(){
+}
+
+TaskGraph::Node TaskGraph::add(Action action){
+    vertices_.emplace_back(new Vertex{move(action)});
+    validated_ = false;
+    return vertices_.size() - 1;
+}
+
+void TaskGraph::precede(Node before, Node after){
+    if(before >= vertices_.size() || after >= vertices_.size()){
+        throw out_of_range{"task graph node does not exist"};
+    }
+    vertices_[before]->successors.push_back(after);
+    ++vertices_[after]->predecessor_count;
+    validated_ = false;
+}
+
+size_t TaskGraph::size() const{
+    return vertices_.size();
+}
+
+void TaskGraph::clear(){
+    vertices_.clear();
+    roots_.clear();
+    validated_ = true;
+}
+
+void TaskGraph::validate(){
+    if(validated_){
+        return;
+    }
+    // Kahn's algorithm: every node is reached exactly once if and only if there are no cycles
+    roots_.clear();
+    vector<size_t> pending_counts(vertices_.size());
+    vector<Node> ready;
+    for(Node node = 0; node < vertices_.size(); ++node){
+        pending_counts[node] = vertices_[node]->predecessor_count;
+        if(pending_counts[node] == 0){
+            roots_.push_back(node);
+            ready.push_back(node);
+        }
+    }
+    size_t reached_count = 0;
+    while(!ready.empty()){
+        Node node = ready.back();
+        ready.pop_back();
+        ++reached_count;
+        for(Node successor : vertices_[node]->successors){
+            if(--pending_counts[successor] == 0){
+                ready.push_back(successor);
+            }
+        }
+    }
+    if(reached_count != vertices_.size()){
+        throw logic_error{"task graph contains a cycle"};
+    }
+    validated_ = true;
+}
+
+void TaskGraph::run(FixedThreadPool &pool, TaskPriority priority){
+    validate();
+    if(vertices_.empty()){
+        return;
+    }
+    for(unique_ptr<Vertex> &vertex : vertices_){
+        vertex->pending_count = vertex->predecessor_count;
+    }
+    failed_ = false;
+    reached_count_ = 0;
+    error_ = nullptr;
+    {
+        TaskGroup group;
+        pool_ = &pool;
+        group_ = &group;
+        priority_ = priority;
+        for(Node root : roots_){
+            submit(root);
+        }
+        pool.wait(group);
+    }
+    pool_ = nullptr;
+    group_ = nullptr;
+    if(error_){
+        rethrow_exception(error_);
+    }
+    if(reached_count_ != vertices_.size()){
+        throw future_error{future_errc::broken_promise};
+    }
+}
+
+void TaskGraph::submit(Node node){
+    pool_->submit(*group_, [this, node](){
+        execute(node);
+    }, priority_);
+}
+
+void TaskGraph::execute(Node node){
+    while(node != no_node){
+        Vertex &vertex = *vertices_[node];
+        ++reached_count_;
+        if(!failed_){
+            try{
+                vertex.action();
+            }catch(...){
+                fail(current_exception());
+            }
+        }
+        // the first enabled successor continues on this thread, saving a trip through the queue
+        Node next = no_node;
+        for(Node successor : vertex.successors){
+            if(--vertices_[successor]->pending_count == 0){
+                if(next == no_node){
+                    next = successor;
+                }else{
+                    submit(successor);
+                }
+            }
+        }
+        node = next;
+    }
+}
+
+void TaskGraph::fail(exception_ptr error){
+    lock_guard<mutex> guard{mutex_};
+    if(!error_){
+        error_ = error;
+    }
+    failed_ = true;
+}
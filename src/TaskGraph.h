@@ -0,0 +1,122 @@
+///
+/// \file contains a dependency graph of tasks that is executed on a thread pool
+///
+
+#ifndef GAME_TASK_GRAPH_H
+#define	GAME_TASK_GRAPH_H
+
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <exception>
+
+namespace Game{
+
+    ///
+    /// \class A directed acyclic graph of tasks
+    /// Every node runs as soon as all of its predecessors have finished. The graph is built once and can be run any number of times,
+    /// e.g. once per tick, without rebuilding it: running only resets a counter per node and submits tasks to the pool.
+    /// Building a graph is not thread safe and a graph should not be run by several threads at once.
+    ///
+    class TaskGraph{
+    public:
+
+        ///
+        /// \typedef identifies a node of the graph
+        ///
+        using Node = std::size_t;
+
+        ///
+        /// \typedef the action of a node
+        ///
+        using Action = std::function<void ()>;
+
+        ///
+        /// Creates an empty graph
+        ///
+        TaskGraph();
+
+        ///
+        /// Adds a node without any edges
+        /// \param action the action to run
+        /// \return the new node
+        ///
+        Node add(Action action);
+
+        ///
+        /// Adds an edge: the second node only runs after the first one has finished
+        /// \param before the first node
+        /// \param after the second node
+        /// \throw std::out_of_range if one of the nodes is not part of this graph
+        ///
+        void precede(Node before, Node after);
+
+        ///
+        /// \return the amount of nodes
+        ///
+        std::size_t size() const;
+
+        ///
+        /// Removes all nodes and edges
+        ///
+        void clear();
+
+        ///
+        /// Runs all nodes on the pool and blocks until they have finished
+        /// The calling thread executes nodes while waiting, so this function can also be called from a worker or with a stopped pool
+        /// A node that directly enables another node continues with it on the same thread, other enabled nodes are submitted to the pool
+        /// If a node throws, no further nodes are started and the first error is rethrown after the running nodes have finished
+        /// If a node is destroyed without running (e.g. by clear()), its successors cannot run either and a std::future_error (broken_promise) is thrown
+        /// \param pool the pool to run the nodes on
+        /// \param priority the priority lane of the nodes
+        /// \throw std::logic_error if the graph contains a cycle
+        ///
+        void run(FixedThreadPool &pool, TaskPriority priority = TaskPriority::FRAME_CRITICAL);
+
+    private:
+
+        static const Node no_node = static_cast<Node>(-1);
+
+        struct Vertex{
+            explicit Vertex(Action &&action);
+
+            Action action;
+            std::vector<Node> successors;
+            std::size_t predecessor_count;
+            std::atomic<std::size_t> pending_count;
+        };
+
+        std::vector<std::unique_ptr<Vertex>> vertices_;
+        std::vector<Node> roots_;
+        bool validated_;
+
+        FixedThreadPool *pool_;
+        TaskGroup *group_;
+        TaskPriority priority_;
+        std::atomic<bool> failed_;
+        // the nodes reached during the current run, fewer than all nodes if the pool destroyed a queued node
+        std::atomic<std::size_t> reached_count_;
+        std::mutex mutex_;
+        std::exception_ptr error_;
+
+        void validate();
+
+        void execute(Node node);
+
+        void submit(Node node);
+
+        void fail(std::exception_ptr error);
+
+        TaskGraph(const TaskGraph &) = delete;
+        TaskGraph &operator=(const TaskGraph &) = delete;
+    };
+
+}
+
+#endif	/* GAME_TASK_GRAPH_H */
+
@@ -0,0 +1,189 @@
+#include "Telemetry.h"
+
+#include <chrono>
+
+using namespace Game;
+using namespace std;
+
+const size_t LatencyDistribution::bucket_count;
+
+LatencyDistribution::LatencyDistribution() : counts(), count(), total(Duration::zero()), maximum(Duration::zero()){
+}
+
+Duration LatencyDistribution::bucket_upper_bound(size_t bucket){
+    return chrono::duration_cast<Duration>(chrono::nanoseconds(uint64_t{1} << bucket));
+}
+
+void LatencyDistribution::merge(const LatencyDistribution &distribution){
+    for(size_t bucket = 0; bucket < bucket_count; ++bucket){
+        counts[bucket] += distribution.counts[bucket];
+    }
+    count += distribution.count;
+    total += distribution.total;
+    maximum = max(maximum, distribution.maximum);
+}
+
+Duration LatencyDistribution::mean() const{
+    return count == 0 ? Duration::zero() : total / static_cast<Duration::rep>(count);
+}
+
+Duration LatencyDistribution::percentile(double fraction) const{
+    if(count == 0){
+        return Duration::zero();
+    }
+    uint64_t rank = static_cast<uint64_t>(fraction * count);
+    uint64_t seen = 0;
+    for(size_t bucket = 0; bucket < bucket_count; ++bucket){
+        seen += counts[bucket];
+        if(seen > rank){
+            // the upper bound of the last bucket is meaningless, the maximum is a better estimate
+            return bucket + 1 == bucket_count ? maximum : min(bucket_upper_bound(bucket), maximum);
+        }
+    }
+    return maximum;
+}
+
+LatencyHistogram::LatencyHistogram() : counts_(), total_(), maximum_(){
+    reset();
+}
+
+void LatencyHistogram::record(Duration duration){
+    int64_t nanoseconds = chrono::duration_cast<chrono::nanoseconds>(duration).count();
+    uint64_t sample = nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0;
+    size_t bucket = 0;
+    for(uint64_t remaining = sample; remaining > 0 && bucket + 1 < LatencyDistribution::bucket_count; remaining >>= 1){
+        ++bucket;
+    }
+    counts_[bucket].fetch_add(1, memory_order_relaxed);
+    total_.fetch_add(sample, memory_order_relaxed);
+    uint64_t maximum = maximum_.load(memory_order_relaxed);
+    while(sample > maximum && !maximum_.compare_exchange_weak(maximum, sample, memory_order_relaxed)){
+    }
+}
+
+void LatencyHistogram::reset(){
+    for(atomic<uint64_t> &count : counts_){
+        count.store(0, memory_order_relaxed);
+    }
+    total_.store(0, memory_order_relaxed);
+    maximum_.store(0, memory_order_relaxed);
+}
+
+LatencyDistribution LatencyHistogram::snapshot() const{
+    LatencyDistribution distribution;
+    for(size_t bucket = 0; bucket < LatencyDistribution::bucket_count; ++bucket){
+        distribution.counts[bucket] = counts_[bucket].load(memory_order_relaxed);
+        distribution.count += distribution.counts[bucket];
+    }
+    distribution.total = chrono::duration_cast<Duration>(chrono::nanoseconds(total_.load(memory_order_relaxed)));
+    distribution.maximum = chrono::duration_cast<Duration>(chrono::nanoseconds(maximum_.load(memory_order_relaxed)));
+    return distribution;
+}
+
+WorkerStatistics::WorkerStatistics() : submitted_count(), executed_count(), busy_time(Duration::zero()), idle_time(Duration::zero()){
+}
+
+WorkerTelemetry::WorkerTelemetry() : submitted_count_(), executed_count_(), busy_time_(), idle_time_(), queue_wait_(), execution_(){
+    reset();
+}
+
+void WorkerTelemetry::submitted(size_t count){
+    submitted_count_.fetch_add(count, memory_order_relaxed);
+}
+
+void WorkerTelemetry::executed(){
+    executed_count_.fetch_add(1, memory_order_relaxed);
+}
+
+void WorkerTelemetry::executed(TimePoint queued_at, TimePoint started_at, TimePoint finished_at){
+    executed_count_.fetch_add(1, memory_order_relaxed);
+    if(queued_at != TimePoint{}){
+        queue_wait_.record(started_at - queued_at);
+    }
+    execution_.record(finished_at - started_at);
+    busy_time_.fetch_add((finished_at - started_at).count(), memory_order_relaxed);
+}
+
+void WorkerTelemetry::idled(Duration duration){
+    idle_time_.fetch_add(duration.count(), memory_order_relaxed);
+}
+
+void WorkerTelemetry::reset(){
+    submitted_count_.store(0, memory_order_relaxed);
+    executed_count_.store(0, memory_order_relaxed);
+    busy_time_.store(0, memory_order_relaxed);
+    idle_time_.store(0, memory_order_relaxed);
+    queue_wait_.reset();
+    execution_.reset();
+}
+
+WorkerStatistics WorkerTelemetry::statistics() const{
+    WorkerStatistics statistics;
+    statistics.submitted_count = submitted_count_.load(memory_order_relaxed);
+    statistics.executed_count = executed_count_.load(memory_order_relaxed);
+    statistics.busy_time = Duration{busy_time_.load(memory_order_relaxed)};
+    statistics.idle_time = Duration{idle_time_.load(memory_order_relaxed)};
+    return statistics;
+}
+
+const LatencyHistogram &WorkerTelemetry::queue_wait() const{
+    return queue_wait_;
+}
+
+const LatencyHistogram &WorkerTelemetry::execution() const{
+    return execution_;
+}
+
+ThreadPoolStatistics::ThreadPoolStatistics() : workers(), callers(), critical_queue_depth(), background_queue_depth(), thread_count(), queue_wait(), execution(){
+}
+
+uint64_t ThreadPoolStatistics::submitted_count() const{
+    uint64_t count = callers.submitted_count;
+    for(const WorkerStatistics &worker : workers){
+        count += worker.submitted_count;
+    }
+    return count;
+}
+
+uint64_t ThreadPoolStatistics::executed_count() const{
+    uint64_t count = callers.executed_count;
+    for(const WorkerStatistics &worker : workers){
+        count += worker.executed_count;
+    }
+    return count;
+}
+
+static ostream &print_duration(ostream &output, Duration duration){
+    return output << chrono::duration_cast<chrono::duration<double, micro>>(duration).count() << "us";
+}
+
+static void print_worker(ostream &output, const WorkerStatistics &worker){
+    output << "submitted " << worker.submitted_count << ", executed " << worker.executed_count << ", busy ";
+    print_duration(output, worker.busy_time) << ", idle ";
+    print_duration(output, worker.idle_time) << endl;
+}
+
+static void print_distribution(ostream &output, const LatencyDistribution &distribution){
+    output << distribution.count << " samples, mean ";
+    print_duration(output, distribution.mean()) << ", p50 ";
+    print_duration(output, distribution.percentile(0.5)) << ", p99 ";
+    print_duration(output, distribution.percentile(0.99)) << ", max ";
+    print_duration(output, distribution.maximum) << endl;
+}
+
+ostream &Game::operator<<(ostream &output, const ThreadPoolStatistics &statistics){
+    output << "tasks: submitted " << statistics.submitted_count() << ", executed " << statistics.executed_count() << endl;
+    output << "queue depth: critical " << statistics.critical_queue_depth << ", background " << statistics.background_queue_depth << endl;
+    output << "threads: " << statistics.thread_count << endl;
+    output << "queue wait: ";
+    print_distribution(output, statistics.queue_wait);
+    output << "execution: ";
+    print_distribution(output, statistics.execution);
+    for(size_t i = 0; i < statistics.workers.size(); ++i){
+        output << "worker " << i << ": ";
+        print_worker(output, statistics.workers[i]);
+    }
+    output << "callers: ";
+    print_worker(output, statistics.callers);
+    return output;
+}
@@ -0,0 +1,283 @@
+///
+/// \file contains counters and latency histograms that are cheap to update from many threads
+///
+
+#ifndef GAME_TELEMETRY_H
+#define	GAME_TELEMETRY_H
+
+#include "Object.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <ostream>
+
+namespace Game{
+
+    ///
+    /// \class A copy of the contents of a latency histogram at some point in time
+    /// Bucket 0 holds durations below 1ns, bucket i holds durations of at least 2^(i-1)ns and below 2^i ns, the last bucket holds all longer durations
+    ///
+    struct LatencyDistribution{
+
+        ///
+        /// the amount of buckets
+        ///
+        static const std::size_t bucket_count = 40;
+
+        ///
+        /// Creates an empty distribution
+        ///
+        LatencyDistribution();
+
+        ///
+        /// \param bucket the index of a bucket
+        /// \return the smallest duration that does not fit the bucket anymore
+        ///
+        static Duration bucket_upper_bound(std::size_t bucket);
+
+        ///
+        /// Adds the samples of another distribution
+        /// \param distribution the other distribution
+        ///
+        void merge(const LatencyDistribution &distribution);
+
+        ///
+        /// \return the average duration, or zero if there are no samples
+        ///
+        Duration mean() const;
+
+        ///
+        /// Estimates a percentile with the upper bound of the bucket it falls in
+        /// \param fraction the percentile as a fraction, e.g. 0.99
+        /// \return the estimated duration, or zero if there are no samples
+        ///
+        Duration percentile(double fraction) const;
+
+        ///
+        /// the amount of samples per bucket
+        ///
+        std::array<std::uint64_t, bucket_count> counts;
+
+        ///
+        /// the amount of samples
+        ///
+        std::uint64_t count;
+
+        ///
+        /// the sum of all samples
+        ///
+        Duration total;
+
+        ///
+        /// the longest sample
+        ///
+        Duration maximum;
+    };
+
+    ///
+    /// \class A histogram of durations with power of two buckets
+    /// Recording only performs relaxed atomic operations, so it can be shared by threads, though it is cheapest when every thread records into its own histogram.
+    ///
+    class LatencyHistogram{
+    public:
+
+        ///
+        /// Creates an empty histogram
+        ///
+        LatencyHistogram();
+
+        ///
+        /// Adds a sample
+        /// \param duration the sample, negative durations count as zero
+        ///
+        void record(Duration duration);
+
+        ///
+        /// Removes all samples, samples recorded concurrently may be partially removed
+        ///
+        void reset();
+
+        ///
+        /// \return the current contents, samples recorded concurrently may be partially included
+        ///
+        LatencyDistribution snapshot() const;
+
+    private:
+        std::array<std::atomic<std::uint64_t>, LatencyDistribution::bucket_count> counts_;
+        std::atomic<std::uint64_t> total_;
+        std::atomic<std::uint64_t> maximum_;
+
+        LatencyHistogram(const LatencyHistogram &) = delete;
+        LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+    };
+
+    ///
+    /// \class The counters of a single thread of a thread pool
+    ///
+    struct WorkerStatistics{
+
+        ///
+        /// Creates statistics without any activity
+        ///
+        WorkerStatistics();
+
+        ///
+        /// the amount of tasks submitted by the thread
+        ///
+        std::uint64_t submitted_count;
+
+        ///
+        /// the amount of tasks executed by the thread
+        ///
+        std::uint64_t executed_count;
+
+        ///
+        /// the time spent executing timed tasks, a task that executes other tasks while waiting includes their time
+        ///
+        Duration busy_time;
+
+        ///
+        /// the time spent looking for or waiting on work while timings are collected
+        ///
+        Duration idle_time;
+    };
+
+    ///
+    /// \class The counters of a thread of a thread pool, updated by that thread and read by any thread
+    ///
+    class WorkerTelemetry{
+    public:
+
+        ///
+        /// Creates telemetry without any activity
+        ///
+        WorkerTelemetry();
+
+        ///
+        /// Counts submitted tasks
+        /// \param count the amount of tasks
+        ///
+        void submitted(std::size_t count);
+
+        ///
+        /// Counts an executed task without timing it
+        ///
+        void executed();
+
+        ///
+        /// Counts an executed task and records how long it took
+        /// \param queued_at the time the task was queued, or a default TimePoint if unknown
+        /// \param started_at the time the task started
+        /// \param finished_at the time the task finished
+        ///
+        void executed(TimePoint queued_at, TimePoint started_at, TimePoint finished_at);
+
+        ///
+        /// Adds idle time
+        /// \param duration the time spent looking for or waiting on work
+        ///
+        void idled(Duration duration);
+
+        ///
+        /// Resets all counters and histograms
+        ///
+        void reset();
+
+        ///
+        /// \return the current counters
+        ///
+        WorkerStatistics statistics() const;
+
+        ///
+        /// \return the time tasks spent queued
+        ///
+        const LatencyHistogram &queue_wait() const;
+
+        ///
+        /// \return the time tasks spent executing
+        ///
+        const LatencyHistogram &execution() const;
+
+    private:
+        std::atomic<std::uint64_t> submitted_count_;
+        std::atomic<std::uint64_t> executed_count_;
+        std::atomic<Duration::rep> busy_time_;
+        std::atomic<Duration::rep> idle_time_;
+        LatencyHistogram queue_wait_;
+        LatencyHistogram execution_;
+
+        WorkerTelemetry(const WorkerTelemetry &) = delete;
+        WorkerTelemetry &operator=(const WorkerTelemetry &) = delete;
+    };
+
+    ///
+    /// \class A snapshot of the activity of a thread pool since it was created or its statistics were reset
+    ///
+    struct ThreadPoolStatistics{
+
+        ///
+        /// Creates statistics without any activity
+        ///
+        ThreadPoolStatistics();
+
+        ///
+        /// \return the amount of submitted tasks
+        ///
+        std::uint64_t submitted_count() const;
+
+        ///
+        /// \return the amount of executed tasks
+        ///
+        std::uint64_t executed_count() const;
+
+        ///
+        /// the counters of every worker slot, retired workers keep their counters
+        ///
+        std::vector<WorkerStatistics> workers;
+
+        ///
+        /// the counters of all threads that are not workers, e.g. threads that submit tasks or execute them while waiting
+        ///
+        WorkerStatistics callers;
+
+        ///
+        /// the amount of queued tasks in the frame critical lane
+        ///
+        std::size_t critical_queue_depth;
+
+        ///
+        /// the amount of queued tasks in the background lane
+        ///
+        std::size_t background_queue_depth;
+
+        ///
+        /// the amount of worker threads that were running, elastic pools add and retire them with the load
+        ///
+        std::size_t thread_count;
+
+        ///
+        /// the time between submitting and starting timed tasks
+        ///
+        LatencyDistribution queue_wait;
+
+        ///
+        /// the time spent executing timed tasks
+        ///
+        LatencyDistribution execution;
+    };
+
+    ///
+    /// Prints the statistics in a human readable format
+    /// \param output the output stream
+    /// \param statistics the statistics to print
+    /// \return the output stream
+    ///
+    std::ostream &operator<<(std::ostream &output, const ThreadPoolStatistics &statistics);
+
+}
+
+#endif	/* GAME_TELEMETRY_H */
+
@@ -2,35 +2,399 @@
 
 #include <vector>
 #include <chrono>
-#include <list>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <future>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 using namespace Game;
 using namespace std;
 
-FixedThreadPool::Task::~Task(){}
+thread_local FixedThreadPool *FixedThreadPool::current_pool_ = nullptr;
+
+thread_local size_t FixedThreadPool::current_worker_index_ = 0;
+
+TaskGroup::TaskGroup() : mutex_(), condition_(), count_(){
+}
+
+TaskGroup::~TaskGroup(){
+    wait();
+}
+
+void TaskGroup::wait(){
+    unique_lock<mutex> lock{mutex_};
+    while(count_ > 0){
+        condition_.wait(lock);
+    }
+}
+
+bool TaskGroup::done() const{
+    return count_ == 0;
+}
+
+size_t TaskGroup::size() const{
+    return count_;
+}
+
+void TaskGroup::add(size_t count){
+    count_ += count;
+}
+
+void TaskGroup::complete(){
+    // the last task may not touch the group after a waiter has seen it finish, hence the lock
+    lock_guard<mutex> guard{mutex_};
+    if(--count_ == 0){
+        condition_.notify_all();
+    }
+}
+
+IdlePolicy::IdlePolicy() : spin_duration(Duration::zero()), yield_duration(Duration::zero()){
+}
+
+IdlePolicy::IdlePolicy(Duration spin_duration_, Duration yield_duration_) : spin_duration(spin_duration_), yield_duration(yield_duration_){
+}
+
+IdlePolicy IdlePolicy::park(){
+    return IdlePolicy{};
+}
+
+bool IdlePolicy::parks_immediately() const{
+    return spin_duration <= Duration::zero() && yield_duration <= Duration::zero();
+}
+
+WorkerPlacement::WorkerPlacement() : cpu_sets(), scratch_capacity(64 * 1024){
+}
+
+WorkerPlacement WorkerPlacement::floating(){
+    return WorkerPlacement{};
+}
+
+WorkerPlacement WorkerPlacement::cores(const CpuSet &cpus){
+    WorkerPlacement placement;
+    for(unsigned int cpu : cpus){
+        placement.cpu_sets.push_back(CpuSet{cpu});
+    }
+    return placement;
+}
+
+WorkerPlacement WorkerPlacement::numa_node(unsigned int node){
+    WorkerPlacement placement;
+    CpuSet cpus = numa_node_cpus(node);
+    if(!cpus.empty()){
+        placement.cpu_sets.push_back(move(cpus));
+    }
+    return placement;
+}
+
+WorkerPlacement WorkerPlacement::numa_nodes(){
+    WorkerPlacement placement;
+    unsigned int node_count = numa_node_count();
+    for(unsigned int node = 0; node < node_count; ++node){
+        CpuSet cpus = numa_node_cpus(node);
+        if(!cpus.empty()){
+            placement.cpu_sets.push_back(move(cpus));
+        }
+    }
+    return placement;
+}
+
+static string numa_node_path(unsigned int node){
+    return string{"/sys/devices/system/node/node"} + to_string(node) + "/cpulist";
+}
+
+unsigned int WorkerPlacement::numa_node_count(){
+    unsigned int node_count = 0;
+    while(ifstream{numa_node_path(node_count)}){
+        ++node_count;
+    }
+    return max(node_count, 1u);
+}
+
+WorkerPlacement::CpuSet WorkerPlacement::numa_node_cpus(unsigned int node){
+    // the kernel lists ranges, e.g. "0-7,16-23"
+    CpuSet cpus;
+    ifstream input{numa_node_path(node)};
+    string range;
+    while(getline(input, range, ',')){
+        istringstream range_input{range};
+        unsigned int first, last;
+        char separator;
+        if(!(range_input >> first)){
+            continue;
+        }
+        if(!(range_input >> separator >> last) || separator != '-'){
+            last = first;
+        }
+        for(unsigned int cpu = first; cpu <= last; ++cpu){
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+static void pin_current_thread(const WorkerPlacement::CpuSet &cpus){
+#ifdef __linux__
+    if(cpus.empty()){
+        return;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for(unsigned int cpu : cpus){
+        if(cpu < CPU_SETSIZE){
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    // failures (e.g. CPUs outside of the process' cgroup) leave the worker floating
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#endif
+}
+
+FixedThreadPool::ParallelContext::ParallelContext() : group_(), mutex_(), error_(){
+}
+
+TaskGroup &FixedThreadPool::ParallelContext::group(){
+    return group_;
+}
+
+void FixedThreadPool::ParallelContext::rethrow(){
+    if(error_){
+        rethrow_exception(error_);
+    }
+}
+
+void FixedThreadPool::ParallelContext::fail(exception_ptr error){
+    lock_guard<mutex> guard{mutex_};
+    if(!error_){
+        error_ = error;
+    }
+}
+
+FixedThreadPool::GroupGuard::GroupGuard(TaskGroup *group) : group_(group){
+}
+
+FixedThreadPool::GroupGuard::GroupGuard(GroupGuard &&guard) : group_(guard.group_){
+    guard.group_ = nullptr;
+}
+
+FixedThreadPool::GroupGuard::~GroupGuard(){
+    if(group_){
+        group_->complete();
+    }
+}
+
+FixedThreadPool::ChunkGuard::ChunkGuard(ParallelContext *context) : context_(context), executed_(false){
+}
+
+FixedThreadPool::ChunkGuard::ChunkGuard(ChunkGuard &&guard) : context_(guard.context_), executed_(guard.executed_){
+    guard.context_ = nullptr;
+}
+
+FixedThreadPool::ChunkGuard::~ChunkGuard(){
+    if(context_){
+        if(!executed_){
+            // the indices of the chunk were skipped, which the caller should know about
+            context_->fail(make_exception_ptr(future_error{future_errc::broken_promise}));
+        }
+        context_->group().complete();
+    }
+}
+
+FixedThreadPool::ParallelContext &FixedThreadPool::ChunkGuard::context() const{
+    return *context_;
+}
+
+void FixedThreadPool::ChunkGuard::executed(){
+    executed_ = true;
+}
+
+FixedThreadPool::WorkerQueue::WorkerQueue(TaskAllocator &allocator) : mutex(), tasks(), cache(allocator), critical_streak(), scratch(), telemetry(){
+}
+
+static const size_t critical_lane = static_cast<size_t>(TaskPriority::FRAME_CRITICAL);
+
+static const size_t background_lane = static_cast<size_t>(TaskPriority::BACKGROUND);
+
+static inline void cpu_relax(){
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+static size_t worker_count(FixedThreadPool::Scheduling scheduling, size_t thread_count){
+    bool runs_on_caller = scheduling == FixedThreadPool::Scheduling::INLINE || scheduling == FixedThreadPool::Scheduling::DETERMINISTIC;
+    if(scheduling == FixedThreadPool::Scheduling::WORK_STEALING && thread_count == 0){
+        // tasks are submitted to the queue of a worker, so there has to be at least one
+        throw invalid_argument{"a work stealing pool should have at least one worker thread"};
+    }
+    return runs_on_caller ? 0 : thread_count;
+}
 
-FixedThreadPool::FixedThreadPool(size_t max_thread_count) : threads_(max_thread_count), max_thread_count_(max_thread_count), state_(State::STOPPED), mutex_(), condition_(), tasks_(), scheduled_tasks_(){
+FixedThreadPool::FixedThreadPool(size_t max_thread_count, Scheduling scheduling, IdlePolicy idle_policy) : FixedThreadPool(max_thread_count, max_thread_count, Duration::zero(), Duration::zero(), scheduling, idle_policy){
+}
+
+FixedThreadPool::FixedThreadPool(size_t min_thread_count, size_t max_thread_count, Duration growth_threshold, Duration retire_timeout, Scheduling scheduling, IdlePolicy idle_policy) : threads_(worker_count(scheduling, max_thread_count)), min_thread_count_(min(min_thread_count, worker_count(scheduling, max_thread_count))), max_thread_count_(worker_count(scheduling, max_thread_count)), scheduling_(scheduling), idle_policy_(idle_policy), placement_(), growth_threshold_(growth_threshold), retire_timeout_(retire_timeout), state_(State::STOPPED), mutex_(), condition_(), task_allocator_(), tasks_(), scheduled_tasks_(), critical_streak_(), critical_burst_(16), queued_task_counts_(), worker_queues_(), timers_(), next_worker_queue_(), active_workers_(max_thread_count_), free_workers_(), thread_count_(), pressure_timer_(), pressure_armed_(false), sleeping_worker_count_(), unfinished_task_count_(), idle_waiter_count_(), idle_condition_(), collect_timings_(false), caller_telemetry_(){
+    for(size_t i = 0; i < max_thread_count_; ++i){
+        worker_queues_.emplace_back(new WorkerQueue{task_allocator_});
+    }
+    for(atomic<size_t> &count : queued_task_counts_){
+        count = 0;
+    }
+    if(elastic()){
+        // created up front, so the pressure timer can be scheduled while holding the pool's lock
+        timers_.reset(new TimerWheel{});
+    }
 }
 
 FixedThreadPool::~FixedThreadPool(){
+    {
+        lock_guard<mutex> guard{mutex_};
+        pressure_timer_.cancel();
+        pressure_timer_ = TimerHandle{};
+    }
+    // the timer thread submits tasks, so it has to be stopped first
+    timers_.reset();
     stop();
-    for(Task *task : scheduled_tasks_){
-        delete task;
+    release_tasks(scheduled_tasks_);
+}
+
+FixedThreadPool::Scheduling FixedThreadPool::scheduling() const{
+    return scheduling_;
+}
+
+const IdlePolicy &FixedThreadPool::idle_policy() const{
+    return idle_policy_;
+}
+
+WorkerPlacement FixedThreadPool::placement() const{
+    lock_guard<mutex> guard{mutex_};
+    return placement_;
+}
+
+void FixedThreadPool::placement(const WorkerPlacement &placement){
+    lock_guard<mutex> guard{mutex_};
+    placement_ = placement;
+}
+
+ScratchArena *FixedThreadPool::scratch(){
+    if(current_pool_ == this){
+        return worker_queues_[current_worker_index_]->scratch.get();
+    }else{
+        return nullptr;
     }
 }
 
+size_t FixedThreadPool::thread_count() const{
+    return thread_count_;
+}
+
+size_t FixedThreadPool::min_thread_count() const{
+    return min_thread_count_;
+}
+
+size_t FixedThreadPool::max_thread_count() const{
+    return max_thread_count_;
+}
+
+Duration FixedThreadPool::growth_threshold() const{
+    return growth_threshold_;
+}
+
+Duration FixedThreadPool::retire_timeout() const{
+    return retire_timeout_;
+}
+
+size_t FixedThreadPool::task_allocation_count() const{
+    return task_allocator_.allocation_count();
+}
+
+size_t FixedThreadPool::critical_burst() const{
+    return critical_burst_;
+}
+
+void FixedThreadPool::critical_burst(size_t critical_burst){
+    critical_burst_ = critical_burst;
+}
+
+size_t FixedThreadPool::queue_depth(TaskPriority priority) const{
+    return queued_task_counts_[static_cast<size_t>(priority)];
+}
+
+bool FixedThreadPool::collect_timings() const{
+    return collect_timings_;
+}
+
+void FixedThreadPool::collect_timings(bool enabled){
+    collect_timings_ = enabled;
+}
+
+ThreadPoolStatistics FixedThreadPool::statistics() const{
+    ThreadPoolStatistics statistics;
+    for(const unique_ptr<WorkerQueue> &queue : worker_queues_){
+        statistics.workers.push_back(queue->telemetry.statistics());
+        statistics.queue_wait.merge(queue->telemetry.queue_wait().snapshot());
+        statistics.execution.merge(queue->telemetry.execution().snapshot());
+    }
+    statistics.callers = caller_telemetry_.statistics();
+    statistics.queue_wait.merge(caller_telemetry_.queue_wait().snapshot());
+    statistics.execution.merge(caller_telemetry_.execution().snapshot());
+    statistics.critical_queue_depth = queue_depth(TaskPriority::FRAME_CRITICAL);
+    statistics.background_queue_depth = queue_depth(TaskPriority::BACKGROUND);
+    statistics.thread_count = thread_count();
+    return statistics;
+}
+
+void FixedThreadPool::reset_statistics(){
+    for(unique_ptr<WorkerQueue> &queue : worker_queues_){
+        queue->telemetry.reset();
+    }
+    caller_telemetry_.reset();
+}
+
+size_t FixedThreadPool::queued_task_count() const{
+    return queued_task_counts_[critical_lane] + queued_task_counts_[background_lane];
+}
+
 bool FixedThreadPool::start() {
     lock_guard<mutex> guard{mutex_};
     if(state_ == State::STOPPED){
-        
-        copy(scheduled_tasks_.begin(), scheduled_tasks_.end(), back_inserter(tasks_));
-        scheduled_tasks_.clear();
-        
-        for(size_t i = 0; i < max_thread_count_; ++i){
-            threads_.emplace_back(&FixedThreadPool::perform_tasks, this);
-        }
+
         state_ = State::RUNNING;
+        free_workers_.clear();
+        for(size_t i = max_thread_count_; i > 0; --i){
+            free_workers_.push_back(i - 1);
+        }
+        for(size_t i = 0; i < min_thread_count_; ++i){
+            spawn_worker();
+        }
+        if(thread_count_ == 0 && (!scheduled_tasks_[critical_lane].empty() || !scheduled_tasks_[background_lane].empty())){
+            spawn_worker();
+        }
+
+        for(size_t lane = 0; lane < lane_count; ++lane){
+            queued_task_counts_[lane] += scheduled_tasks_[lane].size();
+            if(scheduling_ == Scheduling::WORK_STEALING && !worker_queues_.empty()){
+                Task *task;
+                while((task = scheduled_tasks_[lane].pop_front())){
+                    worker_queues_[next_worker_queue()]->tasks[lane].push_back(task);
+                }
+            }else{
+                tasks_[lane].splice_back(scheduled_tasks_[lane]);
+            }
+        }
+        condition_.notify_all();
+
+        if(queued_task_count() > 0){
+            watch_pressure();
+        }
         return true;
     }else{
         return false;
@@ -42,44 +406,354 @@ bool FixedThreadPool::running() const{
     return state_ == State::RUNNING;
 }
 
-FixedThreadPool::Task* FixedThreadPool::claim_task() {
+Task* FixedThreadPool::claim_task(size_t worker_index) {
     unique_lock<mutex> lock{mutex_};
+    bool spun = false;
     while(true){
         if(state_ == State::RUNNING){
-            if(!tasks_.empty()){
-                Task *task = tasks_.front();
-                tasks_.pop_front();
+            Task *task = claim_lane_task(tasks_, critical_streak_, false);
+            if(task){
                 return task;
             }
-            condition_.wait(lock);
-        }else if(state_ == State::FINISHING){
-            if(tasks_.empty()){
+            if(!spun && !idle_policy_.parks_immediately()){
+                // the queue is checked again under the lock afterwards, so a notification sent while spinning is not lost
+                spun = true;
+                lock.unlock();
+                await_tasks();
+                lock.lock();
+                continue;
+            }
+            spun = false;
+            if(!elastic()){
+                condition_.wait(lock);
+            }else if(condition_.wait_for(lock, retire_timeout_) == cv_status::timeout && retire_worker(worker_index)){
                 return nullptr;
-            }else{
-                Task *task = tasks_.front();
-                tasks_.pop_front();
-                return task;
             }
+        }else if(state_ == State::FINISHING){
+            return claim_lane_task(tasks_, critical_streak_, false);
         }else{
             return nullptr;
         }
     }
 }
 
+Task *FixedThreadPool::claim_lane_task(Lanes &lanes, size_t &critical_streak, bool from_back){
+    TaskQueue &critical = lanes[critical_lane];
+    TaskQueue &background = lanes[background_lane];
+    size_t burst = critical_burst_;
+    size_t lane;
+    if(!background.empty() && (critical.empty() || (burst > 0 && critical_streak >= burst))){
+        lane = background_lane;
+        critical_streak = 0;
+    }else if(!critical.empty()){
+        lane = critical_lane;
+        if(!background.empty()){
+            ++critical_streak;
+        }
+    }else{
+        return nullptr;
+    }
+    --queued_task_counts_[lane];
+    return from_back ? lanes[lane].pop_back() : lanes[lane].pop_front();
+}
 
-void FixedThreadPool::perform_tasks(){
+Task* FixedThreadPool::claim_stolen_task(size_t worker_index){
+    bool spun = false;
+    while(true){
+        State state = state_;
+        if(state != State::RUNNING && state != State::FINISHING){
+            return nullptr;
+        }
+        Task *task = claim_worker_task(worker_index);
+        if(task){
+            return task;
+        }
+        if(state == State::FINISHING){
+            if(queued_task_count() == 0){
+                return nullptr;
+            }
+        }else if(!spun && !idle_policy_.parks_immediately()){
+            spun = true;
+            await_tasks();
+        }else{
+            spun = false;
+            // the sleeping count is published before the queued count is checked, and submitters
+            // increment the queued count before checking the sleeping count: no wake up can be lost
+            unique_lock<mutex> lock{mutex_};
+            ++sleeping_worker_count_;
+            while(state_ == State::RUNNING && queued_task_count() == 0){
+                if(!elastic()){
+                    condition_.wait(lock);
+                }else if(condition_.wait_for(lock, retire_timeout_) == cv_status::timeout && retire_worker(worker_index)){
+                    --sleeping_worker_count_;
+                    return nullptr;
+                }
+            }
+            --sleeping_worker_count_;
+        }
+    }
+}
+
+void FixedThreadPool::await_tasks() const{
+    // returns as soon as a task is queued or the pool stops running, the clock is only read every few iterations
+    // spinning is pointless on a single core, the submitting thread could not run in the meantime
+    static const bool can_spin = thread::hardware_concurrency() > 1;
+    TimePoint spin_end = Clock::now() + (can_spin ? idle_policy_.spin_duration : Duration::zero());
+    while(Clock::now() < spin_end){
+        for(size_t i = 0; i < 64; ++i){
+            if(queued_task_count() > 0 || state_ != State::RUNNING){
+                return;
+            }
+            cpu_relax();
+        }
+    }
+    TimePoint yield_end = Clock::now() + idle_policy_.yield_duration;
+    while(Clock::now() < yield_end){
+        if(queued_task_count() > 0 || state_ != State::RUNNING){
+            return;
+        }
+        this_thread::yield();
+    }
+}
+
+Task* FixedThreadPool::claim_worker_task(size_t worker_index){
+    // a worker index outside of the worker range claims on behalf of a thread that is not a worker
+    size_t unused_streak = 0;
+    bool own_queue = worker_index < worker_queues_.size();
+    size_t &critical_streak = own_queue ? worker_queues_[worker_index]->critical_streak : unused_streak;
+    size_t burst = critical_burst_;
+    bool background_first = burst > 0 && critical_streak >= burst && queued_task_counts_[background_lane] > 0;
+    size_t lanes[lane_count] = {background_first ? background_lane : critical_lane, background_first ? critical_lane : background_lane};
+    for(size_t lane : lanes){
+        if(queued_task_counts_[lane] == 0){
+            continue;
+        }
+        Task *task = own_queue ? pop_worker_task(worker_index, lane) : nullptr;
+        if(!task){
+            task = steal_worker_task(worker_index, lane);
+        }
+        if(task){
+            --queued_task_counts_[lane];
+            if(lane == background_lane){
+                critical_streak = 0;
+            }else if(queued_task_counts_[background_lane] > 0){
+                ++critical_streak;
+            }
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+Task* FixedThreadPool::pop_worker_task(size_t worker_index, size_t lane){
+    WorkerQueue &queue = *worker_queues_[worker_index];
+    lock_guard<mutex> guard{queue.mutex};
+    return queue.tasks[lane].pop_back();
+}
+
+Task* FixedThreadPool::steal_worker_task(size_t thief_index, size_t lane){
+    // a thief index outside of the worker range visits every queue
+    size_t queue_count = worker_queues_.size();
+    for(size_t i = 1; i <= queue_count; ++i){
+        size_t queue_index = (thief_index + i) % queue_count;
+        if(queue_index == thief_index){
+            continue;
+        }
+        WorkerQueue &queue = *worker_queues_[queue_index];
+        lock_guard<mutex> guard{queue.mutex};
+        Task *task = queue.tasks[lane].pop_front();
+        if(task){
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void FixedThreadPool::push_worker_task(size_t worker_index, Task* task, size_t lane){
+    WorkerQueue &queue = *worker_queues_[worker_index];
+    lock_guard<mutex> guard{queue.mutex};
+    queue.tasks[lane].push_back(task);
+}
+
+Task *FixedThreadPool::acquire_task(){
+    if(current_pool_ == this){
+        return worker_queues_[current_worker_index_]->cache.acquire();
+    }else{
+        return task_allocator_.acquire();
+    }
+}
+
+void FixedThreadPool::release_task(Task *task){
+    if(current_pool_ == this){
+        worker_queues_[current_worker_index_]->cache.release(task);
+    }else{
+        task_allocator_.release(task);
+    }
+}
+
+void FixedThreadPool::release_tasks(TaskQueue &tasks){
+    TaskQueue empty_tasks;
     Task *task;
-    while((task = claim_task())){
+    while((task = tasks.pop_front())){
+        task->reset();
+        empty_tasks.push_back(task);
+    }
+    task_allocator_.release(empty_tasks);
+}
+
+void FixedThreadPool::release_tasks(Lanes &lanes){
+    for(TaskQueue &tasks : lanes){
+        release_tasks(tasks);
+    }
+}
+
+Task *FixedThreadPool::try_claim_task(){
+    if(scheduling_ == Scheduling::WORK_STEALING){
+        Task *task = claim_worker_task(current_pool_ == this ? current_worker_index_ : worker_queues_.size());
+        if(task){
+            return task;
+        }
+    }
+    lock_guard<mutex> guard{mutex_};
+    if(state_ == State::STOPPED){
+        // scheduled tasks are not counted as queued
+        Task *task = scheduled_tasks_[critical_lane].pop_front();
+        return task ? task : scheduled_tasks_[background_lane].pop_front();
+    }else{
+        size_t unused_streak = 0;
+        return claim_lane_task(tasks_, current_pool_ == this ? critical_streak_ : unused_streak, false);
+    }
+}
+
+static void record_execution(WorkerTelemetry &telemetry, TimePoint queued_at, TimePoint started_at){
+    if(started_at == TimePoint{}){
+        telemetry.executed();
+    }else{
+        telemetry.executed(queued_at, started_at, Clock::now());
+    }
+}
+
+void FixedThreadPool::run_task(Task *task){
+    // a rewind instead of a reset: tasks can run nested inside another task waiting for a group
+    ScratchArena *arena = scratch();
+    size_t scratch_used = arena ? arena->used() : 0;
+    WorkerTelemetry &counters = telemetry();
+    TimePoint queued_at = task->queued_at();
+    TimePoint started_at = collect_timings_.load(memory_order_relaxed) ? Clock::now() : TimePoint{};
+    try{
+        task->execute();
+        record_execution(counters, queued_at, started_at);
+        if(arena){
+            arena->rewind(scratch_used);
+        }
+        release_task(task);
+        finish_tasks(1);
+    }catch(...){
+        record_execution(counters, queued_at, started_at);
+        if(arena){
+            arena->rewind(scratch_used);
+        }
+        release_task(task);
+        finish_tasks(1);
+        throw;
+    }
+}
+
+void FixedThreadPool::run_inline(Task *task) noexcept{
+    // like on a worker, an error escaping the task terminates the program
+    run_task(task);
+}
+
+bool FixedThreadPool::runs_on_caller() const{
+    return scheduling_ == Scheduling::INLINE || scheduling_ == Scheduling::DETERMINISTIC;
+}
+
+WorkerTelemetry &FixedThreadPool::telemetry(){
+    return current_pool_ == this ? worker_queues_[current_worker_index_]->telemetry : caller_telemetry_;
+}
+
+void FixedThreadPool::stamp(Task *task){
+    // tasks are stamped when growing the pool or the statistics need queue wait times
+    if(elastic() || collect_timings_.load(memory_order_relaxed)){
+        task->queued_at(Clock::now());
+    }
+}
+
+void FixedThreadPool::finish_tasks(size_t count){
+    // waiters are registered before they check the count, so either they see zero or they get notified
+    if((unfinished_task_count_ -= count) == 0 && idle_waiter_count_ > 0){
+        lock_guard<mutex> guard{mutex_};
+        idle_condition_.notify_all();
+    }
+}
+
+void FixedThreadPool::perform_tasks(size_t worker_index, WorkerPlacement::CpuSet cpus, size_t scratch_capacity){
+    pin_current_thread(cpus);
+    // allocated by the placed worker itself, so the memory is local to its node
+    unique_ptr<ScratchArena> &scratch = worker_queues_[worker_index]->scratch;
+    if(scratch_capacity == 0){
+        scratch.reset();
+    }else if(!scratch || scratch->capacity() != scratch_capacity){
+        scratch.reset(new ScratchArena{scratch_capacity});
+    }
+    current_pool_ = this;
+    current_worker_index_ = worker_index;
+    WorkerTelemetry &counters = worker_queues_[worker_index]->telemetry;
+    TimePoint idle_since = collect_timings_.load(memory_order_relaxed) ? Clock::now() : TimePoint{};
+    Task *task;
+    while((task = scheduling_ == Scheduling::WORK_STEALING ? claim_stolen_task(worker_index) : claim_task(worker_index))){
+        if(idle_since != TimePoint{}){
+            counters.idled(Clock::now() - idle_since);
+        }
         try{
-            task->execute();
-            delete task;
+            run_task(task);
         }catch(...){
-            delete task;
+            current_pool_ = nullptr;
             throw;
         }
+        idle_since = collect_timings_.load(memory_order_relaxed) ? Clock::now() : TimePoint{};
+    }
+    current_pool_ = nullptr;
+}
+
+void FixedThreadPool::wait(TaskGroup &group){
+    while(!group.done()){
+        Task *task = try_claim_task();
+        if(task){
+            run_task(task);
+        }else{
+            // the remaining tasks are executing elsewhere, poll now and then in case the pool stops
+            group.wait_for(chrono::milliseconds(1));
+        }
     }
 }
 
+bool FixedThreadPool::wait_idle(){
+    if(runs_on_caller()){
+        run_pending();
+        return running();
+    }
+    if(current_pool_ == this){
+        return false;
+    }
+    unique_lock<mutex> lock{mutex_};
+    ++idle_waiter_count_;
+    while(state_ == State::RUNNING && unfinished_task_count_ > 0){
+        idle_condition_.wait(lock);
+    }
+    --idle_waiter_count_;
+    return state_ == State::RUNNING;
+}
+
+size_t FixedThreadPool::run_pending(){
+    size_t count = 0;
+    Task *task;
+    while((task = try_claim_task())){
+        run_task(task);
+        ++count;
+    }
+    return count;
+}
 
 bool FixedThreadPool::stop(){
     return do_stop(State::STOPPING);
@@ -91,7 +765,10 @@ bool FixedThreadPool::finish_and_stop(){
 
 bool FixedThreadPool::do_stop(State stopping_state) {
     unique_lock<mutex> lock{mutex_};
-    if(state_ == State::RUNNING){        
+    if(state_ == State::RUNNING){
+        pressure_timer_.cancel();
+        pressure_timer_ = TimerHandle{};
+        pressure_armed_ = false;
         thread waiting_thread{[&](){
             for(auto i = threads_.begin(); i != threads_.end(); ++i){
                 if(i->joinable()){
@@ -99,19 +776,26 @@ bool FixedThreadPool::do_stop(State stopping_state) {
                 }
             }
         }};
-        
+
         state_ = stopping_state;
         condition_.notify_all();
+        idle_condition_.notify_all();
         lock.unlock();
-        
+
         waiting_thread.join();
 
-        threads_.clear();
         lock.lock();
-        
-        copy(tasks_.begin(), tasks_.end(), front_inserter(scheduled_tasks_));
-        tasks_.clear();
-        
+        thread_count_ = 0;
+        active_workers_.assign(max_thread_count_, false);
+
+        for(size_t lane = 0; lane < lane_count; ++lane){
+            scheduled_tasks_[lane].splice_front(tasks_[lane]);
+            for(auto i = worker_queues_.rbegin(); i != worker_queues_.rend(); ++i){
+                scheduled_tasks_[lane].splice_front((*i)->tasks[lane]);
+            }
+            queued_task_counts_[lane] = 0;
+        }
+
         state_ = State::STOPPED;
         return true;
     }else{
@@ -119,20 +803,272 @@ bool FixedThreadPool::do_stop(State stopping_state) {
     }
 }
 
-void FixedThreadPool::do_submit(Task* task){
+bool FixedThreadPool::elastic() const{
+    return min_thread_count_ < max_thread_count_ && growth_threshold_ > Duration::zero();
+}
+
+void FixedThreadPool::spawn_worker(){
+    if(free_workers_.empty()){
+        return;
+    }
+    size_t worker_index = free_workers_.back();
+    free_workers_.pop_back();
+    thread &worker = threads_[worker_index];
+    if(worker.joinable()){
+        // a retired worker, it released its slot as the last thing it did
+        worker.join();
+    }
+    WorkerPlacement::CpuSet cpus = placement_.cpu_sets.empty() ? WorkerPlacement::CpuSet{} : placement_.cpu_sets[worker_index % placement_.cpu_sets.size()];
+    worker = thread{&FixedThreadPool::perform_tasks, this, worker_index, move(cpus), placement_.scratch_capacity};
+    active_workers_[worker_index] = true;
+    ++thread_count_;
+}
+
+bool FixedThreadPool::retire_worker(size_t worker_index){
+    if(state_ != State::RUNNING || thread_count_ <= min_thread_count_ || queued_task_count() > 0){
+        return false;
+    }
+    active_workers_[worker_index] = false;
+    free_workers_.push_back(worker_index);
+    --thread_count_;
+    return true;
+}
+
+size_t FixedThreadPool::next_worker_queue(){
+    // round robin over the active workers, retired workers are skipped
+    size_t queue_count = worker_queues_.size();
+    for(size_t i = 0; i < queue_count; ++i){
+        size_t worker_index = (next_worker_queue_ + i) % queue_count;
+        if(active_workers_[worker_index]){
+            next_worker_queue_ = (worker_index + 1) % queue_count;
+            return worker_index;
+        }
+    }
+    return next_worker_queue_;
+}
+
+void FixedThreadPool::watch_pressure(){
+    // a single one shot check is pending at a time, so an idle pool does not wake up the timer thread
+    if(elastic() && state_ == State::RUNNING && !pressure_armed_){
+        pressure_armed_ = true;
+        pressure_timer_ = timers_->schedule(Clock::now() + growth_threshold_, Duration::zero(), [this](){
+            relieve_pressure();
+        });
+    }
+}
+
+void FixedThreadPool::relieve_pressure(){
+    lock_guard<mutex> guard{mutex_};
+    pressure_armed_ = false;
+    // the check lapses when the queues are empty or the pool can not grow, the next task queued in an empty lane arms it again
+    if(state_ != State::RUNNING || thread_count_ >= max_thread_count_ || queued_task_count() == 0){
+        return;
+    }
+    // the front of every queue holds its oldest task, the owner of a worker queue takes tasks from the back
+    TimePoint oldest = Clock::now();
+    for(const TaskQueue &tasks : tasks_){
+        if(!tasks.empty()){
+            oldest = min(oldest, tasks.front()->queued_at());
+        }
+    }
+    for(const unique_ptr<WorkerQueue> &queue : worker_queues_){
+        lock_guard<mutex> queue_guard{queue->mutex};
+        for(const TaskQueue &tasks : queue->tasks){
+            if(!tasks.empty()){
+                oldest = min(oldest, tasks.front()->queued_at());
+            }
+        }
+    }
+    if(Clock::now() - oldest > growth_threshold_){
+        spawn_worker();
+    }
+    watch_pressure();
+}
+
+TimerWheel &FixedThreadPool::timers(){
+    lock_guard<mutex> guard{mutex_};
+    if(!timers_){
+        timers_.reset(new TimerWheel{});
+    }
+    return *timers_;
+}
+
+void FixedThreadPool::do_submit(Task* task, TaskPriority priority, size_t affinity){
+    stamp(task);
+    telemetry().submitted(1);
+    if(scheduling_ == Scheduling::INLINE && state_ == State::RUNNING){
+        ++unfinished_task_count_;
+        run_inline(task);
+        return;
+    }
+    // a single lane keeps deterministic pools in submission order
+    size_t lane = scheduling_ == Scheduling::DETERMINISTIC ? critical_lane : static_cast<size_t>(priority);
+    ++unfinished_task_count_;
+    size_t affinity_worker = affinity == no_affinity || max_thread_count_ == 0 ? no_affinity : affinity % max_thread_count_;
+    if(scheduling_ == Scheduling::WORK_STEALING && current_pool_ == this && (affinity_worker == no_affinity || affinity_worker == current_worker_index_)){
+        // submitted from one of our own workers: the pool can not stop before this call returns
+        // thieves only lock the worker queue, so the task is counted before it can be claimed and the count never drops below zero
+        bool lane_was_empty = queued_task_counts_[lane]++ == 0;
+        push_worker_task(current_worker_index_, task, lane);
+        if(sleeping_worker_count_ > 0 || (lane_was_empty && elastic())){
+            lock_guard<mutex> guard{mutex_};
+            if(lane_was_empty){
+                watch_pressure();
+            }
+            condition_.notify_one();
+        }
+        return;
+    }
     lock_guard<mutex> guard{mutex_};
     if(state_ == State::RUNNING){
-        tasks_.push_back(task);
+        if(thread_count_ == 0){
+            // every worker of an elastic pool without a minimum has retired
+            spawn_worker();
+        }
+        if(queued_task_counts_[lane]++ == 0){
+            watch_pressure();
+        }
+        if(scheduling_ == Scheduling::WORK_STEALING){
+            bool near = affinity_worker != no_affinity && active_workers_[affinity_worker];
+            push_worker_task(near ? affinity_worker : next_worker_queue(), task, lane);
+        }else{
+            tasks_[lane].push_back(task);
+        }
         condition_.notify_one();
     }else{
-        scheduled_tasks_.push_back(task);
+        scheduled_tasks_[lane].push_back(task);
     }
 };
 
+void FixedThreadPool::do_submit_all(TaskQueue &tasks, TaskPriority priority){
+    size_t lane = scheduling_ == Scheduling::DETERMINISTIC ? critical_lane : static_cast<size_t>(priority);
+    size_t count = tasks.size();
+    if(count == 0){
+        return;
+    }
+    if(elastic() || collect_timings_.load(memory_order_relaxed)){
+        TimePoint now = Clock::now();
+        for(size_t i = 0; i < count; ++i){
+            Task *task = tasks.pop_front();
+            task->queued_at(now);
+            tasks.push_back(task);
+        }
+    }
+    telemetry().submitted(count);
+    if(scheduling_ == Scheduling::INLINE && state_ == State::RUNNING){
+        unfinished_task_count_ += count;
+        Task *task;
+        while((task = tasks.pop_front())){
+            run_inline(task);
+        }
+        return;
+    }
+    unfinished_task_count_ += count;
+    if(scheduling_ == Scheduling::WORK_STEALING && current_pool_ == this){
+        bool lane_was_empty = queued_task_counts_[lane].fetch_add(count) == 0;
+        {
+            WorkerQueue &queue = *worker_queues_[current_worker_index_];
+            lock_guard<mutex> queue_guard{queue.mutex};
+            queue.tasks[lane].splice_back(tasks);
+        }
+        if(sleeping_worker_count_ > 0 || (lane_was_empty && elastic())){
+            lock_guard<mutex> guard{mutex_};
+            if(lane_was_empty){
+                watch_pressure();
+            }
+            condition_.notify_all();
+        }
+        return;
+    }
+    lock_guard<mutex> guard{mutex_};
+    if(state_ == State::RUNNING){
+        if(thread_count_ == 0){
+            spawn_worker();
+        }
+        if(queued_task_counts_[lane].fetch_add(count) == 0){
+            watch_pressure();
+        }
+        if(scheduling_ == Scheduling::WORK_STEALING){
+            // hand every worker an equal slice, the first ones take the remainder
+            size_t queue_count = thread_count_;
+            for(size_t i = 0; i < queue_count && !tasks.empty(); ++i){
+                size_t slice_size = (count + queue_count - 1 - i) / queue_count;
+                TaskQueue slice;
+                tasks.transfer_front(slice, slice_size);
+                WorkerQueue &queue = *worker_queues_[next_worker_queue()];
+                lock_guard<mutex> queue_guard{queue.mutex};
+                queue.tasks[lane].splice_back(slice);
+            }
+        }else{
+            tasks_[lane].splice_back(tasks);
+        }
+        if(count == 1){
+            condition_.notify_one();
+        }else{
+            condition_.notify_all();
+        }
+    }else{
+        scheduled_tasks_[lane].splice_back(tasks);
+    }
+}
+
+size_t FixedThreadPool::grain(size_t count, size_t grain_size) const{
+    if(grain_size == 0){
+        grain_size = count / (4 * max(max_thread_count_, size_t{1}));
+    }
+    return max(grain_size, size_t{1});
+}
+
+bool FixedThreadPool::accepts_parallel_work() const{
+    return running();
+}
+
 void FixedThreadPool::clear(){
+    TaskQueue cleared_tasks;
+    {
+        lock_guard<mutex> guard{mutex_};
+        for(size_t lane = 0; lane < lane_count; ++lane){
+            TaskQueue lane_tasks;
+            lane_tasks.splice_back(tasks_[lane]);
+            for(unique_ptr<WorkerQueue> &queue : worker_queues_){
+                lock_guard<mutex> queue_guard{queue->mutex};
+                lane_tasks.splice_back(queue->tasks[lane]);
+            }
+            queued_task_counts_[lane] -= lane_tasks.size();
+            cleared_tasks.splice_back(lane_tasks);
+        }
+    }
+    // destroying a callable can break a promise, whose continuation may submit to this pool, so the lock is not held
+    size_t cleared_count = cleared_tasks.size();
+    release_tasks(cleared_tasks);
+    // the tasks are only finished now, so wait_idle() also waits for the tasks submitted while they were destroyed
     lock_guard<mutex> guard{mutex_};
-    for(Task *task : tasks_){
-        delete task;
+    if((unfinished_task_count_ -= cleared_count) == 0){
+        idle_condition_.notify_all();
     }
-    tasks_.clear();
 };
+
+#ifdef GAME_COROUTINES
+FixedThreadPool::ScheduleOperation::ScheduleOperation(FixedThreadPool &pool, TaskPriority priority) : pool_(&pool), priority_(priority){
+}
+
+bool FixedThreadPool::ScheduleOperation::await_ready() const noexcept{
+    return false;
+}
+
+void FixedThreadPool::ScheduleOperation::await_suspend(coroutine_handle<> coroutine){
+    pool_->submit([coroutine](){
+        coroutine.resume();
+    }, priority_);
+}
+
+void FixedThreadPool::ScheduleOperation::await_resume() const noexcept{
+}
+
+FixedThreadPool::ScheduleOperation FixedThreadPool::schedule(TaskPriority priority){
+    return ScheduleOperation{*this, priority};
+}
+
+#endif
+ElasticThreadPool::ElasticThreadPool(size_t min_thread_count, size_t max_thread_count, Duration growth_threshold, Duration retire_timeout, Scheduling scheduling, IdlePolicy idle_policy) : FixedThreadPool(min_thread_count, max_thread_count, growth_threshold, retire_timeout, scheduling, idle_policy){
+}
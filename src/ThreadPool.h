@@ -1,5 +1,5 @@
 ///
-/// \file contains several helper classed related to concurrency
+/// \file contains several helper classes related to concurrency
 ///
 
 #ifndef GAME_THREAD_POOL_H
@@ -8,12 +8,214 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <list>
+#include <atomic>
 #include <vector>
+#include <memory>
 #include <utility>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <array>
+
+#ifdef GAME_COROUTINES
+#include <coroutine>
+#endif
+
+#include "Arena.h"
+#include "Future.h"
+#include "Task.h"
+#include "Telemetry.h"
+#include "Timer.h"
 
 namespace Game{
  
+    class FixedThreadPool;
+    
+    ///
+    /// \class The priority lane a task is queued in
+    ///
+    enum class TaskPriority{
+        ///
+        /// work that has to finish within the current frame or tick, always executed before background work
+        ///
+        FRAME_CRITICAL,
+        
+        ///
+        /// bulk work that can be spread over several frames (e.g. resource loading)
+        ///
+        BACKGROUND
+    };
+    
+    ///
+    /// \class A counter of unfinished tasks that can be waited for
+    /// Tasks are added to a group by submitting them through FixedThreadPool::submit(TaskGroup &, T &&)
+    /// A group can be reused as soon as all of its tasks have finished.
+    ///
+    class TaskGroup{
+    public:
+        
+        ///
+        /// Creates an empty task group
+        ///
+        TaskGroup();
+        
+        ///
+        /// Waits for all tasks in the group to finish and destroys the group
+        ///
+        ~TaskGroup();
+        
+        ///
+        /// Blocks until all tasks in the group have finished
+        /// Use FixedThreadPool::wait(TaskGroup &) to execute pending tasks while waiting
+        ///
+        void wait();
+        
+        ///
+        /// Blocks until all tasks in the group have finished or the timeout expires
+        /// \param timeout the maximum amount of time to wait
+        /// \return true if all tasks have finished, false otherwise
+        ///
+        template<typename Rep, typename Period> bool wait_for(const std::chrono::duration<Rep, Period> &timeout){
+            std::unique_lock<std::mutex> lock{mutex_};
+            return condition_.wait_for(lock, timeout, [this](){
+                return count_ == 0;
+            });
+        };
+        
+        ///
+        /// \return true if all tasks in the group have finished, false otherwise
+        ///
+        bool done() const;
+        
+        ///
+        /// \return the amount of unfinished tasks in the group
+        ///
+        std::size_t size() const;
+        
+        ///
+        /// Adds tasks to the group
+        /// Only needed to track work that is not submitted through FixedThreadPool::submit(TaskGroup &, T &&)
+        /// \param count the amount of tasks to add
+        ///
+        void add(std::size_t count = 1);
+        
+        ///
+        /// Marks a task of the group as finished, releases all waiting threads if it was the last one
+        ///
+        void complete();
+        
+    private:
+        mutable std::mutex mutex_;
+        std::condition_variable condition_;
+        std::atomic<std::size_t> count_;
+        
+        TaskGroup(const TaskGroup &) = delete;
+        TaskGroup &operator=(const TaskGroup &) = delete;
+    };
+    
+    ///
+    /// \class Describes what an idle worker does before it blocks waiting for new tasks
+    /// An idle worker first spins on the queue with a pause instruction, then yields its time slice and finally parks on a condition variable.
+    /// Spinning and yielding avoid the wake up latency of parking when tasks arrive in rapid bursts, at the cost of CPU time while idle.
+    /// Pools park immediately by default. There is no spinning preset yet: good durations depend on the machine and have only been measured on a single core,
+    /// so a pool only spins or yields for the durations it is given explicitly (see benchmark/IdlePolicyBenchmark.cpp).
+    ///
+    struct IdlePolicy{
+        
+        ///
+        /// Creates a policy that parks immediately
+        ///
+        IdlePolicy();
+        
+        ///
+        /// Creates a new policy
+        /// \param spin_duration the maximum time an idle worker spins before yielding
+        /// \param yield_duration the maximum time an idle worker yields before parking
+        ///
+        IdlePolicy(Duration spin_duration, Duration yield_duration);
+        
+        ///
+        /// \return a policy that parks idle workers immediately, which uses no CPU time while idle
+        ///
+        static IdlePolicy park();
+        
+        ///
+        /// \return true if this policy parks idle workers immediately
+        ///
+        bool parks_immediately() const;
+        
+        ///
+        /// the maximum time an idle worker spins before yielding
+        ///
+        Duration spin_duration;
+        
+        ///
+        /// the maximum time an idle worker yields before parking
+        ///
+        Duration yield_duration;
+    };
+    
+    ///
+    /// \class Describes on which CPUs the workers of a pool run and how much local scratch memory they get
+    /// Worker i is restricted to the CPU set i modulo the amount of sets, an empty list of sets lets workers float freely.
+    /// Pinning is only supported on Linux, elsewhere (or if the CPUs are not available to the process) workers float freely.
+    ///
+    struct WorkerPlacement{
+        
+        ///
+        /// a set of CPU numbers
+        ///
+        using CpuSet = std::vector<unsigned int>;
+        
+        ///
+        /// Creates a placement that lets workers float freely
+        ///
+        WorkerPlacement();
+        
+        ///
+        /// \return a placement that lets workers float freely
+        ///
+        static WorkerPlacement floating();
+        
+        ///
+        /// \param cpus the CPU numbers
+        /// \return a placement that pins worker i to CPU i modulo the amount of CPUs
+        ///
+        static WorkerPlacement cores(const CpuSet &cpus);
+        
+        ///
+        /// \param node the NUMA node
+        /// \return a placement that keeps all workers on the CPUs of the NUMA node
+        ///
+        static WorkerPlacement numa_node(unsigned int node);
+        
+        ///
+        /// \return a placement that spreads the workers round robin over all NUMA nodes, each worker floating within its node
+        ///
+        static WorkerPlacement numa_nodes();
+        
+        ///
+        /// \return the amount of NUMA nodes, 1 if the system does not report any
+        ///
+        static unsigned int numa_node_count();
+        
+        ///
+        /// \param node the NUMA node
+        /// \return the CPUs of the NUMA node, or an empty set if the node is unknown
+        ///
+        static CpuSet numa_node_cpus(unsigned int node);
+        
+        ///
+        /// the CPU sets the workers are distributed over
+        ///
+        std::vector<CpuSet> cpu_sets;
+        
+        ///
+        /// the size in bytes of the scratch arena every worker allocates after it has been placed, 0 for none
+        ///
+        std::size_t scratch_capacity;
+    };
+    
     ///
     /// \class A simple thread pool with a fixed (non static) amount of worker threads.
     /// All member functions of this class are thread safe.
@@ -21,12 +223,44 @@ namespace Game{
     class FixedThreadPool{
     public:
         
+        ///
+        /// The way tasks are distributed over the worker threads
+        ///
+        enum class Scheduling{
+            ///
+            /// all workers claim tasks from a single shared queue
+            ///
+            SHARED_QUEUE,
+            
+            ///
+            /// every worker has its own queue, idle workers steal tasks from the other workers
+            /// tasks submitted from inside a worker are added to that worker's queue
+            ///
+            WORK_STEALING,
+            
+            ///
+            /// there are no workers, a running pool executes every task on the submitting thread before submit returns
+            /// tasks submitted while the pool is stopped are queued and run by wait(), wait_idle() or run_pending()
+            /// timer tasks run on the timer thread
+            ///
+            INLINE,
+            
+            ///
+            /// there are no workers, tasks are queued in submission order regardless of their priority
+            /// and run on the calling thread by wait(), wait_idle() or run_pending(), so every run executes them in the same order
+            ///
+            DETERMINISTIC
+        };
+        
         ///
         /// Creates a new thread pool with the specified amount of working threads
         /// Threads are created when start is called and destroyed before stop() or finish_and_stop() returns
-        /// \param max_thread_count the amount of worker threads to use
+        /// \param max_thread_count the amount of worker threads to use, ignored with INLINE or DETERMINISTIC scheduling
+        /// \param scheduling the way tasks are distributed over the worker threads
+        /// \param idle_policy what workers do when they run out of tasks
+        /// \throw std::invalid_argument if max_thread_count is zero with WORK_STEALING scheduling
         ///
-        FixedThreadPool(std::size_t max_thread_count = 1);
+        FixedThreadPool(std::size_t max_thread_count = 1, Scheduling scheduling = Scheduling::SHARED_QUEUE, IdlePolicy idle_policy = IdlePolicy{});
         
         ///
         /// Stops and destroys the thread pool
@@ -67,70 +301,637 @@ namespace Game{
         /// Submit a new task
         /// If the pool is not running, the task will be scheduled to run after the pool starts
         /// \param task should be a callable object with no parameters or return type
+        /// \param priority the priority lane of the task
         ///
-        template<typename T> void submit(T &&task){
-            do_submit(new TaskImpl<T>{std::forward<T>(task)});
+        template<typename T> void submit(T &&task, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            do_submit(task_allocator_.assign(acquire_task(), std::forward<T>(task)), priority);
         };
         
         ///
         /// Submit a new task
         /// If the pool is not running, the task will be scheduled to run after the pool starts
         /// \param task should be a callable object with no parameters or return type
+        /// \param priority the priority lane of the task
+        ///
+        template<typename T> void submit(const T &task, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            do_submit(task_allocator_.assign(acquire_task(), task), priority);
+        };
+        
+        ///
+        /// Submit a new task and return a future for its result
+        /// The shared state of the future is recycled, so this performs no allocation in steady state
+        /// If the task is destroyed without running (e.g. by clear()), the future receives a std::future_error (broken_promise)
+        /// \param task should be a callable object with no parameters
+        /// \param priority the priority lane of the task
+        /// \return a future for the task's return value or error
+        ///
+        template<typename T> auto submit_async(T &&task, TaskPriority priority = TaskPriority::FRAME_CRITICAL) -> Future<decltype(std::declval<typename std::decay<T>::type &>()())>{
+            using Callable = typename std::decay<T>::type;
+            using Result = decltype(std::declval<Callable &>()());
+            Promise<Result> promise;
+            Future<Result> future = promise.future();
+            submit(AsyncTask<Callable, Result>{std::move(promise), std::forward<T>(task)}, priority);
+            return future;
+        };
+        
+#ifdef GAME_COROUTINES
+        ///
+        /// \class An awaitable that resumes the awaiting coroutine on a worker of a pool
+        ///
+        class ScheduleOperation{
+        public:
+            ScheduleOperation(FixedThreadPool &pool, TaskPriority priority);
+            
+            bool await_ready() const noexcept;
+            
+            void await_suspend(std::coroutine_handle<> coroutine);
+            
+            void await_resume() const noexcept;
+            
+        private:
+            FixedThreadPool *pool_;
+            TaskPriority priority_;
+        };
+        
+        ///
+        /// Returns an awaitable that moves the awaiting coroutine to a worker of this pool, e.g. co_await pool.schedule()
+        /// If the pool is not running, the coroutine is resumed after the pool starts
+        /// \param priority the priority lane of the task that resumes the coroutine
+        /// \return the awaitable
+        ///
+        ScheduleOperation schedule(TaskPriority priority = TaskPriority::FRAME_CRITICAL);
+        
+#endif
+        ///
+        /// Submit a new task that should run near other tasks with the same affinity key
+        /// With work stealing, tasks with the same key are queued at the same worker, so they share its caches and memory node
+        /// This is only a hint: idle workers may still steal the task, and pools with a shared queue ignore the key
+        /// \param affinity the affinity key, e.g. the index of the star system the task works on
+        /// \param task should be a callable object with no parameters or return type
+        /// \param priority the priority lane of the task
+        ///
+        template<typename T> void submit_near(std::size_t affinity, T &&task, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            do_submit(task_allocator_.assign(acquire_task(), std::forward<T>(task)), priority, affinity);
+        };
+        
+        ///
+        /// Submit a new task as part of a task group
+        /// If the pool is not running, the task will be scheduled to run after the pool starts
+        /// The task is finished when it is destroyed, so a task that is destroyed without running (e.g. by clear()) also finishes
+        /// \param group the group the task is added to, the group should outlive the task
+        /// \param task should be a callable object with no parameters or return type
+        /// \param priority the priority lane of the task
+        ///
+        template<typename T> void submit(TaskGroup &group, T &&task, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            group.add();
+            // finishes the task if it can not be submitted
+            GroupTask<typename std::decay<T>::type> group_task{GroupGuard{&group}, std::forward<T>(task)};
+            do_submit(task_allocator_.assign(acquire_task(), std::move(group_task)), priority);
+        };
+        
+        ///
+        /// Submit a new task to be run at a specific time
+        /// The task is kept by the pool's timer wheel until it is due, no worker is occupied while waiting
+        /// If the pool is not running when the task is due, the task will be scheduled to run after the pool starts
+        /// \param time the time to submit the task at
+        /// \param task should be a callable object with no parameters or return type
+        /// \param priority the priority lane of the task
+        /// \return a handle that can cancel the task before it is due
+        ///
+        template<typename T> TimerHandle submit_at(TimePoint time, T &&task, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            std::shared_ptr<typename std::decay<T>::type> callable = std::make_shared<typename std::decay<T>::type>(std::forward<T>(task));
+            return timers().schedule(time, Duration::zero(), [this, callable, priority](){
+                submit(std::move(*callable), priority);
+            });
+        };
+        
+        ///
+        /// Submit a new task to be run after a delay
+        /// See submit_at()
+        /// \param delay the time to wait before submitting the task
+        /// \param task should be a callable object with no parameters or return type
+        /// \param priority the priority lane of the task
+        /// \return a handle that can cancel the task before it is due
+        ///
+        template<typename T> TimerHandle submit_after(Duration delay, T &&task, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            return submit_at(Clock::now() + delay, std::forward<T>(task), priority);
+        };
+        
+        ///
+        /// Submit a task to be run periodically, starting one period from now
+        /// The task is copied for every run: if a run takes longer than the period, subsequent runs may execute concurrently,
+        /// each on its own copy, so state that should be shared between runs has to be shared by the task itself
+        /// Runs that are missed because the pool's timer thread fell behind are skipped
+        /// \param period the time between two runs
+        /// \param task should be a copy constructible callable object with no parameters or return type
+        /// \param priority the priority lane of the task
+        /// \return a handle that can cancel future runs of the task
+        ///
+        template<typename T> TimerHandle submit_every(Duration period, T &&task, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            using Callable = typename std::decay<T>::type;
+            std::shared_ptr<const Callable> callable = std::make_shared<const Callable>(std::forward<T>(task));
+            return timers().schedule(Clock::now() + period, period, [this, callable, priority](){
+                submit(*callable, priority);
+            });
+        };
+        
+        ///
+        /// Submits a range of tasks at once
+        /// The pool is locked only once and idle workers are woken with a single notification
+        /// If the pool is not running, the tasks will be scheduled to run after the pool starts
+        /// \param first an iterator to the first task in the range, tasks should be callable objects with no parameters or return type
+        /// \param last an iterator past the last task in the range
+        /// \param priority the priority lane of the tasks
+        ///
+        template<typename Iterator> void submit_all(Iterator first, Iterator last, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            TaskQueue tasks;
+            try{
+                for(; first != last; ++first){
+                    tasks.push_back(task_allocator_.assign(acquire_task(), *first));
+                }
+            }catch(...){
+                release_tasks(tasks);
+                throw;
+            }
+            do_submit_all(tasks, priority);
+        };
+        
+        ///
+        /// Calls the function for every index in [begin, end) and blocks until all calls have finished
+        /// The range is split in chunks of grain_size indices which are submitted at once, the calling thread executes the first chunk itself
+        /// While waiting for the other chunks the calling thread helps executing queued tasks, so this function can be called from a worker
+        /// If the pool is not running, all calls are made on the calling thread
+        /// If a call throws, the remaining calls of its chunk are skipped and the first error is rethrown after all chunks have finished
+        /// If a chunk is destroyed without running (e.g. by clear()), a std::future_error (broken_promise) is thrown after all other chunks have finished
+        /// \param begin the first index
+        /// \param end the index past the last index
+        /// \param function a callable object taking a std::size_t index
+        /// \param grain_size the amount of indices per chunk, or 0 to divide the range evenly over the workers
+        /// \param priority the priority lane of the chunks
         ///
-        template<typename T> void submit(const T &task){
-            do_submit(new TaskImpl<T>{task});
+        template<typename Function> void parallel_for(std::size_t begin, std::size_t end, Function function, std::size_t grain_size = 0, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            for_each_chunk(begin, end, grain_size, priority, [&function](std::size_t, std::size_t chunk_begin, std::size_t chunk_end){
+                for(std::size_t index = chunk_begin; index < chunk_end; ++index){
+                    function(index);
+                }
+            });
         };
         
+        ///
+        /// Maps every index in [begin, end) to a value and reduces all values to a single result, blocks until the result is known
+        /// Every chunk reduces its own values starting from the identity, the chunk results are then reduced in the order of the range on the calling thread
+        /// The same rules as in parallel_for() apply to chunking, threading and errors
+        /// \param begin the first index
+        /// \param end the index past the last index
+        /// \param identity the identity value of the reduction
+        /// \param map a callable object taking a std::size_t index and returning a value
+        /// \param reduce a callable object taking two values and returning their combination
+        /// \param grain_size the amount of indices per chunk, or 0 to divide the range evenly over the workers
+        /// \param priority the priority lane of the chunks
+        /// \return the reduced value
+        ///
+        template<typename T, typename Map, typename Reduce> T parallel_reduce(std::size_t begin, std::size_t end, T identity, Map map, Reduce reduce, std::size_t grain_size = 0, TaskPriority priority = TaskPriority::FRAME_CRITICAL){
+            if(begin >= end){
+                return identity;
+            }
+            std::size_t chunk_size = grain(end - begin, grain_size);
+            // every chunk writes its own slot, a wrapper keeps std::vector<bool> from packing the results of several chunks in one word
+            struct Slot{
+                T value;
+            };
+            std::vector<Slot> results((end - begin + chunk_size - 1) / chunk_size, Slot{identity});
+            for_each_chunk(begin, end, chunk_size, priority, [&map, &reduce, &results](std::size_t chunk_index, std::size_t chunk_begin, std::size_t chunk_end){
+                T result = results[chunk_index].value;
+                for(std::size_t index = chunk_begin; index < chunk_end; ++index){
+                    result = reduce(result, map(index));
+                }
+                results[chunk_index].value = result;
+            });
+            T result = identity;
+            for(const Slot &chunk_result : results){
+                result = reduce(result, chunk_result.value);
+            }
+            return result;
+        };
+        
+        ///
+        /// Blocks until all tasks in the group have finished
+        /// While waiting, the calling thread executes queued tasks of the pool (not only those of the group), so this can safely be called from a worker
+        /// If the pool is stopped, the calling thread executes scheduled tasks
+        /// \param group the task group
+        ///
+        void wait(TaskGroup &group);
+        
+        ///
+        /// Blocks until no tasks are queued or executing
+        /// The workers are not stopped and tasks can still be submitted while waiting
+        /// This function should not be called from one of the pool's workers: it can never become idle while a worker waits
+        /// \return true if the pool became idle, false if the pool is not running, stopped while waiting or if called from a worker
+        ///
+        bool wait_idle();
+        
+        ///
+        /// Executes queued tasks on the calling thread until no tasks are queued, including the tasks they submit
+        /// If the pool is stopped, the calling thread executes scheduled tasks
+        /// \return the amount of executed tasks
+        ///
+        std::size_t run_pending();
+        
         ///
         /// Clears all scheduled and active tasks
         /// This function may block
         ///
         void clear();
         
+        ///
+        /// \return the way tasks are distributed over the worker threads
+        ///
+        Scheduling scheduling() const;
+        
+        ///
+        /// \return what workers do when they run out of tasks
+        ///
+        const IdlePolicy &idle_policy() const;
+        
+        ///
+        /// \return on which CPUs workers run and how much scratch memory they get
+        ///
+        WorkerPlacement placement() const;
+        
+        ///
+        /// Sets on which CPUs workers run and how much scratch memory they get
+        /// The placement applies to workers started after this call, i.e. after the pool is restarted or grows
+        /// \param placement the placement
+        ///
+        void placement(const WorkerPlacement &placement);
+        
+        ///
+        /// Returns the scratch arena of the calling worker
+        /// Allocations made by a task are released when the task returns, so scratch memory should not outlive the task
+        /// \return the arena, or nullptr if the calling thread is not a worker of this pool or workers have no scratch arena
+        ///
+        ScratchArena *scratch();
+        
+        ///
+        /// \return the amount of worker threads currently running
+        ///
+        std::size_t thread_count() const;
+        
+        ///
+        /// \return the amount of worker threads that keep running while the pool is idle
+        ///
+        std::size_t min_thread_count() const;
+        
+        ///
+        /// \return the maximum amount of worker threads
+        ///
+        std::size_t max_thread_count() const;
+        
+        ///
+        /// \return the queue wait time above which an elastic pool adds a worker thread, or Duration::zero() if the pool never grows
+        ///
+        Duration growth_threshold() const;
+        
+        ///
+        /// \return the time after which an idle worker thread of an elastic pool retires
+        ///
+        Duration retire_timeout() const;
+        
+        ///
+        /// Tasks and their storage are recycled, so once the pool has warmed up this count should no longer increase
+        /// \return the total amount of heap allocations performed to store submitted tasks
+        ///
+        std::size_t task_allocation_count() const;
+        
+        ///
+        /// \return the maximum amount of frame critical tasks a worker executes in a row while background tasks are waiting
+        ///
+        std::size_t critical_burst() const;
+        
+        ///
+        /// Sets the maximum amount of frame critical tasks a worker executes in a row while background tasks are waiting
+        /// After that many frame critical tasks a single background task is executed, so background work can not starve
+        /// \param critical_burst the amount of tasks, or 0 to only execute background tasks when no frame critical tasks are queued
+        ///
+        void critical_burst(std::size_t critical_burst);
+        
+        ///
+        /// Returns the amount of tasks queued in a priority lane
+        /// Scheduled tasks of a stopped pool and tasks that are being executed are not included
+        /// \param priority the priority lane
+        /// \return the amount of queued tasks
+        ///
+        std::size_t queue_depth(TaskPriority priority) const;
+        
+        ///
+        /// \return true if tasks are timed for the statistics
+        ///
+        bool collect_timings() const;
+        
+        ///
+        /// Enables or disables timing tasks, which costs a few clock reads per task
+        /// Task counts are always collected, queue wait and execution times, busy and idle time only while timings are enabled
+        /// \param enabled true to time tasks
+        ///
+        void collect_timings(bool enabled);
+        
+        ///
+        /// Collects the counters of all threads, can be called from any thread at any time
+        /// Counters are updated without synchronization, so a snapshot taken while tasks run may be slightly inconsistent
+        /// \return a snapshot of the activity since the pool was created or the statistics were reset
+        ///
+        ThreadPoolStatistics statistics() const;
+        
+        ///
+        /// Resets all counters and histograms
+        ///
+        void reset_statistics();
+        
+    protected:
+        
+        ///
+        /// Creates a new thread pool that adjusts its amount of worker threads to the load
+        /// \param min_thread_count the amount of worker threads started by start() that never retire
+        /// \param max_thread_count the maximum amount of worker threads
+        /// \param growth_threshold a worker thread is added when the oldest queued task has waited longer than this
+        /// \param retire_timeout a worker thread above the minimum retires when it has been idle for this long
+        /// \param scheduling the way tasks are distributed over the worker threads
+        /// \param idle_policy what workers do when they run out of tasks
+        /// \throw std::invalid_argument if max_thread_count is zero with WORK_STEALING scheduling
+        ///
+        FixedThreadPool(std::size_t min_thread_count, std::size_t max_thread_count, Duration growth_threshold, Duration retire_timeout, Scheduling scheduling, IdlePolicy idle_policy);
+        
     private:
         
+        static const std::size_t lane_count = 2;
+        
+        using Lanes = std::array<TaskQueue, lane_count>;
+        
+        
         enum class State{
             RUNNING, FINISHING, STOPPING, STOPPED
         };
         
-        class Task{
+        ///
+        /// tracks the chunks of a parallel_for() or parallel_reduce() call and the first error they raised
+        ///
+        class ParallelContext{
         public:
-            virtual ~Task();
+            ParallelContext();
+            
+            template<typename Body> void execute(Body &body, std::size_t chunk_index, std::size_t chunk_begin, std::size_t chunk_end){
+                try{
+                    body(chunk_index, chunk_begin, chunk_end);
+                }catch(...){
+                    fail(std::current_exception());
+                }
+            };
+            
+            TaskGroup &group();
             
-            virtual void execute() = 0;
+            void rethrow();
+            
+            void fail(std::exception_ptr error);
+            
+        private:
+            TaskGroup group_;
+            std::mutex mutex_;
+            std::exception_ptr error_;
         };
         
-        template<typename T> class TaskImpl : public Task{
+        ///
+        /// marks a task of a group as finished when it goes out of scope, unless it was moved
+        ///
+        class GroupGuard{
         public:
+            explicit GroupGuard(TaskGroup *group);
             
-            explicit TaskImpl(const T &task) : task_(task){};
+            GroupGuard(GroupGuard &&guard);
             
-            explicit TaskImpl(T &&task) : task_(std::move(task)){};
+            ~GroupGuard();
             
-            ~TaskImpl(){};
+        private:
+            TaskGroup *group_;
+            
+            GroupGuard(const GroupGuard &) = delete;
+            GroupGuard &operator=(const GroupGuard &) = delete;
+        };
+        
+        ///
+        /// wraps a task submitted as part of a group, the group is told when the task is destroyed, whether it ran or not
+        ///
+        template<typename Callable> struct GroupTask{
+            GroupGuard guard;
+            Callable callable;
             
-            void execute() override{
-                task_();
+            void operator()(){
+                callable();
             };
+        };
+        
+        ///
+        /// marks a chunk of a parallel call as finished when it goes out of scope, unless it was moved
+        /// a chunk that did not run fails the call
+        ///
+        class ChunkGuard{
+        public:
+            explicit ChunkGuard(ParallelContext *context);
+            
+            ChunkGuard(ChunkGuard &&guard);
+            
+            ~ChunkGuard();
+            
+            ParallelContext &context() const;
+            
+            void executed();
             
         private:
-            T task_;
+            ParallelContext *context_;
+            bool executed_;
+            
+            ChunkGuard(const ChunkGuard &) = delete;
+            ChunkGuard &operator=(const ChunkGuard &) = delete;
+        };
+        
+        ///
+        /// wraps a chunk of a parallel call
+        ///
+        template<typename Body> struct ChunkTask{
+            ChunkGuard guard;
+            Body *body;
+            std::size_t chunk_index;
+            std::size_t chunk_begin;
+            std::size_t chunk_end;
+            
+            void operator()(){
+                guard.executed();
+                guard.context().execute(*body, chunk_index, chunk_begin, chunk_end);
+            };
+        };
+        
+        ///
+        /// wraps a task whose result is passed to a future
+        ///
+        template<typename Callable, typename Result> struct AsyncTask{
+            Promise<Result> promise;
+            Callable callable;
+            
+            void operator()(){
+                promise.set_result(callable);
+            };
+        };
+        
+        ///
+        /// a worker's local state
+        /// when work stealing the owning worker takes tasks from the back of the queue, thieves take them from the front
+        /// the cache recycles tasks submitted and executed by the owning worker without locking
+        ///
+        struct WorkerQueue{
+            explicit WorkerQueue(TaskAllocator &allocator);
+            
+            std::mutex mutex;
+            Lanes tasks;
+            TaskCache cache;
+            std::size_t critical_streak;
+            std::unique_ptr<ScratchArena> scratch;
+            WorkerTelemetry telemetry;
         };
         
+        static const std::size_t no_affinity = static_cast<std::size_t>(-1);
+        
         std::vector<std::thread> threads_;
+        const std::size_t min_thread_count_;
         const std::size_t max_thread_count_; 
-        State state_;
+        const Scheduling scheduling_;
+        const IdlePolicy idle_policy_;
+        WorkerPlacement placement_;
+        const Duration growth_threshold_;
+        const Duration retire_timeout_;
+        std::atomic<State> state_;
         mutable std::mutex mutex_;
         std::condition_variable condition_;
         
-        std::list<Task *> tasks_;
-        std::list<Task *> scheduled_tasks_;
+        TaskAllocator task_allocator_;
+        Lanes tasks_;
+        Lanes scheduled_tasks_;
+        std::size_t critical_streak_;
+        std::atomic<std::size_t> critical_burst_;
+        std::array<std::atomic<std::size_t>, lane_count> queued_task_counts_;
+        
+        std::vector<std::unique_ptr<WorkerQueue>> worker_queues_;
+        std::unique_ptr<TimerWheel> timers_;
+        std::size_t next_worker_queue_;
+        std::vector<bool> active_workers_;
+        std::vector<std::size_t> free_workers_;
+        std::atomic<std::size_t> thread_count_;
+        TimerHandle pressure_timer_;
+        bool pressure_armed_;
+        std::atomic<std::size_t> sleeping_worker_count_;
+        std::atomic<std::size_t> unfinished_task_count_;
+        std::atomic<std::size_t> idle_waiter_count_;
+        std::condition_variable idle_condition_;
+        std::atomic<bool> collect_timings_;
+        WorkerTelemetry caller_telemetry_;
         
-        void perform_tasks();
+        static thread_local FixedThreadPool *current_pool_;
+        static thread_local std::size_t current_worker_index_;
         
-        Task *claim_task();
+        void perform_tasks(std::size_t worker_index, WorkerPlacement::CpuSet cpus, std::size_t scratch_capacity);
         
-        void do_submit(Task *task);
+        Task *claim_task(std::size_t worker_index);
+        
+        Task *claim_stolen_task(std::size_t worker_index);
+        
+        Task *try_claim_task();
+        
+        void run_task(Task *task);
+        
+        void run_inline(Task *task) noexcept;
+        
+        bool runs_on_caller() const;
+        
+        WorkerTelemetry &telemetry();
+        
+        void stamp(Task *task);
+        
+        void finish_tasks(std::size_t count);
+        
+        Task *claim_lane_task(Lanes &lanes, std::size_t &critical_streak, bool from_back);
+        
+        Task *claim_worker_task(std::size_t worker_index);
+        
+        Task *pop_worker_task(std::size_t worker_index, std::size_t lane);
+        
+        Task *steal_worker_task(std::size_t thief_index, std::size_t lane);
+        
+        void push_worker_task(std::size_t worker_index, Task *task, std::size_t lane);
+        
+        std::size_t queued_task_count() const;
+        
+        void await_tasks() const;
+        
+        bool elastic() const;
+        
+        void spawn_worker();
+        
+        bool retire_worker(std::size_t worker_index);
+        
+        std::size_t next_worker_queue();
+        
+        void watch_pressure();
+        
+        void relieve_pressure();
+        
+        Task *acquire_task();
+        
+        void release_task(Task *task);
+        
+        void release_tasks(TaskQueue &tasks);
+        
+        void release_tasks(Lanes &lanes);
+        
+        void do_submit(Task *task, TaskPriority priority, std::size_t affinity = no_affinity);
+        
+        TimerWheel &timers();
+        
+        void do_submit_all(TaskQueue &tasks, TaskPriority priority);
+        
+        std::size_t grain(std::size_t count, std::size_t grain_size) const;
+        
+        bool accepts_parallel_work() const;
+        
+        template<typename Body> void for_each_chunk(std::size_t begin, std::size_t end, std::size_t grain_size, TaskPriority priority, Body body){
+            if(begin >= end){
+                return;
+            }
+            std::size_t chunk_size = grain(end - begin, grain_size);
+            std::size_t first_end = std::min(end, begin + chunk_size);
+            if(first_end == end || !accepts_parallel_work()){
+                std::size_t chunk_index = 0;
+                for(std::size_t chunk_begin = begin; chunk_begin < end; chunk_begin += chunk_size, ++chunk_index){
+                    body(chunk_index, chunk_begin, std::min(end, chunk_begin + chunk_size));
+                }
+                return;
+            }
+            ParallelContext context;
+            TaskQueue tasks;
+            std::size_t chunk_index = 1;
+            try{
+                for(std::size_t chunk_begin = first_end; chunk_begin < end; chunk_begin += chunk_size, ++chunk_index){
+                    // every chunk task finishes its chunk when it is destroyed, even if it never runs
+                    context.group().add();
+                    ChunkTask<Body> chunk{ChunkGuard{&context}, &body, chunk_index, chunk_begin, std::min(end, chunk_begin + chunk_size)};
+                    tasks.push_back(task_allocator_.assign(acquire_task(), std::move(chunk)));
+                }
+            }catch(...){
+                release_tasks(tasks);
+                throw;
+            }
+            do_submit_all(tasks, priority);
+            context.execute(body, 0, begin, first_end);
+            wait(context.group());
+            context.rethrow();
+        };
         
         bool do_stop(State stopping_state);
         
@@ -138,6 +939,26 @@ namespace Game{
         FixedThreadPool &operator=(const FixedThreadPool &) = delete;
     };
     
+    ///
+    /// \class A thread pool that adds worker threads while tasks wait too long and retires them again when they stay idle
+    /// Growth is measured on the oldest queued task, which is checked on the pool's timer thread, so executing tasks takes no additional locks.
+    /// A check is armed when a task is queued in an empty lane and repeats every growth threshold while tasks stay queued, so an idle pool does not wake up.
+    ///
+    class ElasticThreadPool : public FixedThreadPool{
+    public:
+        
+        ///
+        /// Creates a new elastic thread pool
+        /// \param min_thread_count the amount of worker threads started by start() that never retire
+        /// \param max_thread_count the maximum amount of worker threads
+        /// \param growth_threshold a worker thread is added when the oldest queued task has waited longer than this
+        /// \param retire_timeout a worker thread above the minimum retires when it has been idle for this long
+        /// \param scheduling the way tasks are distributed over the worker threads
+        /// \param idle_policy what workers do when they run out of tasks
+        ///
+        ElasticThreadPool(std::size_t min_thread_count, std::size_t max_thread_count, Duration growth_threshold = std::chrono::milliseconds(2), Duration retire_timeout = std::chrono::seconds(5), Scheduling scheduling = Scheduling::SHARED_QUEUE, IdlePolicy idle_policy = IdlePolicy{});
+    };
+    
 }
 
 #endif	/* CONCURRENCY_H */
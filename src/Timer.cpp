@@ -0,0 +1,246 @@
+#include "Timer.h"
+
+using namespace Game;
+using namespace std;
+
+TimerWheel::Node::Node() : previous(), next(){
+}
+
+TimerWheel::Entry::Entry(Tick expiry_, Tick period_, Action &&action_) : Node(), expiry(expiry_), period(period_), action(move(action_)), cancelled(false), self(){
+}
+
+TimerWheel::State::State(TimerWheel *wheel_) : mutex(), wheel(wheel_){
+}
+
+TimerWheel::Handle::Handle() : state_(), entry_(){
+}
+
+TimerWheel::Handle::Handle(const shared_ptr<State> &state, const shared_ptr<Entry> &entry) : state_(state), entry_(entry){
+}
+
+bool TimerWheel::Handle::cancel(){
+    if(!entry_){
+        return false;
+    }
+    // declared before the lock, so a cancelled action is destroyed after unlocking
+    shared_ptr<Entry> keep_alive;
+    lock_guard<mutex> guard{state_->mutex};
+    return state_->wheel && state_->wheel->cancel(entry_.get(), keep_alive);
+}
+
+bool TimerWheel::Handle::active() const{
+    if(entry_){
+        lock_guard<mutex> guard{state_->mutex};
+        return state_->wheel && entry_->previous != nullptr;
+    }else{
+        return false;
+    }
+}
+
+TimerWheel::TimerWheel(Duration resolution) : resolution_(resolution), origin_(Clock::now()), state_(make_shared<State>(this)), mutex_(state_->mutex), condition_(), thread_(), stopping_(), levels_(), next_tick_(), size_(), expired_(), running_(){
+    for(Level &level : levels_){
+        for(Node &slot : level){
+            slot.previous = &slot;
+            slot.next = &slot;
+        }
+    }
+}
+
+TimerWheel::~TimerWheel(){
+    {
+        lock_guard<mutex> guard{mutex_};
+        stopping_ = true;
+        state_->wheel = nullptr;
+        condition_.notify_all();
+    }
+    if(thread_.joinable()){
+        thread_.join();
+    }
+    for(Level &level : levels_){
+        for(Node &slot : level){
+            while(slot.next != &slot){
+                Entry *entry = static_cast<Entry *>(slot.next);
+                unlink(entry);
+                entry->self.reset();
+            }
+        }
+    }
+}
+
+TimerWheel::Handle TimerWheel::schedule(TimePoint due, Duration period, Action action){
+    shared_ptr<Entry> entry = make_shared<Entry>(to_tick(due), period.count() > 0 ? max<Tick>(to_tick(origin_ + period), 1) : 0, move(action));
+    entry->self = entry;
+    lock_guard<mutex> guard{mutex_};
+    if(size_ == 0){
+        // nothing is pending, so the wheel can skip all ticks that passed since it was last used
+        next_tick_ = max(next_tick_, to_tick(Clock::now()));
+    }
+    insert(entry.get());
+    if(!thread_.joinable()){
+        thread_ = thread{&TimerWheel::run, this};
+    }
+    condition_.notify_one();
+    return Handle{state_, entry};
+}
+
+size_t TimerWheel::size() const{
+    lock_guard<mutex> guard{mutex_};
+    return size_;
+}
+
+Duration TimerWheel::resolution() const{
+    return resolution_;
+}
+
+TimerWheel::Tick TimerWheel::to_tick(TimePoint time) const{
+    if(time <= origin_){
+        return 0;
+    }else{
+        // round up: a timer may never expire early
+        return static_cast<Tick>((time - origin_ + resolution_ - Duration{1}) / resolution_);
+    }
+}
+
+TimePoint TimerWheel::to_time_point(Tick tick) const{
+    return origin_ + resolution_ * tick;
+}
+
+void TimerWheel::insert(Entry *entry){
+    Tick expiry = max(entry->expiry, next_tick_);
+    Tick delta = expiry - next_tick_;
+    for(size_t level = 0; level < level_count; ++level){
+        unsigned int shift = slot_bits * static_cast<unsigned int>(level);
+        if(level + 1 == level_count && (delta >> (shift + slot_bits)) > 0){
+            // beyond the range of the wheel: park it in the farthest slot, it is reinserted when that slot cascades
+            expiry = next_tick_ + (Tick{1} << (shift + slot_bits)) - 1;
+        }
+        if(level + 1 == level_count || (delta >> (shift + slot_bits)) == 0){
+            link(levels_[level][(expiry >> shift) & (slot_count - 1)], entry);
+            ++size_;
+            return;
+        }
+    }
+}
+
+void TimerWheel::link(Node &slot, Entry *entry){
+    entry->previous = slot.previous;
+    entry->next = &slot;
+    slot.previous->next = entry;
+    slot.previous = entry;
+}
+
+void TimerWheel::unlink(Entry *entry){
+    entry->previous->next = entry->next;
+    entry->next->previous = entry->previous;
+    entry->previous = nullptr;
+    entry->next = nullptr;
+}
+
+bool TimerWheel::cancel(Entry *entry, shared_ptr<Entry> &keep_alive){
+    if(entry->cancelled.exchange(true)){
+        return false;
+    }
+    if(entry->previous){
+        unlink(entry);
+        --size_;
+        keep_alive.swap(entry->self);
+    }
+    // otherwise the timer expired: a periodic timer is only rescheduled and a one shot action only started if it was not cancelled
+    return true;
+}
+
+void TimerWheel::cascade(size_t level, size_t slot){
+    Node &head = levels_[level][slot];
+    Node pending;
+    if(head.next == &head){
+        return;
+    }
+    // move the whole slot to a temporary list first, entries may be reinserted in the same slot
+    pending.next = head.next;
+    pending.previous = head.previous;
+    pending.next->previous = &pending;
+    pending.previous->next = &pending;
+    head.next = &head;
+    head.previous = &head;
+    while(pending.next != &pending){
+        Entry *entry = static_cast<Entry *>(pending.next);
+        unlink(entry);
+        --size_;
+        insert(entry);
+    }
+}
+
+void TimerWheel::process_tick(Tick now){
+    Tick tick = next_tick_;
+    for(size_t level = 1; level < level_count; ++level){
+        unsigned int shift = slot_bits * static_cast<unsigned int>(level);
+        if(((tick >> (shift - slot_bits)) & (slot_count - 1)) != 0){
+            break;
+        }
+        cascade(level, (tick >> shift) & (slot_count - 1));
+    }
+    Node &slot = levels_[0][tick & (slot_count - 1)];
+    while(slot.next != &slot){
+        Entry *entry = static_cast<Entry *>(slot.next);
+        unlink(entry);
+        --size_;
+        expired_.push_back(entry->self);
+        if(entry->period > 0){
+            entry->expiry += entry->period;
+            if(entry->expiry <= now){
+                // fell behind, e.g. while a long action ran: skip the missed runs but keep the phase
+                entry->expiry += ((now - entry->expiry) / entry->period + 1) * entry->period;
+            }
+        }else{
+            entry->self.reset();
+        }
+    }
+    ++next_tick_;
+}
+
+TimerWheel::Tick TimerWheel::next_wake_up_tick() const{
+    // the first occupied slot of the lowest level, or the next tick that cascades the higher levels
+    Tick boundary = (next_tick_ | (slot_count - 1)) + 1;
+    for(Tick tick = next_tick_; tick < boundary; ++tick){
+        const Node &slot = levels_[0][tick & (slot_count - 1)];
+        if(slot.next != &slot){
+            return tick;
+        }
+    }
+    return boundary;
+}
+
+void TimerWheel::run(){
+    unique_lock<mutex> lock{mutex_};
+    while(!stopping_){
+        if(size_ == 0){
+            condition_.wait(lock);
+            continue;
+        }
+        Tick now = to_tick(Clock::now());
+        while(next_tick_ <= now && expired_.empty()){
+            process_tick(now);
+        }
+        if(!expired_.empty()){
+            for(shared_ptr<Entry> &entry : expired_){
+                if(entry->period > 0 && !entry->cancelled){
+                    insert(entry.get());
+                }
+            }
+            // running_ is only used by this thread, swapping keeps the capacity of both lists
+            running_.swap(expired_);
+            lock.unlock();
+            for(shared_ptr<Entry> &entry : running_){
+                // a one shot action claims its run, so cancel() knows whether it stopped it
+                if(entry->period > 0 ? !entry->cancelled : !entry->cancelled.exchange(true)){
+                    entry->action();
+                }
+            }
+            // expired one shot actions and their captured state are destroyed here, outside of the lock
+            running_.clear();
+            lock.lock();
+            continue;
+        }
+        condition_.wait_until(lock, to_time_point(next_wake_up_tick()));
+    }
+}
@@ -0,0 +1,193 @@
+///
+/// \file contains a hierarchical timing wheel to run actions at a later time
+///
+
+#ifndef GAME_TIMER_H
+#define	GAME_TIMER_H
+
+#include "Object.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <array>
+#include <vector>
+
+namespace Game{
+
+    ///
+    /// \class A hierarchical timing wheel
+    /// Timers are kept in four levels of 64 slots, level n covering 64^n ticks per slot, so scheduling and cancelling a timer are O(1).
+    /// A single background thread sleeps until the next slot with timers is due and then runs the actions of the expired timers.
+    /// Actions are executed on that thread and should be short, e.g. submitting a task to a FixedThreadPool.
+    /// All member functions of this class are thread safe.
+    ///
+    class TimerWheel{
+    private:
+        struct Entry;
+
+        // shared with the handles, so they can tell the wheel was destroyed
+        struct State{
+            State(TimerWheel *wheel);
+
+            std::mutex mutex;
+            // nullptr once the wheel is being destroyed
+            TimerWheel *wheel;
+        };
+
+    public:
+
+        ///
+        /// the type of the action run when a timer expires
+        ///
+        using Action = std::function<void ()>;
+
+        ///
+        /// \class A handle to a scheduled timer
+        /// Handles are cheap to copy, all copies refer to the same timer
+        ///
+        class Handle{
+        public:
+
+            ///
+            /// Creates a handle that does not refer to any timer
+            ///
+            Handle();
+
+            ///
+            /// Cancels the timer
+            /// Actions that are already running are not interrupted, but no new runs are started after this call returns
+            /// \return true if the timer was cancelled, false if it was already cancelled, a one shot timer whose action already started
+            /// or its wheel was destroyed
+            ///
+            bool cancel();
+
+            ///
+            /// \return true if the timer is still scheduled, false otherwise or if its wheel was destroyed
+            ///
+            bool active() const;
+
+        private:
+            Handle(const std::shared_ptr<State> &state, const std::shared_ptr<Entry> &entry);
+
+            std::shared_ptr<State> state_;
+            std::shared_ptr<Entry> entry_;
+
+            friend class TimerWheel;
+        };
+
+        ///
+        /// Creates a new timer wheel
+        /// The background thread is only started when the first timer is scheduled
+        /// \param resolution the duration of a single tick, timers expire at the first tick after their due time
+        ///
+        explicit TimerWheel(Duration resolution = std::chrono::milliseconds(1));
+
+        ///
+        /// Stops the background thread and destroys all timers without running their actions
+        ///
+        ~TimerWheel();
+
+        ///
+        /// Schedules a new timer
+        /// \param due the time the action should run for the first time, times in the past expire at the next tick
+        /// \param period the time between subsequent runs, or Duration::zero() for a timer that runs only once
+        /// \param action the action
+        /// \return a handle to the new timer
+        ///
+        Handle schedule(TimePoint due, Duration period, Action action);
+
+        ///
+        /// \return the amount of scheduled timers
+        ///
+        std::size_t size() const;
+
+        ///
+        /// \return the duration of a single tick
+        ///
+        Duration resolution() const;
+
+    private:
+
+        using Tick = std::uint64_t;
+
+        static const std::size_t level_count = 4;
+
+        static const unsigned int slot_bits = 6;
+
+        static const std::size_t slot_count = std::size_t{1} << slot_bits;
+
+        struct Node{
+            Node();
+
+            Node *previous;
+            Node *next;
+        };
+
+        struct Entry : public Node{
+            Entry(Tick expiry, Tick period, Action &&action);
+
+            Tick expiry;
+            Tick period;
+            Action action;
+            // also set by a one shot timer when its action starts, whichever of the run and cancel() sets it first wins
+            std::atomic<bool> cancelled;
+
+            // keeps the entry alive while it is linked into the wheel
+            std::shared_ptr<Entry> self;
+        };
+
+        using Level = std::array<Node, slot_count>;
+
+        const Duration resolution_;
+        const TimePoint origin_;
+        const std::shared_ptr<State> state_;
+        std::mutex &mutex_;
+        std::condition_variable condition_;
+        std::thread thread_;
+        bool stopping_;
+        std::array<Level, level_count> levels_;
+        Tick next_tick_;
+        std::size_t size_;
+        std::vector<std::shared_ptr<Entry>> expired_;
+        std::vector<std::shared_ptr<Entry>> running_;
+
+        void run();
+
+        Tick to_tick(TimePoint time) const;
+
+        TimePoint to_time_point(Tick tick) const;
+
+        void insert(Entry *entry);
+
+        static void link(Node &slot, Entry *entry);
+
+        static void unlink(Entry *entry);
+
+        // requires the lock, the entry is moved to keep_alive so its action is destroyed after unlocking
+        bool cancel(Entry *entry, std::shared_ptr<Entry> &keep_alive);
+
+        // now is the current tick, which is later than the processed tick if the wheel fell behind
+        void process_tick(Tick now);
+
+        void cascade(std::size_t level, std::size_t slot);
+
+        Tick next_wake_up_tick() const;
+
+        TimerWheel(const TimerWheel &) = delete;
+        TimerWheel &operator=(const TimerWheel &) = delete;
+    };
+
+    ///
+    /// \typedef a handle to a timer scheduled on a TimerWheel
+    ///
+    using TimerHandle = TimerWheel::Handle;
+
+}
+
+#endif	/* GAME_TIMER_H */
+
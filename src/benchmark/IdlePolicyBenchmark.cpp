@@ -0,0 +1,68 @@
+///
+/// \file measures the submit to run latency and the idle CPU time of the FixedThreadPool idle policies
+/// Tasks are submitted one at a time at a fixed interval, so workers run out of tasks between submissions.
+/// Short intervals favour spinning, which avoids the wake up of a parked worker, long intervals show its cost in CPU time.
+/// The spin and yield durations are candidates: IdlePolicy has no spinning preset until they have been measured on a machine with several cores.
+/// On a single core machine the spin phase is skipped, see IdlePolicy, so spin_then_park only yields there.
+/// yield_then_park shows the yield phase alone on any machine.
+///
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+// the candidate durations of a spinning preset
+static const Duration spin_duration = chrono::microseconds(50);
+static const Duration yield_duration = chrono::microseconds(200);
+
+static double microseconds(Duration duration){
+    return chrono::duration<double, micro>(duration).count();
+}
+
+static void measure(const char *name, IdlePolicy policy, Duration interval, size_t count){
+    FixedThreadPool pool{1, FixedThreadPool::Scheduling::SHARED_QUEUE, policy};
+    pool.start();
+    vector<Duration> latencies(count);
+    // the worker parks or spins before the first submission, as it would between bursts
+    this_thread::sleep_for(chrono::milliseconds(10));
+    clock_t cpu_start = clock();
+    TimePoint start = Clock::now(), next = start;
+    for(size_t i = 0; i < count; ++i){
+        next += interval;
+        this_thread::sleep_until(next);
+        TimePoint submitted = Clock::now();
+        pool.submit([&latencies, i, submitted](){
+            latencies[i] = Clock::now() - submitted;
+        });
+    }
+    pool.wait_idle();
+    double wall = chrono::duration<double>(Clock::now() - start).count();
+    double cpu = static_cast<double>(clock() - cpu_start) / CLOCKS_PER_SEC;
+    pool.stop();
+
+    sort(latencies.begin(), latencies.end());
+    printf("%-16s interval %7.0f us: latency median %7.1f us, p99 %7.1f us, CPU %5.1f%% of wall time\n", name, microseconds(interval),
+            microseconds(latencies[count / 2]), microseconds(latencies[count * 99 / 100]), 100.0 * cpu / wall);
+}
+
+int main(){
+    unsigned int hardware_threads = thread::hardware_concurrency();
+    printf("%u hardware threads\n", hardware_threads);
+    if(hardware_threads < 2){
+        printf("the spin phase is skipped on a single core, spin_then_park does not spin in this run\n");
+    }
+    for(Duration interval : {Duration{chrono::microseconds(20)}, Duration{chrono::microseconds(100)}, Duration{chrono::milliseconds(1)}}){
+        size_t count = static_cast<size_t>(chrono::seconds(1) / interval);
+        measure("park", IdlePolicy::park(), interval, count);
+        measure("yield_then_park", IdlePolicy{Duration::zero(), yield_duration}, interval, count);
+        measure("spin_then_park", IdlePolicy{spin_duration, yield_duration}, interval, count);
+    }
+    return 0;
+}
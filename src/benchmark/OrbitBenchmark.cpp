@@ -0,0 +1,116 @@
+///
+/// \file measures the tick of an orbit tree of 200k objects, updated through GravityWell::update() and through a FlatOrbitTree
+/// The galaxy has 50 star systems of 20 planets with 199 moons each. The scenarios range from every orbit moving, which shows
+/// the cost per moving object, to a tree of stationary orbits, which the transform caching should skip.
+///
+
+#include "Orbit.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+enum class Scenario {
+    ALL_CIRCULAR,
+    STATIONARY_MOONS,
+    HALF_STATIONARY_SYSTEMS,
+    STATIONARY_TREE
+};
+
+struct Body : public MapObject {
+};
+
+class Galaxy {
+public:
+
+    Galaxy(Scenario scenario) : bodies_(), objects_(), orbits_(), root_(add_well()), count_() {
+        for(size_t s = 0; s < 50; ++s){
+            bool stationary_system = scenario == Scenario::STATIONARY_TREE || (scenario == Scenario::HALF_STATIONARY_SYSTEMS && s % 2 == 0);
+            GravityWell *star = add_well();
+            attach(root_, star, add_orbit(stationary_system));
+            for(size_t p = 0; p < 20; ++p){
+                GravityWell *planet = add_well();
+                attach(star, planet, add_orbit(stationary_system));
+                for(size_t m = 0; m < 199; ++m){
+                    bodies_.emplace_back(new Body{});
+                    objects_.emplace_back(new OrbitalObject{bodies_.back().get()});
+                    attach(planet, objects_.back().get(), add_orbit(scenario != Scenario::ALL_CIRCULAR));
+                }
+            }
+        }
+    }
+
+    GravityWell *root() const {
+        return root_;
+    }
+
+private:
+
+    GravityWell *add_well(){
+        bodies_.emplace_back(new Body{});
+        GravityWell *well = new GravityWell{bodies_.back().get()};
+        objects_.emplace_back(well);
+        return well;
+    }
+
+    Orbit *add_orbit(bool stationary){
+        size_t i = count_++;
+        if(stationary){
+            orbits_.emplace_back(new StaticOrbit{Position{static_cast<Coordinate>(i % 97), Coordinate{1}}});
+        }else{
+            orbits_.emplace_back(new CircularOrbit{static_cast<Coordinate>(1 + i % 97), chrono::seconds(10 + i % 13), static_cast<Coordinate>(i % 7)});
+        }
+        return orbits_.back().get();
+    }
+
+    vector<unique_ptr<Body>> bodies_;
+    vector<unique_ptr<OrbitalObject>> objects_;
+    vector<unique_ptr<Orbit>> orbits_;
+    GravityWell *root_;
+    size_t count_;
+};
+
+// the median tick in milliseconds, a tick advances the game by 16 ms
+template<typename Update> static double measure(Update update){
+    vector<double> ticks;
+    for(int i = 0; i < 43; ++i){
+        TimePoint start = Clock::now();
+        update(chrono::milliseconds(16 * i));
+        // the first ticks position everything once
+        if(i >= 3){
+            ticks.push_back(chrono::duration<double, milli>(Clock::now() - start).count());
+        }
+    }
+    sort(ticks.begin(), ticks.end());
+    return ticks[ticks.size() / 2];
+}
+
+static void measure(const char *name, Scenario scenario){
+    double pointer, flat;
+    {
+        Galaxy galaxy{scenario};
+        pointer = measure([&galaxy](Duration current){
+            galaxy.root()->update(current);
+        });
+    }
+    {
+        Galaxy galaxy{scenario};
+        FlatOrbitTree tree{galaxy.root()};
+        flat = measure([&tree](Duration current){
+            tree.update(current);
+        });
+    }
+    printf("%-28s GravityWell::update %7.2f ms, FlatOrbitTree::update %7.2f ms\n", name, pointer, flat);
+}
+
+int main(){
+    measure("all circular", Scenario::ALL_CIRCULAR);
+    measure("stationary moons", Scenario::STATIONARY_MOONS);
+    measure("half stationary systems", Scenario::HALF_STATIONARY_SYSTEMS);
+    measure("stationary tree", Scenario::STATIONARY_TREE);
+    return 0;
+}
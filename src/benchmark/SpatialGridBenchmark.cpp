@@ -0,0 +1,170 @@
+///
+/// \file measures the radius, rectangle and nearest neighbour queries of a SpatialGrid against a brute force scan of every object
+/// The objects are spread uniformly with the same density at every size, so a query finds about as many objects at 10k, 100k and 1M objects
+/// and only the scan grows with the size. Moving every object once shows what the grid adds to MapObject::position().
+///
+
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+struct Body : public MapObject {
+};
+
+// the area per object, and the cell size and query sizes near it
+static const double spacing = 10.0;
+static const double cell_size = 50.0;
+static const double radius = 50.0;
+static const double viewport_width = 400.0;
+static const double viewport_height = 300.0;
+static const size_t neighbours = 8;
+// of each kind, at every size
+static const size_t queries = 100;
+
+static double microseconds(Duration duration){
+    return chrono::duration<double, micro>(duration).count();
+}
+
+static double squared_distance(const MapObject &object, double x, double y){
+    double dx = static_cast<double>(object.position().x) - x, dy = static_cast<double>(object.position().y) - y;
+    return dx * dx + dy * dy;
+}
+
+static void brute_within(const vector<unique_ptr<Body>> &bodies, const Position &center, vector<MapObject *> &result){
+    result.clear();
+    double x = static_cast<double>(center.x), y = static_cast<double>(center.y);
+    for(const unique_ptr<Body> &body : bodies){
+        if(squared_distance(*body, x, y) <= radius * radius){
+            result.push_back(body.get());
+        }
+    }
+}
+
+static void brute_inside(const vector<unique_ptr<Body>> &bodies, const Position &minimum, const Position &maximum, vector<MapObject *> &result){
+    result.clear();
+    for(const unique_ptr<Body> &body : bodies){
+        const Position &position = body->position();
+        if(position.x >= minimum.x && position.x <= maximum.x && position.y >= minimum.y && position.y <= maximum.y){
+            result.push_back(body.get());
+        }
+    }
+}
+
+static void brute_nearest(const vector<unique_ptr<Body>> &bodies, const Position &point, vector<pair<double, MapObject *>> &candidates, vector<MapObject *> &result){
+    result.clear();
+    candidates.clear();
+    double x = static_cast<double>(point.x), y = static_cast<double>(point.y);
+    for(const unique_ptr<Body> &body : bodies){
+        candidates.emplace_back(squared_distance(*body, x, y), body.get());
+    }
+    size_t count = min(neighbours, candidates.size());
+    partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+    for(size_t i = 0; i < count; ++i){
+        result.push_back(candidates[i].second);
+    }
+}
+
+// the average time of a query in microseconds, the found objects are summed so the queries are not optimized away
+template<typename Query> static double measure(const vector<Position> &points, size_t &found, Query query){
+    vector<MapObject *> result;
+    TimePoint start = Clock::now();
+    for(const Position &point : points){
+        query(point, result);
+        found += result.size();
+    }
+    return microseconds(Clock::now() - start) / points.size();
+}
+
+static void report(const char *name, double brute_force, double grid){
+    printf("    %-20s brute force %10.2f us, grid %8.2f us per query, %7.1fx faster\n", name, brute_force, grid, brute_force / grid);
+}
+
+static void measure(size_t count){
+    double side = sqrt(static_cast<double>(count)) * spacing;
+    mt19937 random{static_cast<mt19937::result_type>(count)};
+    uniform_real_distribution<double> coordinate{0.0, side};
+    vector<unique_ptr<Body>> bodies;
+    bodies.reserve(count);
+    for(size_t i = 0; i < count; ++i){
+        bodies.emplace_back(new Body{});
+        bodies.back()->position(Position{static_cast<Coordinate>(coordinate(random)), static_cast<Coordinate>(coordinate(random))});
+    }
+
+    vector<Position> points(queries);
+    for(Position &point : points){
+        point = Position{static_cast<Coordinate>(coordinate(random)), static_cast<Coordinate>(coordinate(random))};
+    }
+    Position half_viewport{static_cast<Coordinate>(viewport_width / 2), static_cast<Coordinate>(viewport_height / 2)};
+    vector<pair<double, MapObject *>> candidates;
+    size_t brute_found = 0, grid_found = 0;
+
+    double brute_radius = measure(points, brute_found, [&](const Position &point, vector<MapObject *> &result){
+        brute_within(bodies, point, result);
+    });
+    double brute_rectangle = measure(points, brute_found, [&](const Position &point, vector<MapObject *> &result){
+        brute_inside(bodies, point - half_viewport, point + half_viewport, result);
+    });
+    double brute_neighbours = measure(points, brute_found, [&](const Position &point, vector<MapObject *> &result){
+        brute_nearest(bodies, point, candidates, result);
+    });
+
+    double build, grid_radius, grid_rectangle, grid_neighbours, indexed_move;
+    // every object moves a little, some of them to another cell
+    Position step{static_cast<Coordinate>(spacing / 4), static_cast<Coordinate>(spacing / 8)};
+    {
+        TimePoint start = Clock::now();
+        SpatialGrid grid{static_cast<Coordinate>(cell_size)};
+        for(const unique_ptr<Body> &body : bodies){
+            grid.insert(body.get());
+        }
+        build = microseconds(Clock::now() - start) / 1000.0;
+
+        grid_radius = measure(points, grid_found, [&](const Position &point, vector<MapObject *> &result){
+            grid.within(point, static_cast<Coordinate>(radius), result);
+        });
+        grid_rectangle = measure(points, grid_found, [&](const Position &point, vector<MapObject *> &result){
+            grid.inside(point - half_viewport, point + half_viewport, result);
+        });
+        grid_neighbours = measure(points, grid_found, [&](const Position &point, vector<MapObject *> &result){
+            grid.nearest(point, neighbours, result);
+        });
+
+        start = Clock::now();
+        for(const unique_ptr<Body> &body : bodies){
+            body->position(body->position() + step);
+        }
+        indexed_move = microseconds(Clock::now() - start) / 1000.0;
+    }
+    // the grid removed the objects when it was destroyed
+    TimePoint start = Clock::now();
+    for(const unique_ptr<Body> &body : bodies){
+        body->position(body->position() - step);
+    }
+    double plain_move = microseconds(Clock::now() - start) / 1000.0;
+
+    char name[32];
+    printf("%zu objects, %zu objects found by brute force and %zu by the grid\n", count, brute_found, grid_found);
+    snprintf(name, sizeof(name), "radius %.0f", radius);
+    report(name, brute_radius, grid_radius);
+    snprintf(name, sizeof(name), "rectangle %.0fx%.0f", viewport_width, viewport_height);
+    report(name, brute_rectangle, grid_rectangle);
+    snprintf(name, sizeof(name), "%zu nearest", neighbours);
+    report(name, brute_neighbours, grid_neighbours);
+    printf("    building the grid %.2f ms, moving every object %.2f ms indexed and %.2f ms without a grid\n", build, indexed_move, plain_move);
+}
+
+int main(){
+    for(size_t count : {size_t{10000}, size_t{100000}, size_t{1000000}}){
+        measure(count);
+    }
+    return 0;
+}
@@ -28,12 +28,20 @@ static const unordered_map<string, Log::Level> log_level_parameters{
     {"none", Log::Level::none}
 };
 
+static const unordered_map<string, FixedThreadPool::Scheduling> executor_parameters{
+    {"shared", FixedThreadPool::Scheduling::SHARED_QUEUE},
+    {"stealing", FixedThreadPool::Scheduling::WORK_STEALING},
+    {"inline", FixedThreadPool::Scheduling::INLINE},
+    {"deterministic", FixedThreadPool::Scheduling::DETERMINISTIC}
+};
+
 Call parse_arguments(int arg_count, const char **args) {
     ArgumentParser parser{
         ArgumentDefinition{"module ID", "module", 'm', "default", false},
         ArgumentDefinition{"language ID", "language", 'l', "en", false},
         ArgumentDefinition{"data path", "data", 'd', "", false},
-        ArgumentDefinition{"logger verbosity", "verbosity", 'v', "info", false}
+        ArgumentDefinition{"logger verbosity", "verbosity", 'v', "info", false},
+        ArgumentDefinition{"executor scheduling", "executors", 'e', "shared", false}
     };
     return parser.parse(arg_count, args);
 };
@@ -52,6 +60,20 @@ Log::Level get_log_level(const Arguments &args){
     }
 };
 
+FixedThreadPool::Scheduling get_executor_scheduling(const Arguments &args){
+    auto found = args.find("executor scheduling");
+    if(found == args.end()){
+        return FixedThreadPool::Scheduling::SHARED_QUEUE;
+    }else{
+        auto found_scheduling = executor_parameters.find(found->second);
+        if(found_scheduling == executor_parameters.end()){
+            throw ArgumentError{"unknown executor scheduling: " + found->second};
+        }else{
+            return found_scheduling->second;
+        }
+    }
+};
+
 template<typename T> T add(T first, T second){
     return first + second;
 };
@@ -71,7 +93,7 @@ int main(int arg_count, const char **args) {
     logger.debug("starting subsystems");
     ApplicationSystemGuard<FileSystem> file_system_guard(call);
     ApplicationSystemGuard<ModuleSystem> module_system_guard(call.arguments["module ID"], call.arguments["language ID"]);
-    ApplicationSystemGuard<ScriptSystem> script_system_guard;
+    ApplicationSystemGuard<ScriptSystem> script_system_guard(size_t{4}, get_executor_scheduling(call.arguments));
     ApplicationSystemGuard<ResourceSystem> resource_system_guard;
     
     script_system_guard->run(ScriptContext{"GameUtilsExt"},BufferedScript{"test","print \"Hello World\"\n"});
@@ -88,6 +110,8 @@ int main(int arg_count, const char **args) {
     ScriptCallResult result = script_system_guard->submit_call(fn);
     
     cout << result.get<std::string>() << endl;
+    
+    logger.debug("script executor statistics:").debug_lines(script_system_guard->executors().statistics());
         
     return 0;
 }
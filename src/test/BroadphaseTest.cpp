@@ -0,0 +1,147 @@
+///
+/// \file contains the tests of SweepAndPrune
+///
+
+#include "Broadphase.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+struct Body : public MapObject {
+};
+
+using Pair = pair<MapObject *, MapObject *>;
+
+static Pair make_ordered(MapObject *first, MapObject *second){
+    return first < second ? Pair{first, second} : Pair{second, first};
+}
+
+// every pair within the distance, including the distance itself
+static set<Pair> all_pairs(const vector<MapObject *> &objects, const AbsolutePosition *anchor, Coordinate distance){
+    set<Pair> result;
+    double limit = static_cast<double>(distance) * static_cast<double>(distance);
+    for(size_t i = 0; i < objects.size(); ++i){
+        Position first = relative_position(*objects[i], anchor);
+        for(size_t j = i + 1; j < objects.size(); ++j){
+            Position second = relative_position(*objects[j], anchor);
+            double dx = static_cast<double>(second.x) - static_cast<double>(first.x), dy = static_cast<double>(second.y) - static_cast<double>(first.y);
+            if(dx * dx + dy * dy <= limit){
+                result.insert(make_ordered(objects[i], objects[j]));
+            }
+        }
+    }
+    return result;
+}
+
+// objects on a small grid of integer positions, so many pairs are exactly at the distance of 5, e.g. 3 and 4 apart
+static void moving_frames(const AbsolutePosition *anchor){
+    mt19937 random{3};
+    uniform_int_distribution<int> coordinate{0, 30};
+    uniform_int_distribution<int> step{-2, 2};
+    uniform_int_distribution<int> operation{0, 19};
+    auto random_position = [&](){
+        return Position{Coordinate(coordinate(random)), Coordinate(coordinate(random))};
+    };
+    vector<unique_ptr<Body>> bodies;
+    for(size_t i = 0; i < 150; ++i){
+        bodies.emplace_back(new Body{});
+        bodies.back()->position(random_position());
+    }
+    SweepAndPrune broadphase{Coordinate{5}, anchor};
+    vector<MapObject *> added, removed;
+    for(size_t i = 0; i < 120; ++i){
+        broadphase.add(bodies[i].get());
+        added.push_back(bodies[i].get());
+    }
+    for(size_t i = 120; i < bodies.size(); ++i){
+        removed.push_back(bodies[i].get());
+    }
+    set<Pair> previous;
+    for(size_t frame = 0; frame < 200; ++frame){
+        for(size_t i = 0; i < added.size();){
+            int kind = operation(random);
+            if(kind == 0){
+                // its pairs end without exit events, the next object in its slot does not inherit them
+                check(broadphase.remove(added[i]), "an added object is removed");
+                for(set<Pair>::iterator pair = previous.begin(); pair != previous.end();){
+                    pair = pair->first == added[i] || pair->second == added[i] ? previous.erase(pair) : next(pair);
+                }
+                removed.push_back(added[i]);
+                added.erase(added.begin() + i);
+                continue;
+            }
+            if(kind < 10){
+                added[i]->position(added[i]->position() + Position{Coordinate(step(random)), Coordinate(step(random))});
+            }
+            ++i;
+        }
+        // removed objects come back in the freed slots, at a new position or the old one
+        while(!removed.empty() && operation(random) < 3){
+            size_t index = uniform_int_distribution<size_t>{0, removed.size() - 1}(random);
+            if(operation(random) < 10){
+                removed[index]->position(random_position());
+            }
+            broadphase.add(removed[index]);
+            added.push_back(removed[index]);
+            removed.erase(removed.begin() + index);
+        }
+        check(!broadphase.remove(removed.empty() ? nullptr : removed.front()), "an object that is not added is not removed");
+        check(broadphase.size() == added.size(), "a broadphase counts its objects");
+
+        const vector<ProximityEvent> &events = broadphase.update();
+        set<Pair> current = all_pairs(added, anchor, broadphase.distance());
+        set<tuple<ProximityEvent::Type, MapObject *, MapObject *>> expected, reported;
+        for(const Pair &pair : current){
+            if(!previous.count(pair)){
+                expected.emplace(ProximityEvent::Type::ENTER, pair.first, pair.second);
+            }
+        }
+        for(const Pair &pair : previous){
+            if(!current.count(pair)){
+                expected.emplace(ProximityEvent::Type::EXIT, pair.first, pair.second);
+            }
+        }
+        for(const ProximityEvent &event : events){
+            Pair pair = make_ordered(event.first, event.second);
+            reported.emplace(event.type, pair.first, pair.second);
+        }
+        check(reported.size() == events.size(), "every event is reported once");
+        check(reported == expected, "the events are the pairs that entered and exited the distance since the last update");
+        check(broadphase.pair_count() == current.size(), "the broadphase finds every pair within the distance");
+        previous = current;
+    }
+}
+
+// the distance itself is within the distance, anything beyond it is not
+static void boundary(){
+    Body first, second, third;
+    first.position(Position{Coordinate{0}, Coordinate{0}});
+    second.position(Position{Coordinate{3}, Coordinate{4}});
+    third.position(Position{Coordinate{-5}, Coordinate{0}});
+    SweepAndPrune broadphase{Coordinate{5}};
+    broadphase.add(&first);
+    broadphase.add(&second);
+    broadphase.add(&third);
+    check(broadphase.update().size() == 2 && broadphase.pair_count() == 2, "objects exactly at the distance enter");
+    second.position(Position{Coordinate{3}, static_cast<Coordinate>(4.001)});
+    const vector<ProximityEvent> &events = broadphase.update();
+    check(events.size() == 1 && events[0].type == ProximityEvent::Type::EXIT && broadphase.pair_count() == 1, "objects beyond the distance exit");
+    check(broadphase.update().empty(), "nothing changes without moves");
+}
+
+int main(){
+    moving_frames(nullptr);
+    AbsolutePosition anchor{Position{Coordinate{-20}, Coordinate{13}}};
+    moving_frames(&anchor);
+    boundary();
+    return test_result();
+}
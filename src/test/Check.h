@@ -0,0 +1,42 @@
+///
+/// \file contains the checks shared by the tests
+/// Every test is a standalone program: a failed check prints its description and the program returns test_result() from main
+///
+
+#ifndef GAME_TEST_CHECK_H
+#define	GAME_TEST_CHECK_H
+
+#include <cstdio>
+
+///
+/// \return the amount of failed checks of this test program, can be incremented by checks with their own message
+///
+inline int &failure_count(){
+    static int count = 0;
+    return count;
+}
+
+///
+/// Counts a failed check and prints its description
+/// \param condition the condition that should hold
+/// \param description what the check verifies
+///
+inline void check(bool condition, const char *description){
+    if(!condition){
+        ++failure_count();
+        std::printf("failed: %s\n", description);
+    }
+}
+
+///
+/// Reports the result of all checks
+/// \return the exit code of the test program, non zero if a check failed
+///
+inline int test_result(){
+    if(failure_count() == 0){
+        std::printf("all tests passed\n");
+    }
+    return failure_count() == 0 ? 0 : 1;
+}
+
+#endif	/* GAME_TEST_CHECK_H */
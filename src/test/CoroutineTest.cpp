@@ -0,0 +1,178 @@
+///
+/// \file contains the tests of the coroutines in Coroutine.h, only built with GAME_COROUTINES
+///
+
+#include "Check.h"
+#include "Coroutine.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+// Game::launch() is qualified since std::launch is visible too
+
+static Coroutine<thread::id> thread_after_schedule(FixedThreadPool &pool){
+    co_await pool.schedule();
+    co_return this_thread::get_id();
+}
+
+static Coroutine<int> twice(FixedThreadPool &pool, int value){
+    co_await pool.schedule();
+    co_return value * 2;
+}
+
+static Coroutine<void> count_on_pool(FixedThreadPool &pool, atomic<int> &count){
+    co_await pool.schedule();
+    ++count;
+}
+
+static Coroutine<int> fail_on_pool(FixedThreadPool &pool, atomic<int> &count){
+    co_await pool.schedule();
+    ++count;
+    throw runtime_error{"coroutine"};
+}
+
+static Coroutine<int> await_future(Future<int> future){
+    int value = co_await std::move(future);
+    co_return value + 1;
+}
+
+// catches the error of an awaited coroutine, so the awaiting coroutine finishes normally
+static Coroutine<bool> catch_awaited(FixedThreadPool &pool){
+    atomic<int> count{0};
+    try{
+        co_await fail_on_pool(pool, count);
+    }catch(const runtime_error &){
+        co_return count == 1;
+    }
+    co_return false;
+}
+
+template<typename T> static bool throws_runtime_error(Future<T> future){
+    try{
+        future.get();
+    }catch(const runtime_error &){
+        return true;
+    }
+    return false;
+}
+
+// a coroutine starts on the thread that launches it and continues on a worker after schedule()
+static void schedule(){
+    FixedThreadPool pool{2};
+    pool.start();
+    thread::id worker = Game::launch(thread_after_schedule(pool)).get();
+    check(worker != this_thread::get_id(), "a scheduled coroutine continues on a worker of the pool");
+    pool.stop();
+
+    // a coroutine scheduled on a stopped pool resumes once the pool starts
+    Future<int> future = Game::launch(twice(pool, 4));
+    check(!future.ready(), "a coroutine scheduled on a stopped pool waits");
+    pool.start();
+    check(future.get() == 8, "a coroutine scheduled on a stopped pool resumes after start()");
+    pool.stop();
+}
+
+static void future_await(){
+    FixedThreadPool pool{2};
+    pool.start();
+    Promise<int> ready_promise;
+    Future<int> ready = ready_promise.future();
+    ready_promise.set_value(1);
+    check(Game::launch(await_future(std::move(ready))).get() == 2, "a coroutine continues with the value of a ready future");
+
+    // the value is stored after the coroutine suspended, or while it suspends
+    for(int attempt = 0; attempt < 1000; ++attempt){
+        Promise<int> promise;
+        Future<int> result = Game::launch(await_future(promise.future()));
+        pool.submit([&promise, attempt](){
+            promise.set_value(attempt);
+        });
+        check(result.get() == attempt + 1, "a coroutine resumes with the value of the awaited future");
+    }
+    pool.stop();
+}
+
+static void exception_propagation(){
+    FixedThreadPool pool{2};
+    pool.start();
+    atomic<int> count{0};
+    check(throws_runtime_error(Game::launch(fail_on_pool(pool, count))), "the future of a launched coroutine receives its error");
+    check(Game::launch(catch_awaited(pool)).get(), "an awaiting coroutine catches the error of the awaited coroutine");
+    Promise<int> promise;
+    Future<int> result = Game::launch(await_future(promise.future()));
+    promise.set_exception(make_exception_ptr(runtime_error{"promise"}));
+    check(throws_runtime_error(std::move(result)), "awaiting a future rethrows its error in the coroutine");
+    check(throws_runtime_error(Game::launch(await_future(pool.submit_async([]() -> int {
+        throw runtime_error{"task"};
+    })))), "awaiting the future of a failed task rethrows its error in the coroutine");
+    pool.stop();
+}
+
+static void when_all_vector(){
+    FixedThreadPool pool{4, FixedThreadPool::Scheduling::WORK_STEALING};
+    pool.start();
+    for(int attempt = 0; attempt < 200; ++attempt){
+        vector<Coroutine<int>> coroutines;
+        for(int i = 0; i < 50; ++i){
+            coroutines.push_back(twice(pool, i));
+        }
+        vector<int> results = Game::launch(when_all(std::move(coroutines))).get();
+        bool ordered = results.size() == 50;
+        for(size_t i = 0; ordered && i < results.size(); ++i){
+            ordered = results[i] == static_cast<int>(i) * 2;
+        }
+        check(ordered, "when_all() gives the results in the order of the coroutines");
+    }
+
+    atomic<int> count{0};
+    vector<Coroutine<void>> coroutines;
+    for(int i = 0; i < 20; ++i){
+        coroutines.push_back(count_on_pool(pool, count));
+    }
+    Game::launch(when_all(std::move(coroutines))).get();
+    check(count == 20, "when_all() of coroutines without a result finishes after all of them");
+
+    // the error is only reported after every coroutine has finished
+    count = 0;
+    vector<Coroutine<int>> failing;
+    for(int i = 0; i < 20; ++i){
+        failing.push_back(i == 3 ? fail_on_pool(pool, count) : twice(pool, i));
+    }
+    check(throws_runtime_error(Game::launch(when_all(std::move(failing)))), "when_all() rethrows the error of a coroutine");
+    check(count == 1, "when_all() runs the coroutine that fails once");
+    check(Game::launch(when_all(vector<Coroutine<int>>{})).get().empty(), "when_all() of no coroutines finishes at once");
+    pool.stop();
+}
+
+static void when_all_tuple(){
+    FixedThreadPool pool{4};
+    pool.start();
+    atomic<int> count{0};
+    for(int attempt = 0; attempt < 200; ++attempt){
+        tuple<int, monostate, thread::id> results = Game::launch(when_all(twice(pool, attempt), count_on_pool(pool, count), thread_after_schedule(pool))).get();
+        check(get<0>(results) == attempt * 2, "when_all() of different coroutines gives each result in its place");
+        check(get<2>(results) != this_thread::get_id(), "when_all() of different coroutines runs them where they schedule themselves");
+    }
+    check(count == 200, "when_all() of different coroutines runs the coroutines without a result");
+
+    count = 0;
+    check(throws_runtime_error(Game::launch(when_all(count_on_pool(pool, count), fail_on_pool(pool, count), twice(pool, 1)))), "when_all() of different coroutines rethrows the error of a coroutine");
+    check(count == 2, "when_all() of different coroutines finishes every coroutine before the error is rethrown");
+    pool.stop();
+}
+
+int main(){
+    schedule();
+    future_await();
+    exception_propagation();
+    when_all_vector();
+    when_all_tuple();
+    return test_result();
+}
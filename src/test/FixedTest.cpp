@@ -0,0 +1,109 @@
+///
+/// \file contains the tests of Fixed and of the orbits with fixed point coordinates
+/// The expected values are golden: fixed point results are defined bit by bit, so any difference is a regression, e.g. of replays
+///
+
+#include "Check.h"
+#include "Fixed.h"
+#include "Orbit.h"
+
+#include <memory>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+// negative operands take the paths that scale a negative 128 bit value
+static void negative_operands(){
+    check(Fixed::ratio(-7, 3).raw() == -10021590357, "a negative ratio truncates toward zero");
+    check(Fixed::ratio(5, -2).raw() == -10737418240, "a ratio with a negative denominator is exact");
+    check((Fixed{-3.5} / Fixed{1.25}).raw() == -12025908428, "a negative dividend truncates toward zero");
+    check((Fixed{7} / Fixed{-0.3}).raw() == -100215903557, "a negative divisor truncates toward zero");
+}
+
+static void sine_and_cosine(){
+    struct Golden{
+        double angle;
+        std::int64_t sine;
+        std::int64_t cosine;
+    };
+    const Golden goldens[] = {
+        {-1000.25, -4038594978, 1461675299},
+        {-2.0, -3905402711, -1787337053},
+        {-0.5, -2059117009, 3769188403},
+        {0.0, 0, 4294967296},
+        {1.0, 3614090360, 2320580734},
+        {3.0, 606105819, -4251985396},
+        {123456.789, -4289229573, 221931839}
+    };
+    for(const Golden &golden : goldens){
+        Fixed sine, cosine;
+        sincos(Fixed{golden.angle}, sine, cosine);
+        check(sine.raw() == golden.sine && cosine.raw() == golden.cosine, "sincos() gives the golden values");
+    }
+}
+
+#ifdef GAME_FIXED_COORDINATES
+
+struct Body : public MapObject {
+};
+
+// a hash of the positions of every object after every tick of a tree with circular and static orbits, three levels deep
+static std::uint64_t orbit_path(bool flat){
+    vector<unique_ptr<Body>> bodies;
+    vector<unique_ptr<OrbitalObject>> objects;
+    vector<unique_ptr<Orbit>> orbits;
+    bodies.emplace_back(new Body{});
+    GravityWell *root = new GravityWell{bodies.back().get()};
+    objects.emplace_back(root);
+    vector<GravityWell *> wells{root};
+    for(int i = 0; i < 40; ++i){
+        bodies.emplace_back(new Body{});
+        GravityWell *well = i % 4 == 0 ? new GravityWell{bodies.back().get()} : nullptr;
+        objects.emplace_back(well ? well : new OrbitalObject{bodies.back().get()});
+        if(i % 5 == 3){
+            orbits.emplace_back(new StaticOrbit{Position{Coordinate(i), Coordinate(-i)}});
+        }else{
+            orbits.emplace_back(new CircularOrbit{Coordinate(1 + i * 3), chrono::seconds(7 + i), Fixed::ratio(i, 7)});
+        }
+        attach(wells[i % wells.size()], objects.back().get(), orbits.back().get());
+        if(well){
+            wells.push_back(well);
+        }
+    }
+    unique_ptr<FlatOrbitTree> tree{flat ? new FlatOrbitTree{root} : nullptr};
+    // FNV-1a over the raw coordinates
+    std::uint64_t hash = 14695981039346656037ull;
+    for(int t = 0; t < 1000; ++t){
+        // irregular time steps and several turns of every orbit
+        Duration current = chrono::milliseconds(16 * t + 7 * t * t);
+        if(tree){
+            tree->update(current);
+        }else{
+            root->update(current);
+        }
+        for(const unique_ptr<Body> &body : bodies){
+            for(std::int64_t raw : {body->position().x.raw(), body->position().y.raw()}){
+                hash ^= static_cast<std::uint64_t>(raw);
+                hash *= 1099511628211ull;
+            }
+        }
+    }
+    return hash;
+}
+
+static void golden_orbit_path(){
+    check(orbit_path(false) == 15440377981608129385ull, "GravityWell::update() gives the golden fixed point orbit path");
+    check(orbit_path(true) == 15440377981608129385ull, "FlatOrbitTree::update() gives the golden fixed point orbit path");
+}
+
+#endif
+
+int main(){
+    negative_operands();
+    sine_and_cosine();
+#ifdef GAME_FIXED_COORDINATES
+    golden_orbit_path();
+#endif
+    return test_result();
+}
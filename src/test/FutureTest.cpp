@@ -0,0 +1,172 @@
+///
+/// \file contains the tests of Future and Promise
+///
+
+#include "Check.h"
+#include "Future.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace Game;
+using namespace std;
+
+// a value that counts its live instances, so a value left behind in a recycled state shows up
+struct Tracked{
+    explicit Tracked(int value_) : value(value_){
+        ++live_count;
+    }
+
+    Tracked(Tracked &&tracked) : value(tracked.value){
+        ++live_count;
+    }
+
+    ~Tracked(){
+        --live_count;
+    }
+
+    int value;
+
+    static atomic<int> live_count;
+};
+
+atomic<int> Tracked::live_count{0};
+
+// a continuation attached to a future that is already ready still runs
+static void then_after_ready(){
+    FixedThreadPool pool{2};
+    pool.start();
+    Promise<int> promise;
+    Future<int> future = promise.future();
+    promise.set_value(20);
+    check(future.ready(), "a future is ready once its value is set");
+    Future<int> continued = future.then(pool, [](int value){
+        return value + 1;
+    });
+    check(!future.valid(), "then() takes the state of the future");
+    check(continued.wait_for(chrono::seconds(10)) && continued.get() == 21, "a continuation attached after the value is set receives the value");
+
+    Future<void> done = pool.submit_async([](){
+    });
+    done.wait();
+    thread::id caller = this_thread::get_id();
+    bool on_caller = false;
+    done.on_ready([&on_caller, caller](){
+        on_caller = this_thread::get_id() == caller;
+    });
+    check(on_caller, "on_ready() on a ready future runs the callable on the calling thread");
+    pool.stop();
+}
+
+// an error skips every function of a chain and reaches the last future
+static void chained_errors(){
+    FixedThreadPool pool{2};
+    pool.start();
+    atomic<size_t> called_count{0};
+    Future<int> failed = pool.submit_async([]() -> int{
+        throw runtime_error{"first task failed"};
+    });
+    Future<string> last = failed.then(pool, [&called_count](int value){
+        ++called_count;
+        return value * 2;
+    }).then(pool, [&called_count](int value){
+        ++called_count;
+        return to_string(value);
+    });
+    string message;
+    try{
+        last.get();
+    }catch(const runtime_error &error){
+        message = error.what();
+    }
+    check(message == "first task failed", "an error is passed through a chain of continuations");
+    check(called_count == 0, "the functions of a chain are not called after an error");
+
+    Future<int> thrown = pool.submit_async([](){
+        return 1;
+    }).then(pool, [](int) -> int{
+        throw logic_error{"continuation failed"};
+    }).then(pool, [&called_count](int value){
+        ++called_count;
+        return value;
+    });
+    message.clear();
+    try{
+        thrown.get();
+    }catch(const logic_error &error){
+        message = error.what();
+    }
+    check(message == "continuation failed" && called_count == 0, "an error thrown by a continuation is passed to the rest of the chain");
+    pool.stop();
+}
+
+// a recycled state starts without the value, error or continuation of its previous future
+static void recycled_states(){
+    FutureState<Tracked> *state = FutureState<Tracked>::create();
+    state->release();
+    FutureState<Tracked> *recycled = FutureState<Tracked>::create();
+    check(recycled == state, "a released state is recycled");
+    recycled->release();
+
+    {
+        Promise<Tracked> promise;
+        Future<Tracked> future = promise.future();
+        promise.set_value(7);
+    }
+    check(Tracked::live_count == 0, "the value a future never retrieved is destroyed when its state is recycled");
+    {
+        Promise<Tracked> promise;
+        Future<Tracked> future = promise.future();
+        check(!future.ready(), "a future with a recycled state is not ready");
+        promise.set_value(8);
+        check(future.get().value == 8, "a future with a recycled state receives its own value");
+    }
+    {
+        Promise<Tracked> promise;
+        Future<Tracked> future = promise.future();
+        promise.set_exception(make_exception_ptr(runtime_error{"failed"}));
+    }
+    {
+        Future<Tracked> future;
+        {
+            Promise<Tracked> promise;
+            future = promise.future();
+            check(!future.ready(), "a future with a state recycled after an error is not ready");
+        }
+        bool broken = false;
+        try{
+            future.get();
+        }catch(const future_error &error){
+            broken = error.code() == future_errc::broken_promise;
+        }
+        check(broken, "a future with a state recycled after an error receives its own error");
+    }
+    check(Tracked::live_count == 0, "no values are left in recycled states");
+
+    // warm states of a pool are reused by the next futures, which still see their own values
+    FixedThreadPool pool{2};
+    pool.start();
+    bool all_values = true;
+    for(int i = 0; i < 1000; ++i){
+        Future<int> future = pool.submit_async([i](){
+            return i;
+        }).then(pool, [](int value){
+            return value * 3;
+        });
+        all_values = all_values && future.get() == i * 3;
+    }
+    check(all_values, "futures with recycled states receive the values of their own tasks");
+    pool.stop();
+}
+
+int main(){
+    then_after_ready();
+    chained_errors();
+    recycled_states();
+    return test_result();
+}
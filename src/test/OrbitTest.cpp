@@ -0,0 +1,304 @@
+///
+/// \file contains the tests of the orbit tree
+///
+
+#include "Check.h"
+#include "Orbit.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+struct Body : public MapObject {
+};
+
+// an orbit that is neither circular nor stationary, so the trees evaluate it through calculate_offset()
+class WobbleOrbit : public Orbit {
+protected:
+
+    Position calculate_offset(Duration current){
+        double time = chrono::duration<double>(current).count();
+        return Position{static_cast<Coordinate>(3.0 + fmod(time, 5.0)), static_cast<Coordinate>(1.0 - fmod(time, 3.0))};
+    }
+};
+
+// a random tree of gravity wells and satellites on static, circular and custom orbits, some of them anchored elsewhere
+class Tree {
+public:
+
+    explicit Tree(unsigned seed) : bodies_(), objects_(), orbits_(), wells_(), all_(), anchor_(AbsolutePosition{5.0, -3.0}), root_(), still_() {
+        mt19937 random{seed};
+        root_ = add(true, random)->gravity_well();
+        for(size_t i = 0; i < 400; ++i){
+            GravityWell *parent = wells_[uniform_int_distribution<size_t>{0, wells_.size() - 1}(random)];
+            OrbitalObject *satellite = add(random() % 6 == 0, random);
+            if(random() % 10 == 0){
+                satellite->object()->anchor(&anchor_);
+            }
+            unsigned kind = random() % 8;
+            if(kind < 2){
+                orbits_.emplace_back(new StaticOrbit{Position{static_cast<Coordinate>(random() % 100), static_cast<Coordinate>(random() % 100)}});
+            }else if(kind == 2){
+                orbits_.emplace_back(new WobbleOrbit{});
+            }else{
+                orbits_.emplace_back(new CircularOrbit{static_cast<Coordinate>(1 + random() % 50), chrono::seconds(1 + random() % 20), static_cast<Coordinate>(random() % 7)});
+            }
+            attach(parent, satellite, orbits_.back().get());
+        }
+        // a satellite that only moves when it is changed, since the root only moves when its map object is moved
+        still_ = add(false, random);
+        orbits_.emplace_back(new StaticOrbit{Position{Coordinate{2}, Coordinate{3}}});
+        attach(root_, still_, orbits_.back().get());
+    }
+
+    GravityWell *root() const {
+        return root_;
+    }
+
+    const vector<GravityWell *> &wells() const {
+        return wells_;
+    }
+
+    const vector<OrbitalObject *> &all() const {
+        return all_;
+    }
+
+    OrbitalObject *still() const {
+        return still_;
+    }
+
+    Orbit *orbit(size_t index) const {
+        return orbits_[index].get();
+    }
+
+private:
+
+    OrbitalObject *add(bool well, mt19937 &random){
+        bodies_.emplace_back(new Body{});
+        OrbitalObject *object;
+        if(well){
+            GravityWell *gravity_well = new GravityWell{bodies_.back().get()};
+            gravity_well->radius = static_cast<Coordinate>(random() % 5);
+            wells_.push_back(gravity_well);
+            object = gravity_well;
+        }else{
+            object = new OrbitalObject{bodies_.back().get()};
+        }
+        objects_.emplace_back(object);
+        all_.push_back(object);
+        return object;
+    }
+
+    vector<unique_ptr<Body>> bodies_;
+    vector<unique_ptr<OrbitalObject>> objects_;
+    vector<unique_ptr<Orbit>> orbits_;
+    vector<GravityWell *> wells_;
+    vector<OrbitalObject *> all_;
+    AbsolutePosition anchor_;
+    GravityWell *root_;
+    OrbitalObject *still_;
+};
+
+static bool same_transform(const Transform2<Coordinate> &first, const Transform2<Coordinate> &second){
+    for(size_t i = 0; i < 6; ++i){
+        if(first[i] != second[i]){
+            return false;
+        }
+    }
+    return true;
+}
+
+// the same edits on two equal trees, each tick checks that the flattened tree gives exactly the results of the pointer tree
+static void flat_tree_matches_pointer_tree(){
+    Tree pointer{11}, flat{11};
+    FlatOrbitTree tree{flat.root()};
+    // detaching clears the child of the orbit
+    OrbitalObject *detached[] = {pointer.orbit(33)->child(), flat.orbit(33)->child()};
+    for(size_t step = 0; step < 120; ++step){
+        for(Tree *edited : {&pointer, &flat}){
+            if(step % 23 == 5){
+                GravityWell *well = edited->wells()[1 + (step * 13) % (edited->wells().size() - 1)];
+                well->paused(!well->paused());
+            }
+            if(step % 17 == 3){
+                Transform2<Coordinate> transform;
+                transform.rotate(static_cast<Coordinate>(0.3));
+                transform[2] = Coordinate{3};
+                transform[5] = Coordinate{4};
+                edited->all()[1 + (step * 7) % (edited->all().size() - 1)]->local_transform(transform);
+            }
+            if(step == 40){
+                Transform2<Coordinate> transform;
+                transform.rotate(static_cast<Coordinate>(0.5));
+                edited->wells()[3]->local_transform(transform);
+            }
+            if(step == 60){
+                edited->root()->object()->position(Position{Coordinate{7}, Coordinate{9}});
+            }
+            if(step == 80){
+                Orbit *orbit = edited->orbit(20);
+                GravityWell *parent = orbit->parent();
+                OrbitalObject *satellite = orbit->child();
+                orbit->detach();
+                attach(edited->wells()[parent == edited->wells()[1] ? 2 : 1], satellite, orbit);
+            }
+            if(step == 90){
+                edited->orbit(33)->detach();
+            }
+            if(step >= 100 && step % 4 == 0){
+                // only the changed satellite is repositioned, the tree skips the other stationary satellites of the root
+                Transform2<Coordinate> transform;
+                transform[2] = static_cast<Coordinate>(step);
+                edited->still()->local_transform(transform);
+            }
+        }
+        Duration current = chrono::milliseconds(37 * step);
+        pointer.root()->update(current);
+        tree.update(current);
+
+        bool positions = true, transforms = true, bounds = true;
+        for(size_t i = 0; i < pointer.all().size(); ++i){
+            positions = positions && pointer.all()[i]->object()->position() == flat.all()[i]->object()->position();
+            transforms = transforms && same_transform(pointer.all()[i]->world_transform(), flat.all()[i]->world_transform())
+                    && same_transform(pointer.all()[i]->local_transform(), flat.all()[i]->local_transform());
+        }
+        for(size_t i = 0; i < pointer.wells().size(); ++i){
+            bounds = bounds && pointer.wells()[i]->bounds() == flat.wells()[i]->bounds();
+        }
+        check(positions, "a flat tree positions every object exactly like the pointer tree");
+        check(transforms, "a flat tree gives every object exactly the transformations of the pointer tree");
+        check(bounds, "a flat tree fits exactly the bounds of the pointer tree");
+    }
+    // a detached satellite is no longer composed with its former parent
+    for(OrbitalObject *satellite : detached){
+        check(same_transform(satellite->world_transform(), satellite->local_transform()), "the world transformation of a detached satellite is its local transformation");
+    }
+}
+
+static bool same_objects(vector<OrbitalObject *> first, vector<OrbitalObject *> second){
+    sort(first.begin(), first.end());
+    sort(second.begin(), second.end());
+    return first == second;
+}
+
+static double object_radius(const OrbitalObject *object){
+    const GravityWell *well = object->gravity_well();
+    return well ? static_cast<double>(well->radius) : 0.0;
+}
+
+// the queries skip the gravity wells whose bounds are out of reach, a scan of every object has to find the same
+static void culled_queries(){
+    Tree tree{5};
+    mt19937 random{9};
+    uniform_real_distribution<double> coordinate{-300.0, 300.0}, size{0.0, 80.0};
+    vector<OrbitalObject *> expected, found;
+    for(size_t step = 0; step < 60; ++step){
+        // paused and changed subtrees keep or refit their bounds, the queries should see the positions as of this update
+        if(step % 7 == 2){
+            GravityWell *well = tree.wells()[1 + (step * 5) % (tree.wells().size() - 1)];
+            well->paused(!well->paused());
+        }
+        if(step % 11 == 4){
+            Transform2<Coordinate> transform;
+            transform[2] = static_cast<Coordinate>(step);
+            tree.all()[1 + (step * 31) % (tree.all().size() - 1)]->local_transform(transform);
+        }
+        tree.root()->update(chrono::milliseconds(250 * step));
+
+        bool inside = true, within = true, pick = true;
+        for(size_t query = 0; query < 20; ++query){
+            AbsolutePosition corner{coordinate(random), coordinate(random)};
+            Bounds area{corner, corner + AbsolutePosition{size(random), size(random)}};
+            expected.clear();
+            for(OrbitalObject *object : tree.all()){
+                double radius = object_radius(object);
+                if(area.distance_squared(object->object()->absolute_position()) <= radius * radius){
+                    expected.push_back(object);
+                }
+            }
+            tree.root()->inside(area, found);
+            inside = inside && same_objects(expected, found);
+
+            AbsolutePosition center{coordinate(random), coordinate(random)};
+            double radius = size(random);
+            expected.clear();
+            for(OrbitalObject *object : tree.all()){
+                if((object->object()->absolute_position() - center).norm() <= radius + object_radius(object)){
+                    expected.push_back(object);
+                }
+            }
+            tree.root()->within(center, radius, found);
+            within = within && same_objects(expected, found);
+
+            // objects at the same distance may be picked in any order, so the distances are compared
+            double tolerance = size(random) / 4, nearest = tolerance;
+            bool any = false;
+            for(OrbitalObject *object : tree.all()){
+                double distance = max((object->object()->absolute_position() - center).norm() - object_radius(object), 0.0);
+                if(distance <= nearest){
+                    nearest = distance;
+                    any = true;
+                }
+            }
+            OrbitalObject *picked = tree.root()->pick(center, tolerance);
+            if(any){
+                pick = pick && picked && max((picked->object()->absolute_position() - center).norm() - object_radius(picked), 0.0) == nearest;
+            }else{
+                pick = pick && !picked;
+            }
+        }
+        check(inside, "inside() finds the objects a scan of every object finds");
+        check(within, "within() finds the objects a scan of every object finds");
+        check(pick, "pick() finds the object a scan of every object finds");
+    }
+}
+
+// a star system far from the origin of the map, with its satellites anchored at the star or at a neighbouring system:
+// the orbits are as precise as the coordinates relative to the anchors, whatever the type of the coordinates is
+static void anchored_precision(){
+    AbsolutePosition star_anchor{3.7e9, -1.2e9}, neighbour_anchor{3.7e9 + 2e5, -1.2e9 + 5e4};
+    Body star_body;
+    star_body.anchor(&star_anchor);
+    GravityWell star{&star_body};
+    vector<unique_ptr<Body>> bodies;
+    vector<unique_ptr<OrbitalObject>> satellites;
+    vector<unique_ptr<CircularOrbit>> orbits;
+    vector<double> radii, phases, periods;
+    for(size_t i = 0; i < 64; ++i){
+        bodies.emplace_back(new Body{});
+        bodies.back()->anchor(i % 4 == 3 ? &neighbour_anchor : &star_anchor);
+        satellites.emplace_back(new OrbitalObject{bodies.back().get()});
+        radii.push_back(static_cast<double>(1000 + 150 * i));
+        phases.push_back(static_cast<double>(i % 7));
+        periods.push_back(static_cast<double>(30 + 17 * i));
+        orbits.emplace_back(new CircularOrbit{Coordinate(1000 + 150 * i), chrono::seconds(30 + 17 * i), Coordinate(i % 7)});
+        attach(&star, satellites.back().get(), orbits.back().get());
+    }
+    // the largest distance of a satellite from the star or of the anchors from each other
+    double extent = 2.1e5, worst = 0.0;
+    for(size_t step = 0; step < 50; ++step){
+        // up to a month of game time, the angles grow to thousands of turns
+        long long seconds = static_cast<long long>(step * step) * 1000 + 13;
+        star.update(chrono::seconds(seconds));
+        for(size_t i = 0; i < satellites.size(); ++i){
+            double angle = phases[i] + pi() * static_cast<double>(seconds) / periods[i];
+            AbsolutePosition reference = star_anchor + AbsolutePosition{radii[i] * cos(angle), radii[i] * sin(angle)};
+            worst = max(worst, (bodies[i]->absolute_position() - reference).norm());
+        }
+    }
+    // about 8 float epsilons of the extent, without anchors the rounding would be relative to the 3.9e9 from the origin instead
+    check(worst < 1e-6 * extent, "anchored satellites keep the precision of the coordinates far from the origin of the map");
+}
+
+int main(){
+    flat_tree_matches_pointer_tree();
+    anchored_precision();
+    culled_queries();
+    return test_result();
+}
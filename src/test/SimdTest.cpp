@@ -0,0 +1,305 @@
+///
+/// \file contains the tests of the batch geometry functions, every supported level is compared bit for bit with the scalar implementations
+/// and the batch functions of Metrics.h with the Vector2 and Transform2 functions. The sincos kernels are also checked against long double.
+///
+
+#include "Check.h"
+#include "Simd.h"
+#include "Metrics.h"
+#include "Fixed.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+static void check(bool condition, SimdLevel level, const char *function, size_t count){
+    if(!condition){
+        ++failure_count();
+        printf("failed: %s at %s with %zu elements differs from the scalar implementation\n", function, simd_level_name(level), count);
+    }
+}
+
+template<typename T> static bool identical(const vector<T> &first, const vector<T> &second){
+    return first.size() == second.size() && (first.empty() || memcmp(first.data(), second.data(), first.size() * sizeof(T)) == 0);
+}
+
+static vector<double> random_doubles(mt19937_64 &generator, size_t count, double limit){
+    uniform_real_distribution<double> distribution{-limit, limit};
+    vector<double> values(count);
+    for(double &value : values){
+        value = distribution(generator);
+    }
+    return values;
+}
+
+template<typename T> static bool same(const T &first, const T &second){
+    return memcmp(&first, &second, sizeof(T)) == 0;
+}
+
+template<typename Scalar> static bool same_buffers(const PositionBuffer<Scalar> &first, const PositionBuffer<Scalar> &second){
+    return first.size() == second.size() && (first.size() == 0
+            || (memcmp(first.x(), second.x(), first.size() * sizeof(Scalar)) == 0 && memcmp(first.y(), second.y(), first.size() * sizeof(Scalar)) == 0));
+}
+
+static vector<int64_t> random_fixed(mt19937_64 &generator, size_t count){
+    // Q32.32 values of magnitude below 2^13, so differences, products and their sums do not overflow
+    uniform_int_distribution<int64_t> distribution{-(int64_t{1} << 45), int64_t{1} << 45};
+    vector<int64_t> values(count);
+    for(int64_t &value : values){
+        value = distribution(generator);
+    }
+    return values;
+}
+
+static void compare_geometry(SimdLevel level, mt19937_64 &generator, size_t count){
+    const GeometryKernels &scalar = GeometryKernels::at(SimdLevel::SCALAR), &active = GeometryKernels::active();
+    vector<double> coefficients = random_doubles(generator, 6, 1e3);
+    vector<double> x = random_doubles(generator, count, 1e6), y = random_doubles(generator, count, 1e6);
+    vector<double> second_x = random_doubles(generator, count, 1e6), second_y = random_doubles(generator, count, 1e6);
+    vector<double> expected_x(count), expected_y(count), result_x(count), result_y(count);
+
+    scalar.transform(coefficients.data(), x.data(), y.data(), expected_x.data(), expected_y.data(), count);
+    active.transform(coefficients.data(), x.data(), y.data(), result_x.data(), result_y.data(), count);
+    check(identical(expected_x, result_x) && identical(expected_y, result_y), level, "transform", count);
+
+    scalar.distance_squared(x.data(), y.data(), 12.5, -7.25, expected_x.data(), count);
+    active.distance_squared(x.data(), y.data(), 12.5, -7.25, result_x.data(), count);
+    check(identical(expected_x, result_x), level, "distance_squared", count);
+
+    scalar.norm(x.data(), y.data(), expected_x.data(), count);
+    active.norm(x.data(), y.data(), result_x.data(), count);
+    check(identical(expected_x, result_x), level, "norm", count);
+
+    bool expected_valid = scalar.normalize(x.data(), y.data(), expected_x.data(), expected_y.data(), count);
+    bool valid = active.normalize(x.data(), y.data(), result_x.data(), result_y.data(), count);
+    check(expected_valid == valid && identical(expected_x, result_x) && identical(expected_y, result_y), level, "normalize", count);
+
+    scalar.dot(x.data(), y.data(), second_x.data(), second_y.data(), expected_x.data(), count);
+    active.dot(x.data(), y.data(), second_x.data(), second_y.data(), result_x.data(), count);
+    check(identical(expected_x, result_x), level, "dot", count);
+
+    scalar.dot_vector(x.data(), y.data(), 0.75, -3.5, expected_x.data(), count);
+    active.dot_vector(x.data(), y.data(), 0.75, -3.5, result_x.data(), count);
+    check(identical(expected_x, result_x), level, "dot_vector", count);
+
+    // includes angles beyond the reduction limit, which fall back to std::sin and std::cos
+    vector<double> angles = random_doubles(generator, count, 2e6);
+    scalar.sincos(angles.data(), expected_x.data(), expected_y.data(), count);
+    active.sincos(angles.data(), result_x.data(), result_y.data(), count);
+    check(identical(expected_x, result_x) && identical(expected_y, result_y), level, "sincos", count);
+    // the batch function may write the sines over the angles
+    vector<double> sines = angles;
+    Game::sincos(sines, sines, result_y);
+    check(identical(expected_x, sines) && identical(expected_y, result_y), level, "sincos in place", count);
+}
+
+static void compare_fixed(SimdLevel level, mt19937_64 &generator, size_t count){
+    const FixedKernels &scalar = FixedKernels::at(SimdLevel::SCALAR), &active = FixedKernels::active();
+    vector<int64_t> coefficients = random_fixed(generator, 6);
+    vector<int64_t> x = random_fixed(generator, count), y = random_fixed(generator, count);
+    vector<int64_t> second_x = random_fixed(generator, count), second_y = random_fixed(generator, count);
+    vector<int64_t> expected_x(count), expected_y(count), result_x(count), result_y(count);
+
+    scalar.transform(coefficients.data(), x.data(), y.data(), expected_x.data(), expected_y.data(), count);
+    active.transform(coefficients.data(), x.data(), y.data(), result_x.data(), result_y.data(), count);
+    check(identical(expected_x, result_x) && identical(expected_y, result_y), level, "fixed transform", count);
+
+    scalar.distance_squared(x.data(), y.data(), coefficients[0], coefficients[1], expected_x.data(), count);
+    active.distance_squared(x.data(), y.data(), coefficients[0], coefficients[1], result_x.data(), count);
+    check(identical(expected_x, result_x), level, "fixed distance_squared", count);
+
+    scalar.dot(x.data(), y.data(), second_x.data(), second_y.data(), expected_x.data(), count);
+    active.dot(x.data(), y.data(), second_x.data(), second_y.data(), result_x.data(), count);
+    check(identical(expected_x, result_x), level, "fixed dot", count);
+
+    scalar.dot_vector(x.data(), y.data(), coefficients[2], coefficients[3], expected_x.data(), count);
+    active.dot_vector(x.data(), y.data(), coefficients[2], coefficients[3], result_x.data(), count);
+    check(identical(expected_x, result_x), level, "fixed dot_vector", count);
+}
+
+static void fill(mt19937_64 &generator, PositionBuffer<double> &vectors){
+    vector<double> x = random_doubles(generator, vectors.size(), 1e6), y = random_doubles(generator, vectors.size(), 1e6);
+    copy(x.begin(), x.end(), vectors.x());
+    copy(y.begin(), y.end(), vectors.y());
+}
+
+static void fill(mt19937_64 &generator, PositionBuffer<Fixed> &vectors){
+    vector<int64_t> x = random_fixed(generator, vectors.size()), y = random_fixed(generator, vectors.size());
+    for(size_t i = 0; i < vectors.size(); ++i){
+        vectors.set(i, Vector2<Fixed>{Fixed::from_raw(x[i]), Fixed::from_raw(y[i])});
+    }
+}
+
+// the batch functions of Metrics.h against the Vector2 and Transform2 functions they replace, with a zero vector at the given index, if any
+template<typename Scalar> static void compare_vectors(SimdLevel level, mt19937_64 &generator, size_t count, size_t zero_index){
+    PositionBuffer<Scalar> vectors{count}, second{count}, result;
+    fill(generator, vectors);
+    fill(generator, second);
+    if(zero_index < count){
+        vectors.set(zero_index, Vector2<Scalar>{});
+    }
+    PositionBuffer<Scalar> coefficients{3};
+    fill(generator, coefficients);
+    Transform2<Scalar> transformation{coefficients.x()[0], coefficients.y()[0], coefficients.x()[1], coefficients.y()[1], coefficients.x()[2], coefficients.y()[2]};
+    Vector2<Scalar> point = second.size() > 0 ? second.get(0) : Vector2<Scalar>{};
+    vector<Scalar> values;
+
+    bool identical_transform = true;
+    transform(transformation, vectors, result);
+    for(size_t i = 0; i < count; ++i){
+        Vector2<Scalar> expected = transformation(vectors.get(i));
+        identical_transform &= same(expected.x, result.x()[i]) && same(expected.y, result.y()[i]);
+    }
+    check(identical_transform, level, "Transform2", count);
+
+    bool identical_norm = true;
+    norm(vectors, values);
+    for(size_t i = 0; i < count; ++i){
+        identical_norm &= same(vectors.get(i).norm(), values[i]);
+    }
+    norm_squared(vectors, values);
+    for(size_t i = 0; i < count; ++i){
+        identical_norm &= same(vectors.get(i).normSquared(), values[i]);
+    }
+    check(identical_norm, level, "Vector2::norm", count);
+
+    bool identical_distance = true;
+    distance_squared(vectors, point, values);
+    for(size_t i = 0; i < count; ++i){
+        identical_distance &= same((vectors.get(i) - point).normSquared(), values[i]);
+    }
+    check(identical_distance, level, "Vector2 distance", count);
+
+    bool identical_dot = true;
+    dot(vectors, second, values);
+    for(size_t i = 0; i < count; ++i){
+        identical_dot &= same(Game::dot(vectors.get(i), second.get(i)), values[i]);
+    }
+    dot(vectors, point, values);
+    for(size_t i = 0; i < count; ++i){
+        identical_dot &= same(Game::dot(vectors.get(i), point), values[i]);
+    }
+    check(identical_dot, level, "Game::dot", count);
+
+    // the batch throws if any vector does not normalize, otherwise every vector is normalized like Vector2::normalize()
+    bool expected_error = false, error = false;
+    PositionBuffer<Scalar> expected{count};
+    for(size_t i = 0; i < count; ++i){
+        try{
+            Vector2<Scalar> vector = vectors.get(i);
+            expected.set(i, vector.normalize());
+        }catch(const ZeroVectorError &){
+            expected_error = true;
+        }
+    }
+    try{
+        normalize(vectors, result);
+    }catch(const ZeroVectorError &){
+        error = true;
+    }
+    bool identical_normalize = expected_error == error && expected_error == (zero_index < count);
+    for(size_t i = 0; i < count && !error; ++i){
+        identical_normalize &= same(expected.x()[i], result.x()[i]) && same(expected.y()[i], result.y()[i]);
+    }
+    check(identical_normalize, level, "Vector2::normalize", count);
+
+    // the same buffer as input and output gives the same results as separate buffers
+    PositionBuffer<Scalar> in_place = vectors;
+    transform(transformation, vectors, result);
+    transform(transformation, in_place);
+    bool identical_in_place = same_buffers(result, in_place);
+    in_place = vectors;
+    transform(transformation, in_place, in_place);
+    identical_in_place &= same_buffers(result, in_place);
+    if(zero_index >= count){
+        in_place = vectors;
+        normalize(in_place, in_place);
+        identical_in_place &= same_buffers(expected, in_place);
+    }
+    check(identical_in_place, level, "in place", count);
+}
+
+// the kernels report a zero vector in any lane, including the remainder after the last full vector
+static void compare_zero_vectors(SimdLevel level, mt19937_64 &generator, size_t count){
+    const GeometryKernels &scalar = GeometryKernels::at(SimdLevel::SCALAR), &active = GeometryKernels::active();
+    for(size_t zero_index = 0; zero_index < count; ++zero_index){
+        vector<double> x = random_doubles(generator, count, 1e6), y = random_doubles(generator, count, 1e6);
+        vector<double> result_x(count), result_y(count);
+        x[zero_index] = 0;
+        y[zero_index] = 0;
+        bool expected_valid = scalar.normalize(x.data(), y.data(), result_x.data(), result_y.data(), count);
+        bool valid = active.normalize(x.data(), y.data(), result_x.data(), result_y.data(), count);
+        check(!expected_valid && !valid, level, "normalize of a zero vector", count);
+        compare_vectors<double>(level, generator, count, zero_index);
+        compare_vectors<Fixed>(level, generator, count, zero_index);
+    }
+}
+
+// the largest absolute difference of the sines and cosines of a level from long double sinl and cosl
+static long double sincos_error(SimdLevel level, const vector<double> &angles){
+    vector<double> sines(angles.size()), cosines(angles.size());
+    GeometryKernels::at(level).sincos(angles.data(), sines.data(), cosines.data(), angles.size());
+    long double error = 0;
+    for(size_t i = 0; i < angles.size(); ++i){
+        long double angle = angles[i];
+        error = max(error, max(fabsl(sines[i] - sinl(angle)), fabsl(cosines[i] - cosl(angle))));
+    }
+    return error;
+}
+
+// Metrics.h promises an absolute error below 2e-16, in the reduced range and in the fallback beyond it
+static void sincos_error_bound(SimdLevel level, mt19937_64 &generator){
+    vector<double> angles = random_doubles(generator, 100000, 4.0);
+    vector<double> large = random_doubles(generator, 100000, 1.6e6), fallback = random_doubles(generator, 1000, 1e9);
+    angles.insert(angles.end(), large.begin(), large.end());
+    angles.insert(angles.end(), fallback.begin(), fallback.end());
+    // the quadrant boundaries, where the reduction has to be most accurate
+    for(int k = -64; k <= 64; ++k){
+        double boundary = k * 1.57079632679489661923;
+        angles.push_back(boundary);
+        angles.push_back(nextafter(boundary, -1e300));
+        angles.push_back(nextafter(boundary, 1e300));
+    }
+    long double error = sincos_error(level, angles);
+    if(!(error < 2e-16L)){
+        ++failure_count();
+        printf("failed: sincos at %s has an absolute error of %Lg, the bound is 2e-16\n", simd_level_name(level), error);
+    }
+}
+
+int main(){
+    SimdLevel supported = supported_simd_level();
+    mt19937_64 error_generator{7};
+    sincos_error_bound(SimdLevel::SCALAR, error_generator);
+    const SimdLevel levels[] = {SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512};
+    for(SimdLevel level : levels){
+        if(level > supported){
+            printf("skipped: %s is not supported\n", simd_level_name(level));
+            continue;
+        }
+        simd_level(level);
+        sincos_error_bound(level, error_generator);
+        mt19937_64 generator{42};
+        // every remainder of the vector widths, and a longer run
+        for(size_t count = 0; count <= 33; ++count){
+            compare_geometry(level, generator, count);
+            compare_fixed(level, generator, count);
+            compare_vectors<double>(level, generator, count, count);
+            compare_vectors<Fixed>(level, generator, count, count);
+            compare_zero_vectors(level, generator, count);
+        }
+        compare_geometry(level, generator, 4099);
+        compare_fixed(level, generator, 4099);
+        compare_vectors<double>(level, generator, 4099, 4099);
+        compare_vectors<double>(level, generator, 4099, 4098);
+        compare_vectors<Fixed>(level, generator, 4099, 2050);
+        printf("compared: %s\n", simd_level_name(level));
+    }
+    simd_level(supported);
+    return test_result();
+}
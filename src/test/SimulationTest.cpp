@@ -0,0 +1,135 @@
+///
+/// \file contains the tests of Simulation
+///
+
+#include "Check.h"
+#include "Simulation.h"
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+// the accumulator only performs whole steps and keeps the remainder for the next frame
+static void fixed_steps(){
+    FixedThreadPool pool{1};
+    pool.start();
+    Duration step = chrono::milliseconds(10);
+    Simulation simulation{pool, step, 5};
+    check(simulation.advance(chrono::milliseconds(4)) == 0, "a frame shorter than a step performs no ticks");
+    check(simulation.interpolation() == 0.4, "the interpolation is the accumulated fraction of a step");
+    check(simulation.advance(chrono::milliseconds(25)) == 2, "the accumulated time of two frames is simulated in whole steps");
+    check(simulation.time() == chrono::milliseconds(20), "every tick advances the simulation time by one step");
+    check(simulation.interpolation() == 0.9, "the remainder of a step is kept for the next frame");
+    check(simulation.advance(chrono::milliseconds(1)) == 1, "the remainder adds up to a step");
+    check(simulation.interpolation() == 0.0, "a whole step leaves nothing to interpolate");
+    check(simulation.statistics().tick_count == 3, "the statistics count every tick");
+    check(simulation.statistics().dropped_tick_count == 0, "no ticks are dropped while the simulation keeps up");
+    pool.stop();
+}
+
+// a frame that is too far behind performs the maximum amount of steps and drops the whole steps of the backlog
+static void dropped_steps(){
+    FixedThreadPool pool{1};
+    pool.start();
+    Duration step = chrono::milliseconds(10);
+    Simulation simulation{pool, step, 5};
+    check(simulation.advance(chrono::milliseconds(123)) == 5, "a slow frame performs at most the maximum amount of steps");
+    check(simulation.time() == chrono::milliseconds(50), "a slow frame only advances the simulation by the steps it performed");
+    check(simulation.statistics().dropped_tick_count == 7, "the whole steps beyond the maximum are dropped");
+    check(simulation.interpolation() == 0.3, "the remainder of a step survives a dropped backlog");
+    check(simulation.advance(chrono::milliseconds(7)) == 1, "the frame after a dropped backlog only simulates its own time");
+    simulation.reset_statistics();
+    check(simulation.statistics().tick_count == 0 && simulation.statistics().dropped_tick_count == 0, "reset_statistics() clears the counters");
+    pool.stop();
+}
+
+struct Body : public MapObject {
+};
+
+// an orbit that fails while failing is set
+class FailingOrbit : public Orbit {
+public:
+    FailingOrbit() : failing(false){
+    }
+
+    bool failing;
+
+protected:
+    Position calculate_offset(Duration){
+        if(failing){
+            throw runtime_error{"orbit failed"};
+        }
+        return Position{Coordinate{1}, Coordinate{0}};
+    }
+};
+
+// when one hierarchy fails to update, the moves of the others still reach their grid and are not replayed by the next tick
+static void failed_tick(){
+    FixedThreadPool pool{2};
+    pool.start();
+    Duration step = chrono::milliseconds(10);
+    SpatialGrid grid{Coordinate{8}};
+    Body moving_root_body, moving_body, failing_root_body, failing_body;
+    failing_root_body.position(Position{Coordinate{500}, Coordinate{0}});
+    GravityWell moving_root{&moving_root_body}, failing_root{&failing_root_body};
+    OrbitalObject moving{&moving_body}, failing{&failing_body};
+    // a quarter turn every tick, so every tick moves the body far from its previous cell
+    CircularOrbit moving_orbit{Coordinate{50}, 4 * step, Coordinate{0}};
+    FailingOrbit failing_orbit;
+    attach(&moving_root, &moving, &moving_orbit);
+    attach(&failing_root, &failing, &failing_orbit);
+    grid.insert(&moving_body);
+    Simulation simulation{pool, step};
+    simulation.add(&moving_root);
+    simulation.add(&failing_root);
+    simulation.tick();
+    failing_orbit.failing = true;
+    bool thrown = false;
+    try{
+        simulation.tick();
+    }catch(runtime_error &){
+        thrown = true;
+    }
+    check(thrown, "the error of a failed hierarchy is rethrown by tick()");
+    vector<MapObject *> found;
+    grid.within(moving_body.position(), Coordinate{1}, found);
+    check(find(found.begin(), found.end(), &moving_body) != found.end(), "the grid follows the objects that moved during a failed tick");
+    grid.remove(&moving_body);
+    failing_orbit.failing = false;
+    simulation.tick();
+    check(grid.size() == 0, "the next tick does not replay the moves of a failed tick");
+    simulation.remove(&moving_root);
+    simulation.remove(&failing_root);
+    pool.stop();
+}
+
+static void invalid_arguments(){
+    FixedThreadPool pool{1};
+    bool thrown = false;
+    try{
+        Simulation simulation{pool, Duration::zero()};
+    }catch(invalid_argument &){
+        thrown = true;
+    }
+    check(thrown, "a simulation without a positive step is rejected");
+    thrown = false;
+    try{
+        Simulation simulation{pool, chrono::milliseconds(10), 0};
+    }catch(invalid_argument &){
+        thrown = true;
+    }
+    check(thrown, "a simulation without steps per frame is rejected");
+}
+
+int main(){
+    fixed_steps();
+    dropped_steps();
+    failed_tick();
+    invalid_arguments();
+    return test_result();
+}
@@ -0,0 +1,183 @@
+///
+/// \file contains the tests of SpatialGrid
+///
+
+#include "Check.h"
+#include "Simulation.h"
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+struct Body : public MapObject {
+};
+
+static bool same_objects(vector<MapObject *> first, vector<MapObject *> second){
+    sort(first.begin(), first.end());
+    sort(second.begin(), second.end());
+    return first == second;
+}
+
+static void brute_within(const vector<MapObject *> &objects, const AbsolutePosition *anchor, const Position &center, Coordinate radius, vector<MapObject *> &result){
+    result.clear();
+    for(MapObject *object : objects){
+        Position position = relative_position(*object, anchor);
+        double dx = static_cast<double>(position.x) - static_cast<double>(center.x), dy = static_cast<double>(position.y) - static_cast<double>(center.y);
+        if(dx * dx + dy * dy <= static_cast<double>(radius) * static_cast<double>(radius)){
+            result.push_back(object);
+        }
+    }
+}
+
+static double squared_distance(const MapObject &object, const AbsolutePosition *anchor, const Position &point){
+    Position position = relative_position(object, anchor);
+    double dx = static_cast<double>(position.x) - static_cast<double>(point.x), dy = static_cast<double>(position.y) - static_cast<double>(point.y);
+    return dx * dx + dy * dy;
+}
+
+static void brute_inside(const vector<MapObject *> &objects, const AbsolutePosition *anchor, const Position &minimum, const Position &maximum, vector<MapObject *> &result){
+    result.clear();
+    for(MapObject *object : objects){
+        Position position = relative_position(*object, anchor);
+        if(position.x >= minimum.x && position.x <= maximum.x && position.y >= minimum.y && position.y <= maximum.y){
+            result.push_back(object);
+        }
+    }
+}
+
+// the distances of the nearest objects, objects at the same distance may be found in any order
+static vector<double> distances(const vector<MapObject *> &objects, const AbsolutePosition *anchor, const Position &point){
+    vector<double> result;
+    for(MapObject *object : objects){
+        result.push_back(squared_distance(*object, anchor, point));
+    }
+    return result;
+}
+
+static vector<double> brute_nearest(const vector<MapObject *> &objects, const AbsolutePosition *anchor, const Position &point, size_t count){
+    vector<double> result = distances(objects, anchor, point);
+    sort(result.begin(), result.end());
+    result.resize(min(count, result.size()));
+    return result;
+}
+
+// random inserts, removals and moves inside and across cells, every query checked against a scan of the indexed objects
+// the small area empties and refills cells all the time, so removals move the last entry of a cell and emptied cells are reused
+static void random_operations(const AbsolutePosition *anchor){
+    mt19937 random{7};
+    uniform_real_distribution<double> coordinate{-40.0, 40.0};
+    uniform_real_distribution<double> step{-3.0, 3.0};
+    uniform_int_distribution<int> operation{0, 9};
+    auto random_position = [&](){
+        return Position{static_cast<Coordinate>(coordinate(random)), static_cast<Coordinate>(coordinate(random))};
+    };
+    AbsolutePosition other_anchor{Position{Coordinate{5}, Coordinate{-7}}};
+    vector<unique_ptr<Body>> bodies;
+    vector<MapObject *> indexed;
+    SpatialGrid grid{Coordinate{4}, anchor};
+    vector<MapObject *> expected, found;
+    for(size_t round = 0; round < 3000; ++round){
+        int kind = operation(random);
+        if(kind < 3 || indexed.empty()){
+            bodies.emplace_back(new Body{});
+            bodies.back()->position(random_position());
+            grid.insert(bodies.back().get());
+            indexed.push_back(bodies.back().get());
+        }else{
+            size_t index = uniform_int_distribution<size_t>{0, indexed.size() - 1}(random);
+            MapObject *object = indexed[index];
+            if(kind == 3){
+                grid.remove(object);
+                indexed.erase(indexed.begin() + index);
+            }else if(kind == 4){
+                // the destructor removes the object
+                for(unique_ptr<Body> &body : bodies){
+                    if(body.get() == object){
+                        body.reset();
+                    }
+                }
+                indexed.erase(indexed.begin() + index);
+            }else if(kind == 5){
+                object->anchor(object->anchor() ? nullptr : &other_anchor);
+            }else{
+                // mostly small steps, which stay in the cell or cross into a neighbouring one
+                object->position(object->position() + Position{static_cast<Coordinate>(step(random)), static_cast<Coordinate>(step(random))});
+            }
+        }
+        check(grid.size() == indexed.size(), "a grid counts its objects");
+        if(round % 10 != 0){
+            continue;
+        }
+        Position point = random_position();
+        Coordinate radius = static_cast<Coordinate>(uniform_real_distribution<double>{0.0, 20.0}(random));
+        brute_within(indexed, anchor, point, radius, expected);
+        grid.within(point, radius, found);
+        check(same_objects(expected, found), "a radius query finds the objects in the circle");
+        Position other = random_position();
+        Position minimum{min(point.x, other.x), min(point.y, other.y)}, maximum{max(point.x, other.x), max(point.y, other.y)};
+        brute_inside(indexed, anchor, minimum, maximum, expected);
+        grid.inside(minimum, maximum, found);
+        check(same_objects(expected, found), "a rectangle query finds the objects in the rectangle");
+        // far away points make the search fall back to one pass over the cells
+        Position far = round % 50 == 0 ? Position{Coordinate{1000}, Coordinate{-1000}} : point;
+        size_t count = uniform_int_distribution<size_t>{0, 20}(random);
+        grid.nearest(far, count, found);
+        vector<double> found_distances = distances(found, anchor, far);
+        check(found_distances == brute_nearest(indexed, anchor, far, count), "a nearest neighbour query finds the nearest objects in order");
+    }
+}
+
+// the tasks of two roots move objects of one grid at the same time, the grid is updated after the tick
+static void simulation_with_shared_grid(){
+    FixedThreadPool pool{4};
+    pool.start();
+    vector<unique_ptr<Body>> bodies;
+    vector<unique_ptr<OrbitalObject>> objects;
+    vector<unique_ptr<Orbit>> orbits;
+    vector<MapObject *> indexed;
+    SpatialGrid grid{Coordinate{8}};
+    vector<GravityWell *> roots;
+    for(size_t r = 0; r < 2; ++r){
+        bodies.emplace_back(new Body{});
+        bodies.back()->position(Position{Coordinate(r * 60), Coordinate{0}});
+        GravityWell *root = new GravityWell{bodies.back().get()};
+        objects.emplace_back(root);
+        roots.push_back(root);
+        for(size_t i = 0; i < 500; ++i){
+            bodies.emplace_back(new Body{});
+            objects.emplace_back(new OrbitalObject{bodies.back().get()});
+            orbits.emplace_back(new CircularOrbit{Coordinate(1 + i % 40), chrono::seconds(1 + i % 11), Coordinate(i % 7)});
+            attach(root, objects.back().get(), orbits.back().get());
+            grid.insert(bodies.back().get());
+            indexed.push_back(bodies.back().get());
+        }
+    }
+    Simulation simulation{pool};
+    for(GravityWell *root : roots){
+        simulation.add(root);
+    }
+    vector<MapObject *> expected, found;
+    for(size_t tick = 0; tick < 50; ++tick){
+        simulation.tick();
+        for(Position center : {Position{Coordinate{0}, Coordinate{0}}, Position{Coordinate{60}, Coordinate{0}}, Position{Coordinate{30}, Coordinate{10}}}){
+            brute_within(indexed, nullptr, center, Coordinate{25}, expected);
+            grid.within(center, Coordinate{25}, found);
+            check(same_objects(expected, found), "a grid shared by two roots finds the objects at their positions after the tick");
+        }
+    }
+    check(grid.size() == indexed.size(), "a grid shared by two roots keeps every object");
+    pool.stop();
+}
+
+int main(){
+    random_operations(nullptr);
+    AbsolutePosition anchor{Position{Coordinate{100}, Coordinate{50}}};
+    random_operations(&anchor);
+    simulation_with_shared_grid();
+    return test_result();
+}
@@ -0,0 +1,165 @@
+///
+/// \file contains the tests of TaskGraph
+///
+
+#include "Check.h"
+#include "TaskGraph.h"
+
+#include <atomic>
+#include <future>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace Game;
+using namespace std;
+
+// clear() destroys queued nodes, which never enable their successors, so the run reports broken_promise instead of success
+static void clear_nodes(){
+    FixedThreadPool pool{1};
+    pool.start();
+    atomic<bool> started{false}, release{false};
+    // keeps the only worker busy, so the calling thread runs the first node and the others stay queued
+    pool.submit([&started, &release](){
+        started = true;
+        while(!release){
+            this_thread::yield();
+        }
+    });
+    while(!started){
+        this_thread::yield();
+    }
+    TaskGraph graph;
+    atomic<size_t> successor_count{0};
+    for(size_t i = 0; i < 3; ++i){
+        TaskGraph::Node root = graph.add([&pool](){
+            pool.clear();
+        });
+        TaskGraph::Node successor = graph.add([&successor_count](){
+            ++successor_count;
+        });
+        graph.precede(root, successor);
+    }
+    bool broken = false;
+    try{
+        graph.run(pool);
+    }catch(const future_error &error){
+        broken = error.code() == future_errc::broken_promise;
+    }
+    check(broken, "a run with cleared nodes receives broken_promise");
+    check(successor_count == 1, "only the successor of the node that ran is called");
+    release = true;
+    check(pool.wait_idle(), "the pool is idle after clear()");
+
+    // nothing is cleared the next time, so the same graph runs completely
+    TaskGraph next;
+    atomic<size_t> called_count{0};
+    TaskGraph::Node first = next.add([&called_count](){
+        ++called_count;
+    });
+    for(size_t i = 0; i < 8; ++i){
+        next.precede(first, next.add([&called_count](){
+            ++called_count;
+        }));
+    }
+    bool completed = true;
+    try{
+        next.run(pool);
+        next.run(pool);
+    }catch(...){
+        completed = false;
+    }
+    check(completed && called_count == 18, "a graph without cleared nodes runs every node on every run");
+    pool.stop();
+}
+
+// the order in which the nodes of a graph started and finished, stamped from one counter shared by all threads
+struct Stamps{
+    explicit Stamps(size_t node_count) : clock(0), started(node_count), finished(node_count), run_counts(node_count){
+    }
+
+    atomic<size_t> clock;
+    vector<size_t> started;
+    vector<size_t> finished;
+    vector<size_t> run_counts;
+};
+
+static TaskGraph::Node stamped_node(TaskGraph &graph, Stamps &stamps){
+    TaskGraph::Node node = graph.size();
+    return graph.add([&stamps, node](){
+        stamps.started[node] = ++stamps.clock;
+        ++stamps.run_counts[node];
+        // gives the other workers a chance to start nodes that are not ordered after this one
+        for(size_t i = 0; i < 10; ++i){
+            this_thread::yield();
+        }
+        stamps.finished[node] = ++stamps.clock;
+    });
+}
+
+// every successor starts after all of its predecessors finished, also in a diamond, a wide fan in and a random graph, every time the graph runs
+static void dependency_order(){
+    FixedThreadPool pool{4};
+    pool.start();
+    const size_t node_count = 4 + 34 + 64;
+    Stamps stamps{node_count};
+    TaskGraph graph;
+    vector<pair<TaskGraph::Node, TaskGraph::Node>> edges;
+    auto precede = [&graph, &edges](TaskGraph::Node before, TaskGraph::Node after){
+        graph.precede(before, after);
+        edges.emplace_back(before, after);
+    };
+    // a diamond
+    TaskGraph::Node top = stamped_node(graph, stamps), left = stamped_node(graph, stamps), right = stamped_node(graph, stamps), bottom = stamped_node(graph, stamps);
+    precede(top, left);
+    precede(top, right);
+    precede(left, bottom);
+    precede(right, bottom);
+    // a wide fan out followed by a wide fan in
+    TaskGraph::Node source = stamped_node(graph, stamps);
+    vector<TaskGraph::Node> middle;
+    for(size_t i = 0; i < 32; ++i){
+        middle.push_back(stamped_node(graph, stamps));
+        precede(source, middle.back());
+    }
+    TaskGraph::Node sink = stamped_node(graph, stamps);
+    for(TaskGraph::Node node : middle){
+        precede(node, sink);
+    }
+    // a random graph, edges only point to later nodes so there is no cycle
+    vector<TaskGraph::Node> random_nodes;
+    for(size_t i = 0; i < 64; ++i){
+        random_nodes.push_back(stamped_node(graph, stamps));
+    }
+    mt19937 random{7};
+    bernoulli_distribution has_edge{0.1};
+    for(size_t i = 0; i < random_nodes.size(); ++i){
+        for(size_t j = i + 1; j < random_nodes.size(); ++j){
+            if(has_edge(random)){
+                precede(random_nodes[i], random_nodes[j]);
+            }
+        }
+    }
+    check(graph.size() == node_count, "every node is added to the graph");
+    for(size_t run = 1; run <= 3; ++run){
+        graph.run(pool);
+        bool ordered = true;
+        for(const pair<TaskGraph::Node, TaskGraph::Node> &edge : edges){
+            ordered = ordered && stamps.finished[edge.first] < stamps.started[edge.second];
+        }
+        check(ordered, "a node starts after all of its predecessors finished");
+        bool once = true;
+        for(size_t count : stamps.run_counts){
+            once = once && count == run;
+        }
+        check(once, "every run of a graph runs every node once");
+    }
+    pool.stop();
+}
+
+int main(){
+    dependency_order();
+    clear_nodes();
+    return test_result();
+}
@@ -0,0 +1,772 @@
+///
+/// \file contains the tests of FixedThreadPool
+///
+
+#include "Arena.h"
+#include "Check.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace Game;
+using namespace std;
+
+// clear() destroys a queued task whose promise then breaks, the continuation of its future submits to the same pool
+static void clear_with_continuations(FixedThreadPool::Scheduling scheduling){
+    FixedThreadPool pool{1, scheduling};
+    pool.start();
+    atomic<bool> release{false};
+    // keeps the only worker busy, so the next tasks stay queued
+    pool.submit([&release](){
+        while(!release){
+            this_thread::yield();
+        }
+    });
+    Future<int> cleared = pool.submit_async([](){
+        return 1;
+    });
+    atomic<bool> called{false};
+    Future<int> continued = cleared.then(pool, [&called](int value){
+        called = true;
+        return value + 1;
+    });
+    pool.clear();
+    release = true;
+    bool broken = false;
+    try{
+        continued.get();
+    }catch(const future_error &error){
+        broken = error.code() == future_errc::broken_promise;
+    }
+    check(broken, "the continuation of a cleared task receives broken_promise");
+    check(!called, "the continuation function of a cleared task is not called");
+    check(pool.wait_idle(), "the pool is idle after clear()");
+    pool.stop();
+}
+
+// a work stealing pool submits to the queue of a worker, without workers there is none
+static void work_stealing_without_workers(){
+    bool rejected = false;
+    try{
+        FixedThreadPool pool{0, FixedThreadPool::Scheduling::WORK_STEALING};
+    }catch(const invalid_argument &){
+        rejected = true;
+    }
+    check(rejected, "a work stealing pool without workers is rejected");
+}
+
+// the chunks of a reduction to bool write their results concurrently, each to its own memory location
+static void parallel_reduce_bool(){
+    FixedThreadPool pool{4};
+    pool.start();
+    for(size_t attempt = 0; attempt < 100; ++attempt){
+        bool all = pool.parallel_reduce(size_t{0}, size_t{4096}, true, [](size_t index){
+            return index < 4096;
+        }, [](bool first, bool second){
+            return first && second;
+        }, 16);
+        check(all, "every chunk of a reduction to bool keeps its result");
+    }
+    pool.stop();
+}
+
+// the chunk results of a reduction over a range that does not start at zero and is not a multiple of the grain add up to the whole range
+static void parallel_reduce_sum(FixedThreadPool::Scheduling scheduling){
+    FixedThreadPool pool{4, scheduling};
+    pool.start();
+    size_t begin = 3, end = 1001;
+    size_t expected = (begin + end - 1) * (end - begin) / 2;
+    for(size_t attempt = 0; attempt < 20; ++attempt){
+        size_t sum = pool.parallel_reduce(begin, end, size_t{0}, [](size_t index){
+            return index;
+        }, [](size_t first, size_t second){
+            return first + second;
+        }, 16);
+        check(sum == expected, "a reduction sums every index of its range once");
+    }
+    pool.stop();
+}
+
+// parallel_for() and submit_all() call their function once for every index, none is skipped or repeated
+static void bulk_calls_once(FixedThreadPool::Scheduling scheduling){
+    FixedThreadPool pool{4, scheduling};
+    pool.start();
+    size_t begin = 3, end = 1001;
+    vector<atomic<size_t>> counts(end);
+    pool.parallel_for(begin, end, [&counts](size_t index){
+        ++counts[index];
+    }, 16);
+    bool once = true;
+    for(size_t index = 0; index < end; ++index){
+        once = once && counts[index] == (index < begin ? 0 : 1);
+    }
+    check(once, "parallel_for() calls the function once for every index of its range");
+
+    vector<atomic<size_t>> submitted(1000);
+    vector<function<void()>> tasks;
+    for(size_t index = 0; index < submitted.size(); ++index){
+        tasks.push_back([&submitted, index](){
+            ++submitted[index];
+        });
+    }
+    pool.submit_all(tasks.begin(), tasks.end());
+    check(pool.wait_idle(), "the pool is idle after the tasks of submit_all()");
+    once = true;
+    for(atomic<size_t> &count : submitted){
+        once = once && count == 1;
+    }
+    check(once, "submit_all() runs every task once");
+    pool.stop();
+}
+
+// clear() destroys queued tasks of a group and chunks of a parallel call, which still have to finish
+static void clear_group_tasks(){
+    FixedThreadPool pool{1};
+    pool.start();
+    atomic<bool> release{false};
+    // keeps the only worker busy, so the next tasks stay queued
+    pool.submit([&release](){
+        while(!release){
+            this_thread::yield();
+        }
+    });
+    TaskGroup group;
+    atomic<bool> called{false};
+    pool.submit(group, [&called](){
+        called = true;
+    });
+    pool.clear();
+    check(group.wait_for(chrono::seconds(10)), "a cleared task of a group finishes");
+    check(!called, "a cleared task of a group is not called");
+    bool broken = false;
+    try{
+        // the calling thread runs the first chunk, which clears the others before they can run
+        pool.parallel_for(0, 4, [&pool](size_t index){
+            if(index == 0){
+                pool.clear();
+            }
+        }, 1);
+    }catch(const future_error &error){
+        broken = error.code() == future_errc::broken_promise;
+    }
+    check(broken, "a parallel call with cleared chunks receives broken_promise");
+    release = true;
+    check(pool.wait_idle(), "the pool is idle after clear()");
+    pool.stop();
+}
+
+// the tasks destroyed by clear() are recycled like executed tasks, so repeated clearing does not allocate
+static void clear_recycles_tasks(){
+    FixedThreadPool pool{1};
+    pool.start();
+    size_t warm_count = 0;
+    for(size_t cycle = 0; cycle < 700; ++cycle){
+        // every cycle moves the executed task into the cache of the worker, which keeps up to two batches before returning tasks
+        if(cycle == 200){
+            warm_count = pool.task_allocation_count();
+        }
+        atomic<bool> started{false}, release{false};
+        // keeps the only worker busy, so the next tasks stay queued
+        pool.submit([&started, &release](){
+            started = true;
+            while(!release){
+                this_thread::yield();
+            }
+        });
+        while(!started){
+            this_thread::yield();
+        }
+        TaskGroup group;
+        for(size_t i = 0; i < 64; ++i){
+            pool.submit(group, [](){
+            });
+        }
+        pool.clear();
+        release = true;
+        check(group.wait_for(chrono::seconds(10)), "the cleared tasks of a group finish");
+        check(pool.wait_idle(), "the pool is idle after clear()");
+    }
+    check(pool.task_allocation_count() == warm_count, "clearing a warm pool does not allocate tasks");
+    pool.stop();
+}
+
+// waits until the counter reaches the count, gives up after a while so a broken pool fails the check instead of hanging
+static bool reaches(const atomic<size_t> &counter, size_t count){
+    TimePoint deadline = Clock::now() + chrono::seconds(10);
+    while(counter < count){
+        if(Clock::now() > deadline){
+            return false;
+        }
+        this_thread::yield();
+    }
+    return true;
+}
+
+// a worker queues the tasks it submits itself and takes them from the back, so it runs them last in, first out
+static void own_queue_first(){
+    FixedThreadPool pool{2, FixedThreadPool::Scheduling::WORK_STEALING};
+    pool.start();
+    atomic<size_t> blocked{0}, released{0}, finished{0};
+    // keeps the other worker busy, so it can not steal
+    pool.submit([&blocked, &released](){
+        ++blocked;
+        reaches(released, 1);
+    });
+    check(reaches(blocked, 1), "a blocking task starts");
+    mutex mutex;
+    vector<size_t> order;
+    thread::id parent_thread;
+    bool same_thread = true;
+    pool.submit([&](){
+        parent_thread = this_thread::get_id();
+        for(size_t child = 0; child < 8; ++child){
+            pool.submit([&, child](){
+                lock_guard<std::mutex> lock{mutex};
+                order.push_back(child);
+                same_thread = same_thread && this_thread::get_id() == parent_thread;
+                ++finished;
+            });
+        }
+    });
+    check(reaches(finished, 8), "a worker runs the tasks in its own queue");
+    released = 1;
+    pool.wait_idle();
+    pool.stop();
+    check(same_thread, "tasks submitted by a worker run on that worker while the others are busy");
+    check(order == vector<size_t>({7, 6, 5, 4, 3, 2, 1, 0}), "a worker runs its own tasks last in, first out");
+}
+
+// a worker that blocks after queueing tasks leaves them to the other workers, which steal them
+static void stolen_tasks(){
+    FixedThreadPool pool{2, FixedThreadPool::Scheduling::WORK_STEALING};
+    pool.start();
+    const size_t child_count = 16;
+    atomic<size_t> finished{0}, stolen{0};
+    atomic<bool> all_finished{false};
+    pool.submit([&](){
+        thread::id parent_thread = this_thread::get_id();
+        for(size_t child = 0; child < child_count; ++child){
+            pool.submit([&finished, &stolen, parent_thread](){
+                if(this_thread::get_id() != parent_thread){
+                    ++stolen;
+                }
+                ++finished;
+            });
+        }
+        // does not help, so only a thief can run the children
+        all_finished = reaches(finished, child_count);
+    });
+    pool.wait_idle();
+    pool.stop();
+    check(all_finished, "the tasks queued by a blocked worker finish");
+    check(stolen == child_count, "the tasks queued by a blocked worker are stolen by the other workers");
+}
+
+// tasks with the same affinity key are queued at the same worker, which runs its own queue before stealing
+static void near_tasks(){
+    FixedThreadPool pool{2, FixedThreadPool::Scheduling::WORK_STEALING};
+    pool.start();
+    atomic<size_t> blocked{0}, released[2];
+    for(atomic<size_t> &release : released){
+        release = 0;
+    }
+    // both workers are blocked while the near tasks are queued
+    for(size_t gate = 0; gate < 2; ++gate){
+        pool.submit([&blocked, &released, gate](){
+            ++blocked;
+            reaches(released[gate], 1);
+        });
+    }
+    check(reaches(blocked, 2), "both workers are blocked");
+    const size_t task_count = 8;
+    mutex mutex;
+    vector<pair<size_t, size_t>> order;
+    atomic<size_t> finished{0};
+    for(size_t key = 0; key < 2; ++key){
+        for(size_t index = 0; index < task_count; ++index){
+            pool.submit_near(key, [&, key, index](){
+                lock_guard<std::mutex> lock{mutex};
+                order.emplace_back(key, index);
+                ++finished;
+            });
+        }
+    }
+    // one worker runs its own near tasks, then steals those of the blocked worker
+    released[0] = 1;
+    check(reaches(finished, 2 * task_count), "the near tasks finish while one worker is blocked");
+    released[1] = 1;
+    pool.wait_idle();
+    pool.stop();
+    bool grouped = order.size() == 2 * task_count;
+    for(size_t i = 0; grouped && i < task_count; ++i){
+        // own tasks from the back, stolen tasks from the front
+        grouped = order[i] == make_pair(order[0].first, task_count - 1 - i) && order[task_count + i] == make_pair(1 - order[0].first, i);
+    }
+    check(grouped, "tasks with the same affinity key are queued at the same worker");
+}
+
+// workers that submit to their own queue while other workers steal from it never see a queued count below zero
+static void local_submit_counts(){
+    FixedThreadPool pool{2, FixedThreadPool::Scheduling::WORK_STEALING};
+    pool.start();
+    const size_t child_count = 2000;
+    atomic<size_t> finished{0};
+    for(size_t root = 0; root < 2; ++root){
+        pool.submit([&pool, &finished, child_count](){
+            for(size_t child = 0; child < child_count; ++child){
+                pool.submit([&finished](){
+                    ++finished;
+                });
+            }
+            ++finished;
+        });
+    }
+    size_t deepest = 0;
+    while(finished < 2 * child_count + 2){
+        deepest = max(deepest, pool.queue_depth(TaskPriority::FRAME_CRITICAL));
+        this_thread::yield();
+    }
+    pool.wait_idle();
+    check(deepest <= 2 * child_count, "the queue depth never exceeds the amount of submitted tasks");
+    check(pool.queue_depth(TaskPriority::FRAME_CRITICAL) == 0, "the queue depth of an idle work stealing pool is zero");
+    pool.stop();
+}
+
+// the lanes of the tasks in the order a single worker runs them, every task is queued before the worker starts
+static string lane_order(FixedThreadPool::Scheduling scheduling, size_t critical_burst, const string &lanes){
+    FixedThreadPool pool{1, scheduling};
+    pool.critical_burst(critical_burst);
+    mutex mutex;
+    string order;
+    for(char lane : lanes){
+        pool.submit([&mutex, &order, lane](){
+            lock_guard<std::mutex> lock{mutex};
+            order.push_back(lane);
+        }, lane == 'C' ? TaskPriority::FRAME_CRITICAL : TaskPriority::BACKGROUND);
+    }
+    pool.start();
+    pool.wait_idle();
+    pool.stop();
+    return order;
+}
+
+static void priority_lanes(FixedThreadPool::Scheduling scheduling){
+    check(lane_order(scheduling, 0, "BBCCCBC") == "CCCCBBB", "frame critical tasks run before background tasks");
+    check(lane_order(scheduling, 2, "BBCCCCCC") == "CCBCCBCC", "a background task runs after a burst of frame critical tasks");
+    check(lane_order(scheduling, 2, "CCCCC") == "CCCCC", "frame critical tasks run without background tasks");
+    check(lane_order(scheduling, 1, "CCCCBB") == "CBCBCC", "a burst of one alternates the lanes");
+}
+
+// timers expire in the order of their due times, also when they are due beyond the first level of the wheel
+static void timer_order(){
+    FixedThreadPool pool{1};
+    pool.start();
+    mutex mutex;
+    vector<int> order;
+    TimePoint start = Clock::now();
+    int delays[] = {130, 10, 70, 40, 100};
+    for(int i = 0; i < 5; ++i){
+        pool.submit_at(start + chrono::milliseconds(delays[i]), [&mutex, &order, i](){
+            lock_guard<std::mutex> lock{mutex};
+            order.push_back(i);
+        });
+    }
+    this_thread::sleep_until(start + chrono::milliseconds(200));
+    check(pool.wait_idle(), "the pool is idle after its timers expired");
+    lock_guard<std::mutex> lock{mutex};
+    check(order == vector<int>{1, 3, 2, 4, 0}, "timers expire in the order of their due times");
+    pool.stop();
+}
+
+static void timer_cancel(){
+    FixedThreadPool pool{1};
+    pool.start();
+    atomic<int> delayed_runs{0}, ran_runs{0}, periodic_runs{0};
+    TimerHandle delayed = pool.submit_after(chrono::milliseconds(30), [&delayed_runs](){
+        ++delayed_runs;
+    });
+    check(delayed.active(), "a pending timer is active");
+    check(delayed.cancel(), "a pending timer is cancelled");
+    check(!delayed.active(), "a cancelled timer is not active");
+    check(!delayed.cancel(), "a timer is only cancelled once");
+
+    TimerHandle ran = pool.submit_after(chrono::milliseconds(1), [&ran_runs](){
+        ++ran_runs;
+    });
+    TimerHandle periodic = pool.submit_every(chrono::milliseconds(5), [&periodic_runs](){
+        ++periodic_runs;
+    });
+    while(ran_runs == 0 || periodic_runs < 3){
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    check(!ran.cancel(), "a timer whose task already ran is not cancelled");
+    check(periodic.cancel(), "a periodic timer is cancelled");
+    // a run submitted before the cancel may still be queued
+    check(pool.wait_idle(), "the pool is idle after the timers are cancelled");
+    int cancelled_runs = periodic_runs;
+    this_thread::sleep_for(chrono::milliseconds(50));
+    check(delayed_runs == 0, "a cancelled timer does not run");
+    check(ran_runs == 1, "a one shot timer runs once");
+    check(periodic_runs == cancelled_runs, "a cancelled periodic timer does not run again");
+    pool.stop();
+}
+
+// a long action stalls the wheel, afterwards a periodic timer runs once for the missed runs and then keeps its phase
+static void timer_phase_after_stall(){
+    const Duration period = chrono::milliseconds(50);
+    TimerWheel wheel;
+    TimePoint start = Clock::now();
+    mutex mutex;
+    vector<TimePoint> runs;
+    TimePoint stall_end;
+    TimerHandle periodic = wheel.schedule(start + period, period, [&mutex, &runs](){
+        lock_guard<std::mutex> lock{mutex};
+        runs.push_back(Clock::now());
+    });
+    wheel.schedule(start + chrono::milliseconds(60), Duration::zero(), [&mutex, &stall_end](){
+        this_thread::sleep_for(chrono::milliseconds(175));
+        lock_guard<std::mutex> lock{mutex};
+        stall_end = Clock::now();
+    });
+    this_thread::sleep_until(start + chrono::milliseconds(500));
+    periodic.cancel();
+    lock_guard<std::mutex> lock{mutex};
+    // the first due time after the stall
+    TimePoint next_due = start + period * ((stall_end - start) / period + 1);
+    size_t missed_runs = 0;
+    TimePoint next_run;
+    for(TimePoint run : runs){
+        if(run >= stall_end && run < next_due){
+            ++missed_runs;
+        }else if(run >= next_due && next_run == TimePoint{}){
+            next_run = run;
+        }
+    }
+    check(missed_runs <= 1, "a periodic timer runs at most once for the runs it missed during a stall");
+    check(next_run != TimePoint{} && next_run < next_due + period / 2, "a periodic timer keeps its phase after a stall");
+}
+
+// a sample of 2^(i-1)ns up to 2^i ns goes to bucket i and a percentile is estimated with the upper bound of its bucket
+static void latency_buckets(){
+    LatencyHistogram histogram;
+    for(long long nanoseconds : {-5LL, 0LL, 1LL, 3LL, 1000LL}){
+        histogram.record(chrono::nanoseconds(nanoseconds));
+    }
+    LatencyDistribution distribution = histogram.snapshot();
+    check(distribution.count == 5 && distribution.counts[0] == 2 && distribution.counts[1] == 1 && distribution.counts[2] == 1 && distribution.counts[10] == 1, "latency samples go to the bucket of their power of two");
+    check(distribution.maximum == chrono::nanoseconds(1000) && distribution.mean() == chrono::nanoseconds(200), "negative latency samples count as zero");
+    check(distribution.percentile(0.5) == chrono::nanoseconds(2), "a percentile is the upper bound of its bucket");
+    check(distribution.percentile(0.99) == chrono::nanoseconds(1000), "a percentile does not exceed the longest sample");
+    histogram.reset();
+    check(histogram.snapshot().count == 0, "a reset histogram has no samples");
+}
+
+// every task is counted once when it is submitted and once when it is executed, on a worker or on the waiting caller
+static void pool_statistics(FixedThreadPool::Scheduling scheduling){
+    FixedThreadPool pool{2, scheduling};
+    pool.collect_timings(true);
+    pool.start();
+    for(size_t index = 0; index < 100; ++index){
+        pool.submit([](){
+        }, index % 2 == 0 ? TaskPriority::FRAME_CRITICAL : TaskPriority::BACKGROUND);
+    }
+    pool.parallel_for(0, 64, [](size_t){
+    });
+    pool.wait_idle();
+    ThreadPoolStatistics statistics = pool.statistics();
+    check(statistics.submitted_count() == statistics.executed_count() && statistics.executed_count() >= 100, "every submitted task is executed once");
+    check(statistics.execution.count == statistics.executed_count() && statistics.queue_wait.count == statistics.executed_count(), "every task is timed while timings are collected");
+    check(statistics.critical_queue_depth == 0 && statistics.background_queue_depth == 0, "an idle pool has no queued tasks");
+    pool.reset_statistics();
+    statistics = pool.statistics();
+    check(statistics.submitted_count() == 0 && statistics.executed_count() == 0 && statistics.execution.count == 0, "reset_statistics() clears the counters");
+    pool.collect_timings(false);
+    pool.submit([](){
+    });
+    pool.wait_idle();
+    statistics = pool.statistics();
+    check(statistics.executed_count() == 1 && statistics.execution.count == 0, "tasks are counted but not timed without timings");
+    pool.stop();
+}
+
+// workers that spin, yield or park between bursts still wake up for every task, the gaps end inside and after each phase of the policy
+static void idle_policy_bursts(FixedThreadPool::Scheduling scheduling){
+    Duration spin_duration = chrono::microseconds(50), yield_duration = chrono::microseconds(200);
+    FixedThreadPool pool{2, scheduling, IdlePolicy{spin_duration, yield_duration}};
+    pool.start();
+    Duration gaps[] = {Duration::zero(), spin_duration / 2, spin_duration + yield_duration / 2, 2 * (spin_duration + yield_duration), chrono::milliseconds(2)};
+    atomic<size_t> executed{0};
+    size_t submitted = 0;
+    bool all_executed = true;
+    // stops at the first lost burst, every further one would only wait for the deadline again
+    for(size_t round = 0; round < 20 && all_executed; ++round){
+        for(Duration gap : gaps){
+            this_thread::sleep_for(gap);
+            // single tasks wake one worker, larger bursts both
+            size_t burst = round % 2 == 0 ? 1 : 8;
+            for(size_t i = 0; i < burst; ++i){
+                pool.submit([&executed](){
+                    ++executed;
+                });
+            }
+            submitted += burst;
+            // the caller only yields, so a task is executed only if a worker wakes up for it
+            if(!reaches(executed, submitted)){
+                all_executed = false;
+                break;
+            }
+        }
+    }
+    check(all_executed, "idle workers wake up for every burst, whichever phase of the idle policy they are in");
+    pool.stop();
+}
+
+// every placed worker gets its own scratch arena, which is empty again when the next task starts
+static void scratch_arenas(){
+    FixedThreadPool pool{2};
+    WorkerPlacement placement;
+    placement.scratch_capacity = 1024;
+    pool.placement(placement);
+    pool.start();
+    check(pool.scratch() == nullptr, "a thread that is not a worker has no scratch arena");
+    atomic<size_t> failures{0};
+    for(size_t index = 0; index < 100; ++index){
+        pool.submit([&pool, &failures](){
+            ScratchArena *arena = pool.scratch();
+            if(!arena || arena->used() != 0 || arena->capacity() != 1024){
+                ++failures;
+                return;
+            }
+            arena->allocate(512);
+            if(arena->used() < 512){
+                ++failures;
+            }
+        });
+    }
+    pool.wait_idle();
+    pool.stop();
+    check(failures == 0, "a task starts with the whole scratch arena of its worker");
+    placement.scratch_capacity = 0;
+    pool.placement(placement);
+    pool.start();
+    ScratchArena *arena = reinterpret_cast<ScratchArena *>(1);
+    pool.submit([&pool, &arena](){
+        arena = pool.scratch();
+    });
+    pool.wait_idle();
+    pool.stop();
+    check(arena == nullptr, "a placement without scratch memory takes effect when the pool is restarted");
+}
+
+#ifdef __linux__
+// a worker pinned to a single CPU only runs on that CPU
+static void pinned_workers(){
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+        return;
+    }
+    unsigned int cpu = 0;
+    while(cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &allowed)){
+        ++cpu;
+    }
+    if(cpu == CPU_SETSIZE){
+        return;
+    }
+    FixedThreadPool pool{1};
+    pool.placement(WorkerPlacement::cores({cpu}));
+    pool.start();
+    atomic<bool> pinned{true};
+    for(size_t index = 0; index < 20; ++index){
+        pool.submit([&pinned, cpu](){
+            if(sched_getcpu() != static_cast<int>(cpu)){
+                pinned = false;
+            }
+        });
+    }
+    pool.wait_idle();
+    pool.stop();
+    check(pinned, "a worker pinned to a CPU runs on that CPU");
+}
+#endif
+
+// submits five tasks with mixed priorities, three of which submit a nested task, and runs what is pending on the calling thread
+// inline: every submit returns after its task ran, submitted_in_order is cleared if one did not
+static string replay(FixedThreadPool &pool, size_t &run_count, bool &submitted_in_order){
+    string order;
+    submitted_in_order = true;
+    for(size_t i = 0; i < 5; ++i){
+        pool.submit([&pool, &order, i](){
+            order.push_back(static_cast<char>('a' + i));
+            if(i % 2 == 0){
+                pool.submit([&order, i](){
+                    order.push_back(static_cast<char>('A' + i));
+                }, i % 4 == 0 ? TaskPriority::BACKGROUND : TaskPriority::FRAME_CRITICAL);
+            }
+        }, i % 3 == 0 ? TaskPriority::BACKGROUND : TaskPriority::FRAME_CRITICAL);
+        submitted_in_order = submitted_in_order && order.find(static_cast<char>('a' + i)) != string::npos;
+    }
+    run_count = pool.run_pending();
+    return order;
+}
+
+// a deterministic pool runs tasks in submission order, whatever their priority, the same way every time
+static void deterministic_replay(){
+    size_t run_count;
+    bool submitted_in_order;
+    string orders[2];
+    for(string &order : orders){
+        FixedThreadPool pool{4, FixedThreadPool::Scheduling::DETERMINISTIC};
+        pool.start();
+        order = replay(pool, run_count, submitted_in_order);
+        check(run_count == 8, "run_pending() returns the amount of tasks it ran, including nested tasks");
+        check(pool.run_pending() == 0, "run_pending() returns zero without pending tasks");
+        check(pool.thread_count() == 0, "a deterministic pool has no workers");
+        pool.stop();
+    }
+    check(orders[0] == "abcdeACE", "a deterministic pool runs tasks in submission order in a single lane");
+    check(orders[0] == orders[1], "two runs of a deterministic pool run the tasks in the same order");
+    FixedThreadPool stopped{4, FixedThreadPool::Scheduling::DETERMINISTIC};
+    check(replay(stopped, run_count, submitted_in_order) == orders[0] && run_count == 8, "a stopped deterministic pool runs its scheduled tasks in the same order");
+}
+
+// an inline pool runs every task before submit returns, nested tasks run inside the task that submitted them
+static void inline_replay(){
+    size_t run_count;
+    bool submitted_in_order;
+    string orders[2];
+    for(string &order : orders){
+        FixedThreadPool pool{4, FixedThreadPool::Scheduling::INLINE};
+        pool.start();
+        order = replay(pool, run_count, submitted_in_order);
+        check(submitted_in_order, "an inline pool runs a task before submit returns");
+        check(run_count == 0, "an inline pool leaves no tasks pending");
+        check(pool.wait_idle(), "a running inline pool is idle");
+        pool.stop();
+    }
+    check(orders[0] == "aAbcCdeE", "an inline pool runs nested tasks inside the task that submitted them");
+    check(orders[0] == orders[1], "two runs of an inline pool run the tasks in the same order");
+    // a stopped inline pool schedules its tasks, run_pending() takes them by priority
+    FixedThreadPool stopped{4, FixedThreadPool::Scheduling::INLINE};
+    string order = replay(stopped, run_count, submitted_in_order);
+    check(!submitted_in_order, "a stopped inline pool does not run tasks when they are submitted");
+    check(order == "bceCadEA" && run_count == 8, "a stopped inline pool runs its scheduled tasks by priority with run_pending()");
+}
+
+// waits until the pool runs the amount of workers, gives up after a while like reaches()
+static bool reaches_thread_count(const FixedThreadPool &pool, size_t count){
+    TimePoint deadline = Clock::now() + chrono::seconds(10);
+    while(pool.statistics().thread_count != count){
+        if(Clock::now() > deadline){
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// an elastic pool grows to its maximum while tasks wait and shrinks back to its minimum once its workers are idle
+static void elastic_growth(FixedThreadPool::Scheduling scheduling){
+    ElasticThreadPool pool{1, 3, chrono::milliseconds(1), chrono::milliseconds(50), scheduling};
+    pool.start();
+    check(pool.statistics().thread_count == 1, "an elastic pool starts its minimum amount of workers");
+    atomic<size_t> started{0}, released{0};
+    for(size_t i = 0; i < 6; ++i){
+        pool.submit([&started, &released](){
+            ++started;
+            reaches(released, 1);
+        });
+    }
+    check(reaches_thread_count(pool, 3), "an elastic pool adds workers while tasks wait");
+    check(reaches(started, 3), "the added workers run the waiting tasks");
+    // several growth thresholds pass while the tasks keep waiting
+    this_thread::sleep_for(chrono::milliseconds(20));
+    check(pool.statistics().thread_count == 3 && started == 3, "an elastic pool does not grow beyond its maximum");
+    released = 1;
+    check(pool.wait_idle() && started == 6, "an elastic pool runs every task");
+    check(reaches_thread_count(pool, 1), "idle workers of an elastic pool retire");
+    // several retire timeouts pass while the pool is idle
+    this_thread::sleep_for(chrono::milliseconds(200));
+    check(pool.statistics().thread_count == 1, "an elastic pool keeps its minimum amount of workers");
+    // the pressure check lapsed while the pool was idle, queueing tasks again arms it
+    released = 0;
+    for(size_t i = 0; i < 3; ++i){
+        pool.submit([&started, &released](){
+            ++started;
+            reaches(released, 1);
+        });
+    }
+    check(reaches_thread_count(pool, 3), "an idle elastic pool grows again when tasks wait");
+    released = 1;
+    check(pool.wait_idle() && started == 9, "an elastic pool that grew again runs every task");
+    pool.stop();
+    check(pool.statistics().thread_count == 0, "a stopped pool has no workers");
+}
+
+// an elastic pool without a minimum retires all of its workers and starts one again when a task is submitted
+static void elastic_without_minimum(FixedThreadPool::Scheduling scheduling){
+    ElasticThreadPool pool{0, 2, chrono::milliseconds(1), chrono::milliseconds(20), scheduling};
+    pool.start();
+    check(pool.statistics().thread_count == 0, "an elastic pool without a minimum starts without workers");
+    for(size_t round = 0; round < 2; ++round){
+        atomic<size_t> ran{0};
+        pool.submit([&ran](){
+            ++ran;
+        });
+        check(reaches(ran, 1), "a task submitted to an elastic pool without workers runs");
+        check(reaches_thread_count(pool, 0), "every worker of an elastic pool without a minimum retires");
+    }
+    pool.stop();
+}
+
+int main(){
+    clear_with_continuations(FixedThreadPool::Scheduling::SHARED_QUEUE);
+    clear_with_continuations(FixedThreadPool::Scheduling::WORK_STEALING);
+    work_stealing_without_workers();
+    parallel_reduce_bool();
+    parallel_reduce_sum(FixedThreadPool::Scheduling::SHARED_QUEUE);
+    parallel_reduce_sum(FixedThreadPool::Scheduling::WORK_STEALING);
+    bulk_calls_once(FixedThreadPool::Scheduling::SHARED_QUEUE);
+    bulk_calls_once(FixedThreadPool::Scheduling::WORK_STEALING);
+    clear_group_tasks();
+    clear_recycles_tasks();
+    own_queue_first();
+    stolen_tasks();
+    near_tasks();
+    local_submit_counts();
+    priority_lanes(FixedThreadPool::Scheduling::SHARED_QUEUE);
+    priority_lanes(FixedThreadPool::Scheduling::WORK_STEALING);
+    timer_order();
+    timer_cancel();
+    timer_phase_after_stall();
+    latency_buckets();
+    pool_statistics(FixedThreadPool::Scheduling::SHARED_QUEUE);
+    pool_statistics(FixedThreadPool::Scheduling::WORK_STEALING);
+    idle_policy_bursts(FixedThreadPool::Scheduling::SHARED_QUEUE);
+    idle_policy_bursts(FixedThreadPool::Scheduling::WORK_STEALING);
+    elastic_growth(FixedThreadPool::Scheduling::SHARED_QUEUE);
+    elastic_growth(FixedThreadPool::Scheduling::WORK_STEALING);
+    elastic_without_minimum(FixedThreadPool::Scheduling::SHARED_QUEUE);
+    elastic_without_minimum(FixedThreadPool::Scheduling::WORK_STEALING);
+    deterministic_replay();
+    inline_replay();
+    scratch_arenas();
+#ifdef __linux__
+    pinned_workers();
+#endif
+    return test_result();
+}